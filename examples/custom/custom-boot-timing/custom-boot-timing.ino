@@ -0,0 +1,59 @@
+/**
+ * @brief Measures the start of the Lyrat Mini codecs (ES8311 and ES7243)
+ * without any hardware: the chips are simulated with a ControlBusMock. The
+ * reset wait of the ES8311 overlaps with the mclk pulses of the ES7243 when
+ * both are started with the AudioDriverBootScheduler, so the interleaved
+ * start needs less time than the sequential one.
+ * @author phil schatzmann
+ */
+
+#include "AudioBoard.h"
+
+ControlBusMock bus;
+AudioDriverES8311Class dac;
+AudioDriverES7243Class adc;
+CodecConfig cfg;
+
+// starts the driver with beginAsync() and waits for the result
+bool beginSequential(AudioDriver &driver) {
+  driver.beginAsync(cfg, NoPins);
+  PollResult result;
+  while ((result = driver.poll()) == PollResult::Pending) {
+    int32_t wait_ms = driver.getWakeUpTime() - millis();
+    if (wait_ms > 0) delay(wait_ms);
+  }
+  return result == PollResult::Done;
+}
+
+void setup() {
+  // Setup logging
+  Serial.begin(115200);
+  LOGLEVEL_AUDIODRIVER = AudioDriverWarning;
+
+  // simulated codecs
+  bus.addDevice(0x18);
+  bus.addDevice(0x13);
+  dac.setControlBus(bus);
+  adc.setControlBus(bus);
+
+  uint32_t start = millis();
+  bool ok = beginSequential(dac) && beginSequential(adc);
+  uint32_t sequential_ms = millis() - start;
+
+  AudioDriverBootScheduler scheduler;
+  scheduler.add(dac, cfg, NoPins);
+  scheduler.add(adc, cfg, NoPins);
+  start = millis();
+  ok = scheduler.begin() && ok;
+  uint32_t interleaved_ms = millis() - start;
+
+  Serial.print("sequential: ");
+  Serial.print(sequential_ms);
+  Serial.print(" ms, interleaved: ");
+  Serial.print(interleaved_ms);
+  Serial.println(" ms");
+  Serial.println(ok && interleaved_ms < sequential_ms ? "overlap ok"
+                                                      : "overlap error");
+}
+
+void loop() {}
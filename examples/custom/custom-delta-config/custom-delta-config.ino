@@ -0,0 +1,61 @@
+/**
+ * @brief Checks the register sequence of setConfig() in delta mode without
+ * any hardware: the ES8388 is simulated with a ControlBusMock which records
+ * the writes. The DAC and ADC must be powered down before the changed
+ * registers are written and powered up again at the end.
+ * @author phil schatzmann
+ */
+
+#include "AudioBoard.h"
+
+ControlBusMock bus;
+AudioDriverES8388Class es8388;
+i2c_reg_value_t writes[64];
+
+// position of the first write to reg after pos (-1: not written)
+int findWrite(uint8_t reg, int pos = 0) {
+  for (int j = pos; j < bus.writeLogCount(); j++) {
+    if (writes[j].reg == reg) return j;
+  }
+  return -1;
+}
+
+void setup() {
+  // Setup logging
+  Serial.begin(115200);
+  LOGLEVEL_AUDIODRIVER = AudioDriverWarning;
+
+  // simulated codec
+  bus.addDevice(ES8388_ADDR);
+  es8388.setControlBus(bus);
+  es8388.setDeltaConfigActive(true);
+
+  CodecConfig cfg;
+  cfg.input_device = ADC_INPUT_LINE1;
+  cfg.output_device = DAC_OUTPUT_ALL;
+  cfg.i2s.mode = MODE_SLAVE;
+  es8388.begin(cfg, NoPins);
+
+  // change the clock mode and record the writes
+  bus.setWriteLog(writes, 64);
+  cfg.i2s.mode = MODE_MASTER;
+  es8388.setConfig(cfg);
+
+  for (int j = 0; j < bus.writeLogCount(); j++) {
+    Serial.print("0x");
+    Serial.print(writes[j].reg, HEX);
+    Serial.print(" = 0x");
+    Serial.println(writes[j].value, HEX);
+  }
+
+  int power_down = findWrite(ES8388_DACPOWER);
+  int adc_down = findWrite(ES8388_ADCPOWER);
+  int clock = findWrite(ES8388_MASTERMODE);
+  int power_up = clock >= 0 ? findWrite(ES8388_DACPOWER, clock) : -1;
+  bool ok = power_down >= 0 && writes[power_down].value == 0xC0 &&
+            adc_down >= 0 && adc_down < clock && clock > power_down &&
+            power_up > clock;
+  Serial.println(ok ? "sequence ok" : "sequence error");
+}
+
+void loop() {}
@@ -0,0 +1,55 @@
+/**
+ * @brief Checks saveState() and restoreState() without any hardware: the
+ * ES8388 is simulated with a ControlBusMock which records the writes of
+ * begin(). After a simulated reset of the chip every register which was
+ * written by begin() must have its configured value again.
+ * @author phil schatzmann
+ */
+
+#include "AudioBoard.h"
+
+ControlBusMock bus;
+AudioDriverES8388Class es8388;
+i2c_reg_value_t writes[128];
+uint8_t configured[256];
+uint8_t state[256];
+
+void setup() {
+  // Setup logging
+  Serial.begin(115200);
+  LOGLEVEL_AUDIODRIVER = AudioDriverWarning;
+
+  // simulated codec
+  bus.addDevice(ES8388_ADDR);
+  es8388.setControlBus(bus);
+
+  // configure the codec and record the written registers
+  bus.setWriteLog(writes, 128);
+  CodecConfig cfg;
+  cfg.input_device = ADC_INPUT_LINE1;
+  cfg.output_device = DAC_OUTPUT_ALL;
+  es8388.begin(cfg, NoPins);
+  int write_count = bus.writeLogCount();
+  bus.setWriteLog(nullptr, 0);
+  memcpy(configured, bus.registers(ES8388_ADDR), 256);
+
+  // save, reset the chip and restore
+  int size = es8388.saveState(state, sizeof(state));
+  memset(bus.registers(ES8388_ADDR), 0, 256);
+  es8388.restoreState(state, size);
+
+  int errors = 0;
+  uint8_t *restored = bus.registers(ES8388_ADDR);
+  for (int j = 0; j < write_count; j++) {
+    uint8_t reg = writes[j].reg;
+    if (restored[reg] != configured[reg]) {
+      Serial.print("register 0x");
+      Serial.print(reg, HEX);
+      Serial.println(" not restored");
+      errors++;
+    }
+  }
+  Serial.println(size > 0 && errors == 0 ? "restore ok" : "restore error");
+}
+
+void loop() {}
@@ -1,5 +1,9 @@
 #pragma once
 #include "Driver.h"
+#include "AudioDriverAsync.h"
+#include "AudioDriverImage.h"
+#include "AudioDriverScan.h"
+#include "AudioDriverWatchdog.h"
 #include "DriverPins.h"
 
 namespace audio_driver {
@@ -25,6 +29,7 @@ public:
   bool begin(){
     pins->setSPIActiveForSD(codec_cfg.sd_active);
     AD_LOGD("AudioBoard::pins::begin");
+    driver->setupI2CProbe(*pins);
     bool result_pins = pins->begin();
     AD_LOGD("AudioBoard::pins::begin::returned:%s", result_pins ? "true" : "false");
     AD_LOGD("AudioBoard::driver::begin");
@@ -0,0 +1,155 @@
+#pragma once
+#include "Driver.h"
+#include "Utils/CommandQueue.h"
+
+namespace audio_driver {
+
+/// Callback which is called when an asynchronous command has been executed
+typedef void (*async_callback_t)(uint32_t token, bool result, void *ref);
+
+/**
+ * @brief Executes the volume and mute requests of an AudioDriver in a
+ * background task, so that the caller (e.g. the audio loop) never waits for
+ * the I2C bus. Each request returns a token (0 if the queue is full) which
+ * can be checked with isCompleted(); optionally a callback is called with the
+ * result. If no task is supported you need to call process() in the loop().
+ * While the queue is active, the driver should only be accessed via this
+ * class.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AudioDriverAsync {
+ public:
+  AudioDriverAsync(AudioDriver &driver) {
+    p_driver = &driver;
+    for (int j = 0; j < flag_words; j++) completed[j] = 0;
+  }
+
+  /// Starts the background processing
+  bool begin() { return queue.begin(execute, this); }
+  /// Stops the background processing
+  void end() { queue.end(); }
+
+  /// Enqueues AudioDriver::setVolume()
+  uint32_t setVolume(int volume, async_callback_t cb = nullptr,
+                     void *ref = nullptr) {
+    return add(AsyncCmd::Volume, volume, -1, cb, ref);
+  }
+  /// Enqueues AudioDriver::setMute()
+  uint32_t setMute(bool mute, async_callback_t cb = nullptr,
+                   void *ref = nullptr) {
+    return add(AsyncCmd::Mute, mute, -1, cb, ref);
+  }
+  /// Enqueues AudioDriver::setMute() for an individual line
+  uint32_t setMute(bool mute, int line, async_callback_t cb = nullptr,
+                   void *ref = nullptr) {
+    return add(AsyncCmd::MuteLine, mute, line, cb, ref);
+  }
+  /// Enqueues AudioDriver::setInputVolume()
+  uint32_t setInputVolume(int volume, async_callback_t cb = nullptr,
+                          void *ref = nullptr) {
+    return add(AsyncCmd::InputVolume, volume, -1, cb, ref);
+  }
+  /// Enqueues AudioDriver::setPAPower()
+  uint32_t setPAPower(bool enable, async_callback_t cb = nullptr,
+                      void *ref = nullptr) {
+    return add(AsyncCmd::PAPower, enable, -1, cb, ref);
+  }
+
+  /// Returns true if the command with the indicated token has been executed
+  bool isCompleted(uint32_t token) {
+    uint32_t last = next_token;
+    if (token == 0 || (int32_t)(last - token) < 0) return false;
+    // less commands can be pending than the window tracks
+    if (last - token >= token_window) return true;
+    uint32_t pos = token % token_window;
+    return (completed[pos / 32] & (1u << (pos % 32))) != 0;
+  }
+
+  /// Executes the queued commands: only needed if there is no task support
+  void process() { queue.process(); }
+
+  /// Provides the wrapped driver
+  AudioDriver &driver() { return *p_driver; }
+
+ protected:
+  enum class AsyncCmd { Volume, Mute, MuteLine, InputVolume, PAPower };
+  struct Command {
+    AsyncCmd cmd;
+    int value;
+    int line;
+    uint32_t token;
+    async_callback_t cb;
+    void *ref;
+  };
+  AudioDriver *p_driver = nullptr;
+  CommandQueue<Command> queue;
+  // completion flag per token: the commands of several producers can be
+  // queued in a different order than their tokens were allocated
+  static const int flag_words = (4 * ASYNC_QUEUE_SIZE + 31) / 32;
+  static const uint32_t token_window = flag_words * 32;
+  // the requests can be added from different tasks
+#if defined(COMMAND_QUEUE_ATOMIC)
+  std::atomic<uint32_t> next_token{0};
+  std::atomic<uint32_t> completed[flag_words];
+#else
+  uint32_t next_token = 0;
+  volatile uint32_t completed[flag_words];
+#endif
+
+  void setCompleted(uint32_t token, bool done) {
+    uint32_t pos = token % token_window;
+    uint32_t mask = 1u << (pos % 32);
+#if defined(COMMAND_QUEUE_ATOMIC)
+    if (done) {
+      completed[pos / 32].fetch_or(mask);
+    } else {
+      completed[pos / 32].fetch_and(~mask);
+    }
+#else
+    uint32_t flags = completed[pos / 32];
+    completed[pos / 32] = done ? flags | mask : flags & ~mask;
+#endif
+  }
+
+  uint32_t add(AsyncCmd cmd, int value, int line, async_callback_t cb,
+               void *ref) {
+    uint32_t token = ++next_token;
+    // the flag is still set from the token one window earlier
+    setCompleted(token, false);
+    Command command{cmd, value, line, token, cb, ref};
+    if (!queue.push(command)) {
+      AD_LOGW("AudioDriverAsync: queue full");
+      return 0;
+    }
+    return token;
+  }
+
+  static void execute(Command &cmd, void *ref) {
+    AudioDriverAsync *self = (AudioDriverAsync *)ref;
+    AudioDriver *p_driver = self->p_driver;
+    bool result = false;
+    switch (cmd.cmd) {
+      case AsyncCmd::Volume:
+        result = p_driver->setVolume(cmd.value);
+        break;
+      case AsyncCmd::Mute:
+        result = p_driver->setMute(cmd.value);
+        break;
+      case AsyncCmd::MuteLine:
+        result = p_driver->setMute(cmd.value, cmd.line);
+        break;
+      case AsyncCmd::InputVolume:
+        result = p_driver->setInputVolume(cmd.value);
+        break;
+      case AsyncCmd::PAPower:
+        result = p_driver->setPAPower(cmd.value);
+        break;
+    }
+    self->setCompleted(cmd.token, true);
+    if (cmd.cb != nullptr) cmd.cb(cmd.token, result, cmd.ref);
+  }
+};
+
+}  // namespace audio_driver
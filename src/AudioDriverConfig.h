@@ -5,6 +5,35 @@
 #  define DRIVER_DEFAULT_VOLUME 70
 #endif
 
+// AudioDriver::setConfig() writes only the registers which differ from the
+// current state (if supported by the driver): the codec is muted and powered
+// down while the changed registers are written
+#ifndef DRIVER_DELTA_CONFIG
+#  define DRIVER_DELTA_CONFIG false
+#endif
+
+// Max number of entries of the power down sequence of setConfig() in delta mode
+#ifndef DRIVER_POWER_SEQ_MAX
+#  define DRIVER_POWER_SEQ_MAX 8
+#endif
+
+// AudioDriver::begin() skips the initialization if the codec still has the
+// requested configuration (e.g. after a reset of the microcontroller only)
+#ifndef DRIVER_WARM_START
+#  define DRIVER_WARM_START false
+#endif
+
+// Version of the register images of AudioDriver::saveImage(): stored images
+// with a different version are ignored
+#ifndef DRIVER_IMAGE_VERSION
+#  define DRIVER_IMAGE_VERSION 1
+#endif
+
+// Buffer size which is used by the AudioDriverImageStore
+#ifndef DRIVER_IMAGE_MAX_SIZE
+#  define DRIVER_IMAGE_MAX_SIZE 300
+#endif
+
 // To increase the max volume e.g. for ai_thinker (ES8388) 2957 or A202 -> set
 // to 1 or 2 0 AUX volume is LINE level 1 you can control the AUX volume with
 // setVolume()
@@ -30,3 +59,140 @@
 #ifndef FORCE_WIRE_CLOSE
 #  define FORCE_WIRE_CLOSE false
 #endif
+
+// Max number of data bytes which are sent in one I2C auto-increment burst by
+// i2c_bus_write_seq(): must fit into the Wire buffer
+#ifndef I2C_MAX_BURST_LEN
+#  define I2C_MAX_BURST_LEN 16
+#endif
+
+// Max number of bytes which are requested in one I2C read by
+// i2c_bus_read_bytes(): must fit into the Wire buffer
+#ifndef I2C_MAX_READ_LEN
+#  define I2C_MAX_READ_LEN 32
+#endif
+
+// Number of registers (starting at 0) which are kept in the register map
+// (i2c_reg_map_t) of a C driver: higher registers are always accessed on the
+// bus
+#ifndef I2C_REG_CACHE_SIZE
+#  define I2C_REG_CACHE_SIZE 128
+#endif
+
+// Number of register maps which are available for the C drivers: one map is
+// used per device by AC101, ES7210, ES8311, ES8374, ES8388 and TAS5805M
+#ifndef I2C_REG_MAP_COUNT
+#  define I2C_REG_MAP_COUNT 6
+#endif
+
+// Max number of writes which are collected by i2c_bus_run_seq() before they
+// are sent with i2c_bus_write_seq()
+#ifndef I2C_SEQ_BATCH_SIZE
+#  define I2C_SEQ_BATCH_SIZE 32
+#endif
+
+// Max time in ms that an I2C_SEQ_POLL operation waits for the expected value
+#ifndef I2C_SEQ_POLL_TIMEOUT_MS
+#  define I2C_SEQ_POLL_TIMEOUT_MS 100
+#endif
+
+// Join the register address write and the data read of i2c_bus_read_bytes()
+// with a repeated START instead of a STOP/START: set to false if your Wire
+// implementation does not support this properly. Write transactions always
+// end with a STOP.
+#ifndef I2C_REPEATED_START
+#  define I2C_REPEATED_START true
+#endif
+
+// Use register auto-increment bursts for the ES codecs
+#ifndef ES_I2C_AUTO_INCREMENT
+#  define ES_I2C_AUTO_INCREMENT true
+#endif
+
+// The TAS5805M uses the register table which was optimized by
+// tools/reg_optimizer (tas5805m_reg_cfg_opt.h) instead of the vendor script
+#ifndef TAS5805M_OPTIMIZED_REGISTERS
+#  define TAS5805M_OPTIMIZED_REGISTERS true
+#endif
+
+// Use register auto-increment reads for the AC101
+#ifndef AC101_I2C_AUTO_INCREMENT
+#  define AC101_I2C_AUTO_INCREMENT true
+#endif
+
+// Max number of pending commands in the AudioDriverAsync queue
+#ifndef ASYNC_QUEUE_SIZE
+#  define ASYNC_QUEUE_SIZE 16
+#endif
+
+// Stack size and priority of the FreeRTOS task of the AudioDriverAsync queue
+#ifndef ASYNC_TASK_STACK_SIZE
+#  define ASYNC_TASK_STACK_SIZE 4096
+#endif
+
+#ifndef ASYNC_TASK_PRIORITY
+#  define ASYNC_TASK_PRIORITY 1
+#endif
+
+// Max bus time in us per second which is used by the AudioDriverWatchdog and
+// the number of registers which are read back with one request
+#ifndef WATCHDOG_BUDGET_US
+#  define WATCHDOG_BUDGET_US 2000
+#endif
+
+#ifndef WATCHDOG_CHUNK_SIZE
+#  define WATCHDOG_CHUNK_SIZE 8
+#endif
+
+// I2C clock negotiation (PinsI2C::max_frequency): default register which is
+// read to verify a clock (see AudioDriver::getI2CProbeRegister()) and number
+// of checks per clock
+#ifndef I2C_CLOCK_PROBE_REG
+#  define I2C_CLOCK_PROBE_REG 0x00
+#endif
+
+#ifndef I2C_CLOCK_PROBE_COUNT
+#  define I2C_CLOCK_PROBE_COUNT 3
+#endif
+
+// Drop register writes which would not change the last written value (see
+// AudioDriver::setWriteFilterActive())
+#ifndef I2C_WRITE_FILTER
+#  define I2C_WRITE_FILTER false
+#endif
+
+// Retry policy for failed I2C transactions: max number of retries, the wait
+// before the first retry (doubled for each further retry) and the hard
+// deadline for all attempts. After the first failure the bus is recovered if
+// SDA is held low.
+#ifndef I2C_RETRY_COUNT
+#  define I2C_RETRY_COUNT 3
+#endif
+
+#ifndef I2C_RETRY_BACKOFF_US
+#  define I2C_RETRY_BACKOFF_US 100
+#endif
+
+#ifndef I2C_RETRY_DEADLINE_US
+#  define I2C_RETRY_DEADLINE_US 5000
+#endif
+
+// Max number of codecs which are initialized concurrently and the stack size
+// of the FreeRTOS tasks used for this
+#ifndef PARALLEL_MAX_TASKS
+#  define PARALLEL_MAX_TASKS 4
+#endif
+
+// Max number of drivers which can be started by the AudioDriverBootScheduler
+#ifndef BOOT_MAX_DRIVERS
+#  define BOOT_MAX_DRIVERS 4
+#endif
+
+// Number of clock solutions which are cached by the ClockPlanner
+#ifndef CLOCK_PLAN_CACHE_SIZE
+#  define CLOCK_PLAN_CACHE_SIZE 8
+#endif
+
+#ifndef PARALLEL_TASK_STACK_SIZE
+#  define PARALLEL_TASK_STACK_SIZE 4096
+#endif
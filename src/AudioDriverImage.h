@@ -0,0 +1,90 @@
+#pragma once
+#include "Driver.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#  include <Preferences.h>
+#  define AUDIO_DRIVER_IMAGE_NVS
+#elif !defined(ARDUINO)
+#  include <stdio.h>
+#  define AUDIO_DRIVER_IMAGE_FILE
+#endif
+
+namespace audio_driver {
+
+/**
+ * @brief Persists the register image of an AudioDriver (see
+ * AudioDriver::saveImage()), so that the next boot can skip the init
+ * sequence: on the ESP32 the image is stored in the NVS (Preferences), on the
+ * desktop in a file. On other platforms nothing is stored and begin() uses
+ * the regular initialization.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AudioDriverImageStore {
+ public:
+  /// Defines the NVS key (max 15 characters) or the file path
+  AudioDriverImageStore(const char *key = "image") { this->key = key; }
+
+  /// Starts the driver from the stored image or with the regular begin() if
+  /// there is no valid image: a new image is stored in this case
+  bool begin(AudioDriver &driver, CodecConfig cfg, DriverPins &pins) {
+    uint8_t data[DRIVER_IMAGE_MAX_SIZE];
+    int len = load(data, sizeof(data));
+    if (len > 0 && driver.isImageValid(cfg, data, len)) {
+      return driver.beginFromImage(cfg, pins, data, len);
+    }
+    if (!driver.begin(cfg, pins)) return false;
+    save(driver);
+    return true;
+  }
+
+  /// Stores the current register image of the driver
+  bool save(AudioDriver &driver) {
+    uint8_t data[DRIVER_IMAGE_MAX_SIZE];
+    int len = driver.saveImage(data, sizeof(data));
+    if (len <= 0) return false;
+    return store(data, len);
+  }
+
+ protected:
+  const char *key;
+
+  int load(uint8_t *data, int len) {
+#if defined(AUDIO_DRIVER_IMAGE_NVS)
+    Preferences prefs;
+    if (!prefs.begin("audio-driver", true)) return 0;
+    int result = prefs.getBytes(key, data, len);
+    prefs.end();
+    return result;
+#elif defined(AUDIO_DRIVER_IMAGE_FILE)
+    FILE *file = fopen(key, "rb");
+    if (file == nullptr) return 0;
+    int result = fread(data, 1, len, file);
+    fclose(file);
+    return result;
+#else
+    return 0;
+#endif
+  }
+
+  bool store(const uint8_t *data, int len) {
+#if defined(AUDIO_DRIVER_IMAGE_NVS)
+    Preferences prefs;
+    if (!prefs.begin("audio-driver", false)) return false;
+    bool result = prefs.putBytes(key, data, len) == (size_t)len;
+    prefs.end();
+    return result;
+#elif defined(AUDIO_DRIVER_IMAGE_FILE)
+    FILE *file = fopen(key, "wb");
+    if (file == nullptr) return false;
+    bool result = fwrite(data, 1, len, file) == (size_t)len;
+    fclose(file);
+    return result;
+#else
+    return false;
+#endif
+  }
+};
+
+}  // namespace audio_driver
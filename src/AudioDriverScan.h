@@ -0,0 +1,168 @@
+#pragma once
+#include "Driver.h"
+#include "DriverPins.h"
+#include "Utils/ControlBus.h"
+#include "Utils/Vector.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Description of a codec which can be detected by the
+ * AudioDriverScanner: the device is identified by its I2C address and
+ * optionally by the value of a chip ID register (id_len = 0: ACK only).
+ * If addr2 is defined, a second device must be present as well.
+ * @ingroup audio_driver
+ */
+struct CodecScanEntry {
+  const char *name;
+  uint8_t addr;
+  uint16_t id_reg;
+  uint8_t id_reg_len;  // 1 or 2 bytes register address
+  uint8_t id_len;      // 0 (ACK only), 1 or 2 bytes
+  uint16_t id;
+  uint16_t id_mask;
+  uint8_t addr2;  // 0: not used
+  AudioDriver *driver;
+  DriverPins *pins;
+};
+
+/**
+ * @brief Determines the codec of the board by probing the I2C addresses and
+ * chip ID registers of the supported codecs: each address is checked only
+ * once and the ID registers are only read for the responding addresses.
+ * The entries are evaluated in the sequence they were added, so ACK only
+ * entries should be added after the entries with a chip ID for the same
+ * address. The I2C bus must already be started.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AudioDriverScanner {
+ public:
+  AudioDriverScanner(bool addDefaults = true) {
+    if (addDefaults) addDefaultEntries();
+  }
+
+  /// Adds a codec definition
+  void addEntry(CodecScanEntry entry) { entries.push_back(entry); }
+
+  /// Removes all codec definitions
+  void clear() { entries.clear(); }
+
+  /// Scans the Wire and returns the first matching entry (or nullptr)
+  const CodecScanEntry *scan(TwoWire &wire = Wire) {
+    ControlBusTwoWire bus(wire);
+    // missing devices are expected: we do not want any retries
+    bus.setRetry(0, 0);
+    return scan(bus);
+  }
+
+  /// Scans the ControlBus and returns the first matching entry (or nullptr)
+  const CodecScanEntry *scan(ControlBus &bus) {
+    memset(probed, 0, sizeof(probed));
+    memset(acked, 0, sizeof(acked));
+    id_cache_count = 0;
+    for (auto &entry : entries) {
+      if (!isPresent(bus, entry.addr)) continue;
+      if (entry.addr2 != 0 && !isPresent(bus, entry.addr2)) continue;
+      if (entry.id_len > 0 && !isIdMatching(bus, entry)) continue;
+      AD_LOGI("Detected codec: %s", entry.name);
+      return &entry;
+    }
+    AD_LOGW("No codec detected");
+    return nullptr;
+  }
+
+ protected:
+  audio_driver_local::Vector<CodecScanEntry> entries{0};
+  uint8_t probed[16];
+  uint8_t acked[16];
+  struct IdValue {
+    uint8_t addr;
+    uint16_t reg;
+    uint8_t len;
+    int value;
+  } id_cache[8];
+  int id_cache_count = 0;
+
+  void addDefaultEntries() {
+    // address 0x10 is used by several Everest chips
+    addEntry({"ES7243E", 0x10, 0xFD, 1, 2, 0x7A43, 0xFFFF, 0,
+              &AudioDriverES7243e, &NoPins});
+    addEntry({"ES8388", 0x10, 0, 0, 0, 0, 0, 0, &AudioDriverES8388,
+              &PinsAudioKitEs8388v1});
+    // LyratMini: ES8311 DAC and ES7243 ADC
+    addEntry({"LyratMini", 0x18, 0xFD, 1, 2, 0x8311, 0xFFFF, 0x13,
+              &AudioDriverLyratMini, &PinsLyratMini});
+    addEntry({"ES8311", 0x18, 0xFD, 1, 2, 0x8311, 0xFFFF, 0,
+              &AudioDriverES8311, &NoPins});
+    addEntry({"ES8156", 0x08, 0xFD, 1, 2, 0x8155, 0xFFFF, 0,
+              &AudioDriverES8156, &NoPins});
+    addEntry({"ES7210", 0x40, ES7210_CHIP_ID1_REG3D, 1, 2, ES7210_CHIP_ID,
+              0xFFFF, 0,
+              &AudioDriverES7210, &NoPins});
+    addEntry({"ES7243", 0x13, 0, 0, 0, 0, 0, 0, &AudioDriverES7243,
+              &NoPins});
+    // address 0x1A: AC101 and WM8994 have 16 bit registers with an ID
+    addEntry({"AC101", AC101_ADDR, 0x00, 1, 2, 0x0101, 0xFFFF, 0,
+              &AudioDriverAC101, &PinsAudioKitAC101});
+    addEntry({"WM8994", 0x1A, WM8994_CHIPID_ADDR, 2, 2, WM8994_ID, 0xFFFF, 0,
+              &AudioDriverWM8994, &NoPins});
+#if defined(ARDUINO_GENERIC_F411VETX)
+    addEntry({"CS43L22", 0x4A, CS43L22_CHIPID_ADDR, 1, 1, CS43L22_ID, 0xF8, 0,
+              &AudioDriverCS43l22, &PinsSTM32F411Disco});
+#else
+    addEntry({"CS43L22", 0x4A, CS43L22_CHIPID_ADDR, 1, 1, CS43L22_ID, 0xF8, 0,
+              &AudioDriverCS43l22, &NoPins});
+#endif
+    addEntry({"TAS5805M", 0x2E, 0, 0, 0, 0, 0, 0, &AudioDriverTAS5805M,
+              &NoPins});
+    // weak match: the CS42448 chip ID is 0, so any device at 0x48 which
+    // returns a zero high nibble in register 0x01 is accepted. Keep it last.
+    addEntry({"CS42448", 0x48, CS42448_Chip_ID, 1, 1, 0x00, 0xF0, 0,
+              &AudioDriverCS42448, &NoPins});
+  }
+
+  /// Checks the address with a single ACK request
+  bool isPresent(ControlBus &bus, uint8_t addr) {
+    addr &= 0x7F;
+    uint8_t mask = 1 << (addr & 7);
+    if (!(probed[addr >> 3] & mask)) {
+      probed[addr >> 3] |= mask;
+      if (bus.check(addr) == RESULT_OK) acked[addr >> 3] |= mask;
+    }
+    return acked[addr >> 3] & mask;
+  }
+
+  bool isIdMatching(ControlBus &bus, const CodecScanEntry &entry) {
+    int value = readId(bus, entry);
+    if (value < 0) return false;
+    return (value & entry.id_mask) == (entry.id & entry.id_mask);
+  }
+
+  /// Reads the ID register: the result is cached for the other entries
+  int readId(ControlBus &bus, const CodecScanEntry &entry) {
+    for (int j = 0; j < id_cache_count; j++) {
+      IdValue &cached = id_cache[j];
+      if (cached.addr == entry.addr && cached.reg == entry.id_reg &&
+          cached.len == entry.id_len)
+        return cached.value;
+    }
+    uint8_t reg[2] = {(uint8_t)(entry.id_reg >> 8),
+                      (uint8_t)(entry.id_reg & 0xFF)};
+    uint8_t data[2] = {0};
+    int reg_len = entry.id_reg_len == 2 ? 2 : 1;
+    int value = -1;
+    if (bus.read(entry.addr, reg + 2 - reg_len, reg_len, data, entry.id_len) ==
+        RESULT_OK) {
+      value = entry.id_len == 2 ? (data[0] << 8) | data[1] : data[0];
+    }
+    if (id_cache_count < 8) {
+      id_cache[id_cache_count++] = {entry.addr, entry.id_reg, entry.id_len,
+                                    value};
+    }
+    return value;
+  }
+};
+
+}  // namespace audio_driver
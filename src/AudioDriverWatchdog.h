@@ -0,0 +1,75 @@
+#pragma once
+#include "Driver.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Detects if the codec has lost its configuration (e.g. because of a
+ * brown-out reset while the MCU keeps running): a rotating subset of the
+ * registers is read back and compared with the last written values. On a
+ * mismatch the configuration is restored automatically. The checks use at
+ * most the defined bus time per second. Call process() in the loop(): the
+ * bus access is not thread safe, so it must be called from the same task
+ * which uses the driver. Call begin() after the driver has been started.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AudioDriverWatchdog {
+ public:
+  AudioDriverWatchdog(AudioDriver &driver) { p_driver = &driver; }
+
+  /// Defines the max bus time in us per second which is used for the checks
+  void setBudgetUs(uint32_t us) { budget_us = us; }
+
+  /// Defines the number of registers which are read back with one request
+  void setChunkSize(int registers) { chunk_size = registers; }
+
+  /// Starts the monitoring: the current register values are the reference
+  bool begin() {
+    window_start_us = ControlBus::timeUs();
+    used_us = 0;
+    is_active = p_driver->beginStateTracking();
+    if (!is_active) AD_LOGE("AudioDriverWatchdog: not supported by driver");
+    return is_active;
+  }
+
+  /// Stops the monitoring
+  void end() { is_active = false; }
+
+  /// Checks the next registers if the budget allows it: returns false if the
+  /// codec needed to be recovered
+  bool process() {
+    if (!is_active) return true;
+    uint32_t now = ControlBus::timeUs();
+    if (now - window_start_us >= 1000000) {
+      window_start_us = now;
+      used_us = 0;
+    }
+    if (used_us >= budget_us) return true;
+    int differences = p_driver->verifyState(chunk_size);
+    bool result = true;
+    if (differences != 0) {
+      // -1: the codec did not answer, it might still be in reset
+      AD_LOGW("AudioDriverWatchdog: codec state lost (%d)", differences);
+      if (differences > 0 && p_driver->recoverState()) recovery_count++;
+      result = false;
+    }
+    used_us += ControlBus::timeUs() - now;
+    return result;
+  }
+
+  /// Number of successful recoveries
+  uint32_t recoveryCount() { return recovery_count; }
+
+ protected:
+  AudioDriver *p_driver = nullptr;
+  bool is_active = false;
+  uint32_t budget_us = WATCHDOG_BUDGET_US;
+  int chunk_size = WATCHDOG_CHUNK_SIZE;
+  uint32_t window_start_us = 0;
+  uint32_t used_us = 0;
+  uint32_t recovery_count = 0;
+};
+
+}  // namespace audio_driver
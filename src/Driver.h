@@ -17,6 +17,9 @@
 #include "Driver/wm8978/WM8978.h"
 #include "Driver/wm8994/wm8994.h"
 #include "DriverPins.h"
+#include "Utils/ClockPlanner.h"
+#include "Utils/ControlBus.h"
+#include "Utils/ParallelTasks.h"
 
 namespace audio_driver {
 
@@ -26,6 +29,16 @@ const samplerate_t rate_code[14] = {
     RATE_8K,  RATE_11K, RATE_16K, RATE_22K, RATE_24K,  RATE_32K,  RATE_44K,
     RATE_48K, RATE_64K, RATE_88K, RATE_96K, RATE_128K, RATE_176K, RATE_192K};
 
+/// FNV-1a hash e.g. to validate stored data
+inline uint32_t hashFNV1a(const void *data, int len,
+                          uint32_t hash = 2166136261u) {
+  const uint8_t *p_data = (const uint8_t *)data;
+  for (int j = 0; j < len; j++) {
+    hash = (hash ^ p_data[j]) * 16777619u;
+  }
+  return hash;
+}
+
 /**
  * @brief I2S configuration and definition of input and output with default
  * values
@@ -55,6 +68,13 @@ class CodecConfig : public codec_config_t {
             i2s.mode == alt.i2s.mode);
   }
 
+  /// Hash of all attributes (e.g. to validate a stored register image)
+  uint32_t hash() {
+    int32_t values[8] = {input_device, output_device, i2s.bits,  i2s.rate,
+                         i2s.channels, i2s.fmt,       i2s.mode, sd_active};
+    return hashFNV1a(values, sizeof(values));
+  }
+
   /// Returns bits per sample as number
   int getBitsNumeric() {
     switch (i2s.bits) {
@@ -181,6 +201,24 @@ class CodecConfig : public codec_config_t {
   bool sd_active = true;
 };
 
+/**
+ * @brief Range of consecutive 8 bit registers which describes the state of a
+ * codec (see AudioDriver::saveState())
+ * @ingroup audio_driver
+ */
+struct RegisterBlock {
+  uint8_t addr;
+  uint8_t first;
+  uint8_t count;
+  bool autoIncrement;
+};
+
+/**
+ * @brief Result of AudioDriver::poll(): Idle if beginAsync() was not called
+ * @ingroup audio_driver
+ */
+enum class PollResult { Idle, Pending, Done, Error };
+
 /**
  * @brief Abstract Driver API for codec chips
  * @ingroup audio_driver
@@ -195,7 +233,16 @@ class AudioDriver {
     p_pins = &pins;
     AD_LOGD("AudioDriver::begin:setSPI");
     pins.setSPIActiveForSD(codecCfg.sd_active);
+    if (is_warm_start && isConfigured(codecCfg)) {
+      // the codec has kept its configuration: no reset and no default volume
+      AD_LOGI("AudioDriver::begin: warm start");
+      is_configured = true;
+      setPAPower(true);
+      return true;
+    }
     AD_LOGD("AudioDriver::begin:setConfig");
+    // begin always executes the full initialization
+    is_configured = false;
     int result = setConfig(codecCfg);
     AD_LOGD("AudioDriver::begin:setPAPower");
     setPAPower(true);
@@ -204,30 +251,50 @@ class AudioDriver {
     setVolume(DRIVER_DEFAULT_VOLUME);
     return result;
   }
+  /// Starts the processing without blocking: the initialization is executed
+  /// step by step by poll(), which must be called until it does not return
+  /// PollResult::Pending. Between the steps the codec needs time (e.g. after a
+  /// reset): getWakeUpTime() provides the time for the next call.
+  bool beginAsync(CodecConfig codecCfg, DriverPins &pins) {
+    p_pins = &pins;
+    begin_cfg = codecCfg;
+    begin_step = 0;
+    begin_result = PollResult::Pending;
+    wake_up_ms = millis();
+    return true;
+  }
+
+  /// Executes the next step of beginAsync() if its wake-up time has been
+  /// reached
+  PollResult poll() {
+    if (begin_result != PollResult::Pending) return begin_result;
+    if ((int32_t)(millis() - wake_up_ms) < 0) return PollResult::Pending;
+    uint32_t wait_ms = 0;
+    begin_result = beginStep(begin_step++, begin_cfg, *p_pins, wait_ms);
+    wake_up_ms = millis() + wait_ms;
+    return begin_result;
+  }
+
+  /// Time in ms (see millis()) at which poll() needs to be called again
+  uint32_t getWakeUpTime() { return wake_up_ms; }
+
   /// changes the configuration
   virtual bool setConfig(CodecConfig codecCfg) {
+    if (is_delta_config && setConfigDelta(codecCfg)) return true;
     codec_cfg = codecCfg;
-    if (!init(codec_cfg)) {
-      AD_LOGE("AudioDriver::begin::init failed");
-      return false;
-    } else {
-      AD_LOGD("AudioDriver::begin::init succeeded");
-    }
-    codec_mode_t codec_mode = codec_cfg.get_mode();
-    if (!controlState(codec_mode)) {
-      AD_LOGE("AudioDriver::begin::controlState failed");
-      return false;
-    } else {
-      AD_LOGD("AudioDriver::begin::controlState succeeded");
-    }
-    bool result = configInterface(codec_mode, codec_cfg.i2s);
-    if (!result) {
-      AD_LOGE("AudioDriver::begin::configInterface failed");
-      return false;
-    } else {
-      AD_LOGD("AudioDriver::begin::configInterface succeeded");
-    }
-    return result;
+    // init() resets the codec: the last written values are not valid any more
+    shadow_bus.invalidate();
+    is_configured = configure();
+    return is_configured;
+  }
+  /// Changes only the sample rate: drivers which support this just write
+  /// the clock registers. By default the codec is reconfigured with
+  /// setConfig().
+  virtual bool setSampleRate(int rate) {
+    CodecConfig cfg;
+    if (!getRateConfig(rate, cfg)) return false;
+    if (cfg.i2s.rate == codec_cfg.i2s.rate) return true;
+    return setConfig(cfg);
   }
   /// Ends the processing: shut down dac and adc
   virtual bool end(void) { return deinit(); }
@@ -252,6 +319,41 @@ class AudioDriver {
   /// Provides the pin information
   DriverPins &pins() { return *p_pins; }
 
+  /// Defines an alternative transport for the register access (e.g. SPI,
+  /// Linux i2c-dev or a mock): must be called before begin()
+  void setControlBus(ControlBus &bus) { p_control_bus = &bus; }
+
+  /// Defines the function of the I2C pins which are used to access the codec
+  /// (default PinFunction::CODEC)
+  void setI2CFunction(PinFunction function) { i2c_function = function; }
+
+  /// Register with an 8 bit address which is read by the I2C clock
+  /// negotiation: -1 if the codec can not be probed that way
+  virtual int getI2CProbeRegister() { return I2C_CLOCK_PROBE_REG; }
+
+  /// Provides getI2CProbeRegister() to the I2C pins: must be called before
+  /// the pins are started
+  void setupI2CProbe(DriverPins &pins) {
+    if (!pins.setI2CProbeRegister(i2c_function, getI2CProbeRegister()))
+      pins.setI2CProbeRegister(PinFunction::CODEC, getI2CProbeRegister());
+  }
+
+  /// Activates the reconfiguration in setConfig() which writes only the
+  /// changed registers (default DRIVER_DELTA_CONFIG)
+  void setDeltaConfigActive(bool active) { is_delta_config = active; }
+
+  /// Activates the check in begin() which skips the initialization if the
+  /// codec still has the requested configuration, e.g. after a reset of the
+  /// microcontroller only (default DRIVER_WARM_START)
+  void setWarmStartActive(bool active) { is_warm_start = active; }
+
+  /// Activates the filter which drops register writes that would not change
+  /// the last written value: must be called before begin()
+  void setWriteFilterActive(bool active) { is_write_filter = active; }
+
+  /// Number of register writes which were dropped by the write filter
+  uint32_t getSuppressedWrites() { return shadow_bus.suppressedWrites(); }
+
   /// Sets the PA Power pin to active or inactive
   bool setPAPower(bool enable) {
     GpioPin pin = pins().getPinID(PinFunction::PA);
@@ -266,29 +368,575 @@ class AudioDriver {
   /// Gets the number of I2S Interfaces
   virtual int getI2SCount() { return 1;}
 
+  /// Provides the clock solution of the codec for the actual configuration:
+  /// if the rate is not supported, the plan describes the nearest supported
+  /// rate and plan.exact is false
+  bool getClockPlan(ClockPlan &plan) { return getClockPlan(codec_cfg, plan); }
+
+  /// Provides the clock solution of the codec for the indicated configuration
+  bool getClockPlan(CodecConfig cfg, ClockPlan &plan) {
+    return ClockPlanner::instance().plan(getClockSolver(),
+                                         getClockRequest(cfg), plan);
+  }
+
+  /// Provides the sample rates which can be reached with the mclk (0: the
+  /// default mclk of the driver): returns the number of supported rates
+  virtual int getSupportedRates(uint32_t mclk, uint32_t *rates, int max) {
+    ClockRequest request = getClockRequest(codec_cfg);
+    request.mclk = mclk;
+    return ClockPlanner::getRates(getClockSolver(), request, rates, max);
+  }
+
+  /// Captures the register image of the codec, so that it can be restored
+  /// with restoreState() after a power down: returns the number of bytes used
+  /// or 0 if this is not supported. With data = nullptr the required size is
+  /// returned.
+  virtual int saveState(uint8_t *data, int len) {
+    RegisterBlock block;
+    if (!getStateRegisters(block)) return 0;
+    int size = block.count + 3;
+    if (data == nullptr) return size;
+    if (len < size) {
+      AD_LOGE("saveState: %d bytes required", size);
+      return 0;
+    }
+    data[0] = block.addr;
+    data[1] = block.first;
+    data[2] = block.count;
+    if (i2c_bus_read_regs(getI2C(), block.addr, block.first, data + 3,
+                          block.count, block.autoIncrement) != RESULT_OK) {
+      AD_LOGE("saveState: read failed");
+      return 0;
+    }
+    return size;
+  }
+
+  /// Serializes the register image (e.g. after begin()) into a versioned
+  /// blob which can be stored in flash or in a file and used with
+  /// beginFromImage(): returns the number of bytes used or 0 if this is not
+  /// supported. With data = nullptr the required size is returned.
+  int saveImage(uint8_t *data, int len) {
+    int size = saveState(nullptr, 0);
+    if (size <= 0) return 0;
+    if (data == nullptr) return size + image_header_size;
+    if (len < size + image_header_size) {
+      AD_LOGE("saveImage: %d bytes required", size + image_header_size);
+      return 0;
+    }
+    uint8_t *state = data + image_header_size;
+    size = saveState(state, size);
+    if (size <= 0) return 0;
+    uint32_t cfg_hash = codec_cfg.hash();
+    uint32_t data_hash = hashFNV1a(state, size);
+    memcpy(data, "ADRI", 4);
+    data[4] = 1;  // format
+    data[5] = 0;
+    data[6] = DRIVER_IMAGE_VERSION & 0xFF;
+    data[7] = DRIVER_IMAGE_VERSION >> 8;
+    for (int j = 0; j < 4; j++) {
+      data[8 + j] = cfg_hash >> (8 * j);
+      data[14 + j] = data_hash >> (8 * j);
+    }
+    data[12] = size & 0xFF;
+    data[13] = size >> 8;
+    return size + image_header_size;
+  }
+
+  /// Returns true if the image from saveImage() can be used for the
+  /// configuration
+  bool isImageValid(CodecConfig codecCfg, const uint8_t *image, int len) {
+    if (image == nullptr || len < image_header_size) return false;
+    if (memcmp(image, "ADRI", 4) != 0 || image[4] != 1) return false;
+    if ((image[6] | (image[7] << 8)) != DRIVER_IMAGE_VERSION) return false;
+    uint32_t cfg_hash = 0;
+    uint32_t data_hash = 0;
+    for (int j = 0; j < 4; j++) {
+      cfg_hash |= (uint32_t)image[8 + j] << (8 * j);
+      data_hash |= (uint32_t)image[14 + j] << (8 * j);
+    }
+    int size = image[12] | (image[13] << 8);
+    if (len < size + image_header_size) return false;
+    return cfg_hash == codecCfg.hash() &&
+           data_hash == hashFNV1a(image + image_header_size, size);
+  }
+
+  /// Starts the codec by writing the register image from saveImage() in
+  /// bursts without the delays of the init sequence: if the image is not
+  /// valid for the configuration we execute the regular begin()
+  bool beginFromImage(CodecConfig codecCfg, DriverPins &pins,
+                      const uint8_t *image, int len) {
+    RegisterBlock block;
+    if (!isImageValid(codecCfg, image, len) || !getStateRegisters(block)) {
+      AD_LOGI("beginFromImage: image not valid - using begin()");
+      return begin(codecCfg, pins);
+    }
+    p_pins = &pins;
+    pins.setSPIActiveForSD(codecCfg.sd_active);
+    codec_cfg = codecCfg;
+    // the drivers need to set up their internal state: so we execute the
+    // configuration on a simulated chip which starts with the stored values
+    const uint8_t *state = image + image_header_size;
+    int size = image[12] | (image[13] << 8);
+    ControlBusRecorder sim(block.addr);
+    if (size == block.count + 3) {
+      memcpy(sim.registers() + block.first, state + 3, block.count);
+    }
+    if (!configure(sim) || !restoreState(state, size)) {
+      AD_LOGE("beginFromImage: restore failed - using begin()");
+      return begin(codecCfg, pins);
+    }
+    is_configured = true;
+    setPAPower(true);
+    return true;
+  }
+
+  /// Starts to track the written register values for verifyState(): the
+  /// current register values of the chip are used as reference
+  bool beginStateTracking() {
+    RegisterBlock block;
+    if (!getVerifyRegisters(block)) return false;
+    is_state_tracking = true;
+    verify_pos = 0;
+    return readReference(block);
+  }
+
+  /// Reads back the next count registers (continuing where the last call
+  /// stopped) and compares them with the tracked values: returns the number
+  /// of differences or -1 if the chip could not be read
+  int verifyState(int count) {
+    RegisterBlock block;
+    if (!is_state_tracking || !getVerifyRegisters(block)) return -1;
+    if (count > block.count) count = block.count;
+    if (verify_pos >= block.count) verify_pos = 0;
+    if (verify_pos + count > block.count) count = block.count - verify_pos;
+    uint8_t reg = block.first + verify_pos;
+    uint8_t values[256];
+    if (!selectRegisterPage(block) ||
+        i2c_bus_read_regs(getI2C(), block.addr, reg, values, count,
+                          block.autoIncrement) != RESULT_OK)
+      return -1;
+    verify_pos += count;
+    int result = 0;
+    for (int j = 0; j < count; j++) {
+      uint8_t expected;
+      if (shadow_bus.getValue(block.addr, reg + j, expected) &&
+          expected != values[j]) {
+        AD_LOGW("verifyState: reg 0x%x is 0x%x instead of 0x%x", reg + j,
+                values[j], expected);
+        result++;
+      }
+    }
+    return result;
+  }
+
+  /// Writes the tracked values of all registers which differ on the chip
+  /// (e.g. after a brown-out reset of the codec): the changes are written
+  /// while the codec is powered down with getPowerDownSequence(). Drivers
+  /// without a power down sequence execute the configuration again first.
+  virtual bool recoverState() {
+    RegisterBlock block;
+    if (!is_state_tracking || !getVerifyRegisters(block)) return false;
+    uint8_t expected[256];
+    uint8_t known[32] = {0};
+    for (int j = 0; j < block.count; j++) {
+      uint8_t reg = block.first + j;
+      if (shadow_bus.getValue(block.addr, reg, expected[reg]))
+        known[reg >> 3] |= 1 << (reg & 7);
+    }
+    // the chip has lost its state: we must not use any cached values
+    invalidateRegisterCache();
+    int power_count = 0;
+    bool by_init = isRecoveryByInit() ||
+                   getPowerDownSequence(power_count) == nullptr;
+    if (by_init && !configure()) return false;
+    uint8_t values[256];
+    ControlBus *p_bus = getI2C();
+    if (!selectRegisterPage(block) ||
+        i2c_bus_read_regs(p_bus, block.addr, block.first, values + block.first,
+                          block.count, block.autoIncrement) != RESULT_OK)
+      return false;
+    i2c_reg_value_t changed[256];
+    int count = 0;
+    for (int j = 0; j < block.count; j++) {
+      uint8_t reg = block.first + j;
+      if (!(known[reg >> 3] & (1 << (reg & 7)))) expected[reg] = values[reg];
+      if (values[reg] != expected[reg]) changed[count++] = {reg, expected[reg]};
+    }
+    AD_LOGW("recoverState: %d registers restored", count);
+    if (count > 0) {
+      bool ok = by_init ? p_bus->writeSeq(block.addr, changed, count,
+                                          block.autoIncrement) == RESULT_OK
+                        : writePoweredDown(block, values, expected, changed,
+                                           count);
+      if (!ok) return false;
+    }
+    return readReference(block);
+  }
+
+  /// Writes the register image from saveState() back to the codec with a
+  /// minimum number of bus transactions: this is much faster than end() and
+  /// begin()
+  virtual bool restoreState(const uint8_t *data, int len) {
+    RegisterBlock block;
+    if (data == nullptr || len < 3 || !getStateRegisters(block)) return false;
+    if (data[0] != block.addr || data[1] != block.first ||
+        data[2] != block.count || len < block.count + 3) {
+      AD_LOGE("restoreState: invalid data");
+      return false;
+    }
+    // the chip has lost its state: we must not use any cached values
+    invalidateRegisterCache();
+    ControlBus *p_bus = getI2C();
+    i2c_reg_value_t seq[I2C_MAX_BURST_LEN];
+    bool result = true;
+    for (int pos = 0; pos < block.count; pos += I2C_MAX_BURST_LEN) {
+      int n = block.count - pos;
+      if (n > I2C_MAX_BURST_LEN) n = I2C_MAX_BURST_LEN;
+      for (int j = 0; j < n; j++) {
+        seq[j].reg = block.first + pos + j;
+        seq[j].value = data[3 + pos + j];
+      }
+      if (p_bus->writeSeq(block.addr, seq, n, block.autoIncrement) !=
+          RESULT_OK)
+        result = false;
+    }
+    return result;
+  }
+
  protected:
   CodecConfig codec_cfg;
   DriverPins *p_pins = nullptr;
+  ControlBus *p_control_bus = nullptr;
+  ControlBusTwoWire i2c_bus;
+  ControlBusShadow shadow_bus;
+  bool is_write_filter = I2C_WRITE_FILTER;
+  bool is_delta_config = DRIVER_DELTA_CONFIG;
+  bool is_warm_start = DRIVER_WARM_START;
+  CodecConfig begin_cfg;
+  int begin_step = 0;
+  PollResult begin_result = PollResult::Idle;
+  uint32_t wake_up_ms = 0;
+  bool is_configured = false;
+  bool is_state_tracking = false;
+  static const int image_header_size = 18;
+  int verify_pos = 0;
+  PinFunction i2c_function = PinFunction::CODEC;
+  ControlBusProxy bus_proxy;
+  ControlBus *p_sim_bus = nullptr;
+
+  /// Executes the full configuration of the codec
+  bool configure() {
+    if (!init(codec_cfg)) {
+      AD_LOGE("AudioDriver::begin::init failed");
+      return false;
+    } else {
+      AD_LOGD("AudioDriver::begin::init succeeded");
+    }
+    codec_mode_t codec_mode = codec_cfg.get_mode();
+    if (!controlState(codec_mode)) {
+      AD_LOGE("AudioDriver::begin::controlState failed");
+      return false;
+    } else {
+      AD_LOGD("AudioDriver::begin::controlState succeeded");
+    }
+    bool result = configInterface(codec_mode, codec_cfg.i2s);
+    if (!result) {
+      AD_LOGE("AudioDriver::begin::configInterface failed");
+      return false;
+    } else {
+      AD_LOGD("AudioDriver::begin::configInterface succeeded");
+    }
+    return result;
+  }
+
+  /// Executes the configuration on a simulated bus: afterwards the drivers
+  /// use the real bus again
+  bool configure(ControlBus &sim) {
+    p_sim_bus = &sim;
+    bool ok = configure();
+    p_sim_bus = nullptr;
+    getI2C();
+    return ok;
+  }
+
+  /// Reconfigures the codec by writing only the registers which differ from
+  /// the current state: the new register image is determined by executing
+  /// the configuration on a simulated device. Because only the final value
+  /// of each register is known, the codec is first muted and powered down
+  /// with getPowerDownSequence(), then the changed registers are written and
+  /// finally the power registers are restored in reverse order. Drivers
+  /// without a power down sequence are always fully reconfigured.
+  bool setConfigDelta(CodecConfig codecCfg) {
+    RegisterBlock block;
+    int power_count = 0;
+    if (!is_configured || getPowerDownSequence(power_count) == nullptr ||
+        !getStateRegisters(block))
+      return false;
+    ControlBusRecorder sim(block.addr);
+    uint8_t *image = sim.registers();
+    uint8_t current[256];
+    if (!simulateConfig(codecCfg, block, sim, current)) return false;
+
+    // collect the changed registers in the sequence of the last write
+    i2c_reg_value_t changed[256];
+    int count = 0;
+    for (int reg = 0; reg < 256; reg++) {
+      if (sim.writeOrder(reg) == 0) continue;
+      bool in_block = reg >= block.first && reg < block.first + block.count;
+      if (in_block && image[reg] == current[reg]) continue;
+      int pos = count++;
+      while (pos > 0 &&
+             sim.writeOrder(changed[pos - 1].reg) > sim.writeOrder(reg)) {
+        changed[pos] = changed[pos - 1];
+        pos--;
+      }
+      changed[pos] = {(uint8_t)reg, image[reg]};
+    }
+    AD_LOGI("setConfig: %d registers changed", count);
+    if (count > 0 && !writePoweredDown(block, current, image, changed, count)) {
+      invalidateRegisterCache();
+      is_configured = false;
+      return false;
+    }
+    return true;
+  }
+
+  /// Mutes and powers down the codec with getPowerDownSequence(), writes the
+  /// changes and finally sets the power registers to their target values in
+  /// reverse order: current and target are indexed by the register.
+  bool writePoweredDown(RegisterBlock &block, const uint8_t *current,
+                        const uint8_t *target, const i2c_reg_value_t *changes,
+                        int count) {
+    int power_count = 0;
+    const i2c_seq_t *power = getPowerDownSequence(power_count);
+    if (power == nullptr) return false;
+    i2c_reg_value_t seq[256 + 2 * DRIVER_POWER_SEQ_MAX];
+    uint8_t power_regs[DRIVER_POWER_SEQ_MAX];
+    bool is_power_reg[256] = {false};
+    int n = 0;
+    int power_writes = 0;
+    for (int j = 0; j < power_count && power[j].op != I2C_SEQ_END; j++) {
+      // everything is sent in one burst: delays and polls are not supported
+      if (power[j].op != I2C_SEQ_WRITE && power[j].op != I2C_SEQ_UPDATE)
+        continue;
+      if (power_writes >= DRIVER_POWER_SEQ_MAX) break;
+      uint8_t reg = power[j].reg;
+      uint8_t value = power[j].value;
+      if (power[j].op == I2C_SEQ_UPDATE)
+        value = (current[reg] & ~power[j].mask) | (value & power[j].mask);
+      is_power_reg[reg] = true;
+      power_regs[power_writes++] = reg;
+      seq[n++] = {reg, value};
+    }
+    for (int j = 0; j < count; j++) {
+      if (!is_power_reg[changes[j].reg]) seq[n++] = changes[j];
+    }
+    for (int j = power_writes - 1; j >= 0; j--) {
+      seq[n++] = {power_regs[j], target[power_regs[j]]};
+    }
+    return getI2C()->writeSeq(block.addr, seq, n, block.autoIncrement) ==
+           RESULT_OK;
+  }
+
+  /// Reads the register block of the chip in one burst into the simulated
+  /// device and executes the configuration for codecCfg on it: current
+  /// receives the values of the chip. If the simulation fails the last
+  /// configuration is kept.
+  bool simulateConfig(CodecConfig codecCfg, RegisterBlock &block,
+                      ControlBusRecorder &sim, uint8_t *current) {
+    uint8_t *image = sim.registers();
+    if (i2c_bus_read_regs(getI2C(), block.addr, block.first,
+                          image + block.first, block.count,
+                          block.autoIncrement) != RESULT_OK)
+      return false;
+    memcpy(current, image, 256);
+    CodecConfig old_cfg = codec_cfg;
+    codec_cfg = codecCfg;
+    if (!configure(sim)) {
+      codec_cfg = old_cfg;
+      invalidateRegisterCache();
+      return false;
+    }
+    return true;
+  }
+
+  /// Returns true if the chip already has the configuration for codecCfg:
+  /// all registers of the state block which are set by the configuration
+  /// must have the expected value. The internal state of the driver is set
+  /// up by the simulated configuration.
+  bool isConfigured(CodecConfig codecCfg) {
+    RegisterBlock block;
+    if (!getStateRegisters(block)) return false;
+    ControlBusRecorder sim(block.addr);
+    uint8_t *image = sim.registers();
+    uint8_t current[256];
+    if (!simulateConfig(codecCfg, block, sim, current)) return false;
+    for (int reg = block.first; reg < block.first + block.count; reg++) {
+      if (sim.writeOrder(reg) != 0 && image[reg] != current[reg]) {
+        AD_LOGI("register 0x%x: 0x%x - expected 0x%x", reg, current[reg],
+                image[reg]);
+        invalidateRegisterCache();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Provides the ControlBus which is used for the register access: the
+  /// one defined with setControlBus() or the TwoWire from the I2C config
+  ControlBus *getI2C() {
+    ControlBus *p_bus = p_control_bus;
+    if (p_bus == nullptr) {
+      i2c_bus.setWire(*getWire());
+      setupRecovery();
+      p_bus = &i2c_bus;
+    }
+    if (is_write_filter || is_state_tracking) {
+      shadow_bus.setTarget(*p_bus);
+      shadow_bus.setFilterActive(is_write_filter);
+      p_bus = &shadow_bus;
+    }
+    // the drivers keep the proxy, so that we can switch to a simulation
+    bus_proxy.setTarget(p_sim_bus != nullptr ? *p_sim_bus : *p_bus);
+    return &bus_proxy;
+  }
+
+  /// The bus can be recovered if we have set up the I2C pins
+  void setupRecovery() {
+    if (p_pins == nullptr) return;
+    auto i2c = getI2CPins();
+    if (i2c && i2c.value().set_active && i2c.value().pinsAvailable()) {
+      i2c_bus.setRecoveryPins(i2c.value().scl, i2c.value().sda,
+                              i2c.value().frequency);
+    }
+  }
 
   /// Determine the TwoWire object from the I2C config or use Wire
-  TwoWire *getI2C() {
+  TwoWire *getWire() {
     if (p_pins == nullptr) return &Wire;
-    auto i2c = pins().getI2CPins(PinFunction::CODEC);
+    auto i2c = getI2CPins();
     if (!i2c) {
       return &Wire;
     }
     return i2c.value().p_wire;
   }
 
+  /// Provides the I2C pins for the i2c_function: if they are not defined we
+  /// use the CODEC pins
+  audio_driver_local::Optional<PinsI2C> getI2CPins() {
+    auto i2c = pins().getI2CPins(i2c_function);
+    if (!i2c && i2c_function != PinFunction::CODEC) {
+      i2c = pins().getI2CPins(PinFunction::CODEC);
+    }
+    return i2c;
+  }
+
   int getI2CAddress() {
     if (p_pins == nullptr) return -1;
-    auto i2c = pins().getI2CPins(PinFunction::CODEC);
+    auto i2c = getI2CPins();
     if (i2c) {
       return i2c.value().port;
     }
     return -1;
   }
 
+  /// Executes the indicated step of beginAsync(): returns
+  /// PollResult::Pending with the time the codec needs before the next step
+  /// in waitMs. By default the full begin() is executed in one step.
+  virtual PollResult beginStep(int step, CodecConfig &codecCfg,
+                               DriverPins &pins, uint32_t &waitMs) {
+    return begin(codecCfg, pins) ? PollResult::Done : PollResult::Error;
+  }
+
+  /// begin() for drivers which implement beginStep(): executes the steps and
+  /// waits in between
+  bool beginSteps(CodecConfig codecCfg, DriverPins &pins) {
+    beginAsync(codecCfg, pins);
+    PollResult result;
+    while ((result = poll()) == PollResult::Pending) {
+      int32_t wait_ms = wake_up_ms - millis();
+      if (wait_ms > 0) delay(wait_ms);
+    }
+    return result == PollResult::Done;
+  }
+
+  /// Defines the registers which are captured by saveState(): returns false
+  /// if this is not supported
+  virtual bool getStateRegisters(RegisterBlock &block) { return false; }
+
+  /// Mutes and powers down the codec before setConfigDelta() changes the
+  /// clock registers: the registers must be part of the state block and are
+  /// restored in reverse order. Returns nullptr if setConfig() must always
+  /// execute the full configuration.
+  virtual const i2c_seq_t *getPowerDownSequence(int &count) {
+    count = 0;
+    return nullptr;
+  }
+
+  /// Provides the actual configuration with the new rate: returns false if
+  /// the codec does not support the rate
+  bool getRateConfig(int rate, CodecConfig &cfg) {
+    cfg = codec_cfg;
+    ClockPlan plan;
+    if (cfg.setRateNumeric(rate) != rate || !getClockPlan(cfg, plan) ||
+        !plan.exact) {
+      AD_LOGE("setSampleRate: %d not supported", rate);
+      return false;
+    }
+    return true;
+  }
+
+  /// Clock calculation of the chip which is used by getClockPlan()
+  virtual clock_solver_t getClockSolver() { return solveClock; }
+
+  /// Clock requirements of the configuration
+  virtual ClockRequest getClockRequest(CodecConfig &cfg) {
+    ClockRequest request;
+    request.rate = cfg.getRateNumeric();
+    request.bits = cfg.getBitsNumeric();
+    request.channels = cfg.getChannelsNumeric();
+    return request;
+  }
+
+  /// Default clock solution: mclk = 256 * rate
+  static bool solveClock(const ClockRequest &request, ClockPlan &plan) {
+    return ClockPlanner::solveRatio(request, plan);
+  }
+
+  /// Defines the registers which are checked by verifyState(): by default
+  /// the same as getStateRegisters()
+  virtual bool getVerifyRegisters(RegisterBlock &block) {
+    return getStateRegisters(block);
+  }
+
+  /// Returns true if the codec must be initialized again by recoverState()
+  /// because its state is not fully described by the verified registers
+  virtual bool isRecoveryByInit() { return false; }
+
+  /// Selects the book or page of the verified registers before they are
+  /// read (e.g. after the upload of DSP coefficients)
+  virtual bool selectRegisterPage(RegisterBlock &block) { return true; }
+
+  /// Forgets all cached register values: the shadow and the register maps
+  /// of the C drivers
+  virtual void invalidateRegisterCache() {
+    shadow_bus.invalidate();
+    i2c_reg_map_invalidate_bus(&bus_proxy);
+  }
+
+  /// Uses the register values of the chip as reference for verifyState()
+  bool readReference(RegisterBlock &block) {
+    uint8_t values[256];
+    if (!selectRegisterPage(block) ||
+        i2c_bus_read_regs(getI2C(), block.addr, block.first, values,
+                          block.count, block.autoIncrement) != RESULT_OK)
+      return false;
+    for (int j = 0; j < block.count; j++) {
+      shadow_bus.setValue(block.addr, block.first + j, values[j]);
+    }
+    return true;
+  }
+
   virtual bool init(codec_config_t codec_cfg) { return false; }
   virtual bool deinit() { return false; }
   virtual bool controlState(codec_mode_t mode) { return false; };
@@ -337,20 +985,51 @@ class NoDriverClass : public AudioDriver {
  */
 class AudioDriverAC101Class : public AudioDriver {
  public:
-  bool setMute(bool mute) { return ac101_set_voice_mute(mute); }
+  bool setMute(bool mute) { return ac101_set_voice_mute(mute) == RESULT_OK; }
   bool setVolume(int volume) {
-    return ac101_set_voice_volume(limitValue(volume, 0, 100));
+    return ac101_set_voice_volume(limitValue(volume, 0, 100)) == RESULT_OK;
   };
   int getVolume() {
     int vol;
     ac101_get_voice_volume(&vol);
     return vol;
   };
+  /// Writes only the sample rate register while the output is muted
+  bool setSampleRate(int rate) override {
+    CodecConfig cfg;
+    if (!getRateConfig(rate, cfg)) return false;
+    // a muted output has the volume 0 and stays muted
+    int volume = getVolume();
+    bool result = setMute(true) && set_codec_clk(cfg.i2s.rate) == RESULT_OK;
+    if (result) codec_cfg = cfg;
+    return setVolume(volume) && result;
+  }
 
  protected:
+  bool is_reset_done = false;
+
   bool init(codec_config_t codec_cfg) {
+    if (is_reset_done) {
+      is_reset_done = false;
+      return ac101_configure(&codec_cfg) == RESULT_OK;
+    }
     return ac101_init(&codec_cfg, getI2C(), getI2CAddress()) == RESULT_OK;
   }
+
+  /// soft reset (AC101_RESET_TIME_MS) and begin()
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step == 0) {
+      if (ac101_reset(getI2C(), getI2CAddress()) != RESULT_OK)
+        return PollResult::Error;
+      waitMs = AC101_RESET_TIME_MS;
+      return PollResult::Pending;
+    }
+    is_reset_done = true;
+    bool result = begin(codecCfg, pins);
+    is_reset_done = false;
+    return result ? PollResult::Done : PollResult::Error;
+  }
   bool deinit() { return ac101_deinit() == RESULT_OK; }
   bool controlState(codec_mode_t mode) {
     return ac101_ctrl_state_active(mode, true) == RESULT_OK;
@@ -358,6 +1037,25 @@ class AudioDriverAC101Class : public AudioDriver {
   bool configInterface(codec_mode_t mode, I2SDefinition iface) {
     return ac101_config_i2s(mode, &iface) == RESULT_OK;
   }
+
+  clock_solver_t getClockSolver() override { return solveClock; }
+
+  /// The rates of set_codec_clk() with mclk = 256 * rate
+  static bool solveClock(const ClockRequest &request, ClockPlan &plan) {
+    switch (request.rate) {
+      case 8000:
+      case 11025:
+      case 16000:
+      case 22050:
+      case 24000:
+      case 32000:
+      case 44100:
+      case 48000:
+        return ClockPlanner::solveRatio(request, plan);
+      default:
+        return false;
+    }
+  }
 };
 
 /**
@@ -368,25 +1066,7 @@ class AudioDriverAC101Class : public AudioDriver {
 class AudioDriverAD1938Class : public AudioDriver {
  public:
   bool begin(CodecConfig codecCfg, DriverPins &pins) override {
-    int clatch = pins.getPinID(PinFunction::LATCH);
-    if (clatch < 0) return false;
-    int reset = pins.getPinID(PinFunction::RESET);
-    if (reset < 0) return false;
-    auto spi_opt = pins.getSPIPins(PinFunction::CODEC);
-    SPIClass *p_spi = nullptr;
-    if (spi_opt) {
-      p_spi = spi_opt.value().p_spi;
-    } else {
-      p_spi = &SPI;
-      p_spi->begin();
-    }
-    // setup pins
-    pins.begin();
-    // setup ad1938
-    ad1938.begin(codecCfg, clatch, reset, *p_spi);
-    ad1938.enable();
-    ad1938.setMute(false);
-    return true;
+    return beginSteps(codecCfg, pins);
   }
   virtual bool setConfig(CodecConfig codecCfg) {
     bool result = begin(codecCfg, *p_pins);
@@ -397,8 +1077,8 @@ class AudioDriverAD1938Class : public AudioDriver {
   // mutes an individual DAC: valid range (0:3)
   bool setMute(bool mute, int line) {
     if (line > 3) return false;
-    return ad1938.setVolumeDAC(
-        line, mute ? 0.0 : (static_cast<float>(volumes[line]) / 100.0f));
+    return ad1938.setVolume(
+        line, mute ? 0.0f : (static_cast<float>(volumes[line]) / 100.0f));
   }
 
   /// Defines the Volume (in %) if volume is 0, mute is enabled,range is 0-100.
@@ -414,7 +1094,7 @@ class AudioDriverAD1938Class : public AudioDriver {
   bool setVolume(int volume, int line) {
     if (line > 7) return false;
     volumes[line] = volume;
-    return ad1938.setVolumeDAC(static_cast<float>(volume) / 100.0f, line);
+    return ad1938.setVolume(line, static_cast<float>(volume) / 100.0f);
   }
 
   int getVolume() override { return volume; }
@@ -430,6 +1110,52 @@ class AudioDriverAD1938Class : public AudioDriver {
   DriverPins *p_pins = nullptr;
   int volume = 100;
   int volumes[8] = {100};
+
+  /// reset (200ms), release the reset (400ms) and configure
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    switch (step) {
+      case 0: {
+        p_pins = &pins;
+        int reset = pins.getPinID(PinFunction::RESET);
+        if (reset < 0) return PollResult::Error;
+        if (p_control_bus != nullptr) {
+          // use the ControlBus defined with setControlBus()
+          pins.begin();
+          ad1938.setup(codecCfg, reset, *p_control_bus);
+        } else {
+          int clatch = pins.getPinID(PinFunction::LATCH);
+          if (clatch < 0) return PollResult::Error;
+          auto spi_opt = pins.getSPIPins(PinFunction::CODEC);
+          SPIClass *p_spi = nullptr;
+          if (spi_opt) {
+            p_spi = spi_opt.value().p_spi;
+          } else {
+            p_spi = &SPI;
+            p_spi->begin();
+          }
+          // setup pins
+          pins.begin();
+          ad1938.setup(codecCfg, clatch, reset, *p_spi);
+        }
+        ad1938.setReset(true);
+        waitMs = 200;
+        return PollResult::Pending;
+      }
+      case 1:
+        ad1938.setReset(false);
+        // wait for 300ms to load the code
+        waitMs = 400;
+        return PollResult::Pending;
+      default:
+        if (!ad1938.config() || !ad1938.enable()) {
+          AD_LOGE("AD1938 configuration failed");
+          return PollResult::Error;
+        }
+        ad1938.setMute(false);
+        return PollResult::Done;
+    }
+  }
 };
 
 /**
@@ -445,24 +1171,12 @@ class AudioDriverCS43l22Class : public AudioDriver {
 
   void setI2CAddress(uint16_t adr) { deviceAddr = adr; }
 
+  /// register 0x00 is reserved
+  int getI2CProbeRegister() override { return CS43L22_CHIPID_ADDR; }
+
   virtual bool begin(CodecConfig codecCfg, DriverPins &pins) {
     AD_LOGD("AudioDriverCS43l22Class::begin");
-    p_pins = &pins;
-    codec_cfg = codecCfg;
-    // manage reset pin -> acive high
-    setPAPower(true);
-    // Setup enable pin for codec
-    delay(100);
-    uint32_t freq = getFrequency(codec_cfg.i2s.rate);
-    uint16_t outputDevice = getOutput(codec_cfg.output_device);
-    AD_LOGD("cs43l22_Init");
-    bool result =
-        cs43l22_Init(deviceAddr, outputDevice, volume, freq, getI2C()) == 0;
-    if (!result) {
-      AD_LOGE("error: cs43l22_Init");
-    }
-    cs43l22_Play(deviceAddr, nullptr, 0);
-    return result;
+    return beginSteps(codecCfg, pins);
   }
 
   virtual bool setConfig(CodecConfig codecCfg) {
@@ -484,10 +1198,42 @@ class AudioDriverCS43l22Class : public AudioDriver {
   }
   int getVolume() { return volume; }
 
+  /// The clocking is in auto detect mode: the codec follows the new LRCK
+  bool setSampleRate(int rate) override {
+    CodecConfig cfg;
+    if (!getRateConfig(rate, cfg)) return false;
+    codec_cfg = cfg;
+    return cs43l22_SetFrequency(deviceAddr, rate) == 0;
+  }
+
  protected:
   uint16_t deviceAddr;
   int volume = 100;
 
+  /// enable the codec (100ms) and configure it
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step == 0) {
+      p_pins = &pins;
+      codec_cfg = codecCfg;
+      // manage reset pin -> acive high
+      setPAPower(true);
+      // Setup enable pin for codec
+      waitMs = 100;
+      return PollResult::Pending;
+    }
+    uint32_t freq = getFrequency(codec_cfg.i2s.rate);
+    uint16_t outputDevice = getOutput(codec_cfg.output_device);
+    AD_LOGD("cs43l22_Init");
+    bool result =
+        cs43l22_Init(deviceAddr, outputDevice, volume, freq, getI2C()) == 0;
+    if (!result) {
+      AD_LOGE("error: cs43l22_Init");
+    }
+    cs43l22_Play(deviceAddr, nullptr, 0);
+    return result ? PollResult::Done : PollResult::Error;
+  }
+
   bool deinit() {
     int cnt = cs43l22_Stop(deviceAddr, AUDIO_MUTE_ON);
     cnt += cs43l22_Reset(deviceAddr);
@@ -543,9 +1289,13 @@ class AudioDriverCS43l22Class : public AudioDriver {
  */
 class AudioDriverCS42448Class : public AudioDriver {
  public:
+  /// register 0x00 is reserved
+  int getI2CProbeRegister() override { return CS42448_Chip_ID; }
+
   bool begin(CodecConfig codecCfg, DriverPins &pins) override {
     cfg = codecCfg;
     // setup pins
+    setupI2CProbe(pins);
     pins.begin();
     // setup cs42448
     cs42448.begin(cfg, getI2C(), getI2CAddress());
@@ -556,16 +1306,27 @@ class AudioDriverCS42448Class : public AudioDriver {
     bool result = true;
     if (codecCfg.equalsExRate(cfg)) {
       // just update the rate
-      if (cfg.i2s.rate != codecCfg.getRateNumeric()) {
-        cs42448.setMute(true);
-        cs42448.setSampleRate(codecCfg.getRateNumeric());
-        cs42448.setMute(false);
+      if (cfg.i2s.rate != codecCfg.i2s.rate) {
+        result = setSampleRate(codecCfg.getRateNumeric());
       }
     } else {
       result = begin(codecCfg, *p_pins);
     }
     return result;
   }
+  bool setSampleRate(int rate) override {
+    CodecConfig new_cfg = cfg;
+    if (new_cfg.setRateNumeric(rate) != rate) return false;
+    // the lines which were muted by the user must stay muted
+    uint8_t dac_mute;
+    bool adc_mute;
+    if (!cs42448.getMuteState(dac_mute, adc_mute)) return false;
+    cs42448.setMute(true);
+    bool result = cs42448.setSampleRate(rate);
+    if (!cs42448.setMuteState(dac_mute, adc_mute)) result = false;
+    if (result) cfg = new_cfg;
+    return result;
+  }
   bool end(void) override { return cs42448.end(); }
   bool setMute(bool enable) override { return cs42448.setMute(enable); }
   bool setMute(bool enable, int line) {
@@ -611,6 +1372,21 @@ class AudioDriverES7210Class : public AudioDriver {
     return es7210_adc_set_volume(limitValue(volume, 0, 100)) == RESULT_OK;
   }
   int getVolume() { return volume; }
+  int getSupportedRates(uint32_t mclk, uint32_t *rates, int max) override {
+    return es7210_get_rates(mclk, rates, max);
+  }
+  /// Writes only the clock registers of es7210_config_sample() while the
+  /// ADCs are muted
+  bool setSampleRate(int rate) override {
+    CodecConfig cfg;
+    bool mute = false;
+    if (!getRateConfig(rate, cfg) || es7210_get_mute(&mute) != RESULT_OK)
+      return false;
+    bool result = es7210_set_mute(true) == RESULT_OK &&
+                  es7210_config_sample(cfg.i2s.rate) == RESULT_OK;
+    if (result) codec_cfg = cfg;
+    return es7210_set_mute(mute) == RESULT_OK && result;
+  }
 
  protected:
   int volume;
@@ -618,14 +1394,44 @@ class AudioDriverES7210Class : public AudioDriver {
   bool init(codec_config_t codec_cfg) {
     return es7210_adc_init(&codec_cfg, getI2C()) == RESULT_OK;
   }
+
+  /// reset (ES7210_RESET_TIME_MS) and begin()
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step == 0) {
+      if (es7210_adc_reset(getI2C()) != RESULT_OK) return PollResult::Error;
+      waitMs = ES7210_RESET_TIME_MS;
+      return PollResult::Pending;
+    }
+    return begin(codecCfg, pins) ? PollResult::Done : PollResult::Error;
+  }
   bool deinit() { return es7210_adc_deinit() == RESULT_OK; }
 
+  bool getStateRegisters(RegisterBlock &block) override {
+    block = {0x40, 0x00, 0x4F, ES_I2C_AUTO_INCREMENT};
+    return true;
+  }
+
   bool controlState(codec_mode_t mode) {
     return es7210_adc_ctrl_state_active(mode, true) == RESULT_OK;
   }
   bool configInterface(codec_mode_t mode, I2SDefinition iface) {
     return es7210_adc_config_i2s(mode, &iface) == RESULT_OK;
   }
+
+  clock_solver_t getClockSolver() override { return solveClock; }
+
+  /// Entry of the coefficient table for mclk (default: 256 * rate)
+  static bool solveClock(const ClockRequest &request, ClockPlan &plan) {
+    uint32_t mclk = request.mclk != 0 ? request.mclk : request.rate * 256;
+    int coeff = es7210_get_coeff(mclk, request.rate);
+    if (coeff < 0) return false;
+    ClockRequest req = request;
+    req.mclk = mclk;
+    if (!ClockPlanner::solveRatio(req, plan)) return false;
+    plan.index = coeff;
+    return true;
+  }
 };
 
 /**
@@ -648,9 +1454,29 @@ class AudioDriverES7243Class : public AudioDriver {
   }
 
  protected:
+  bool is_mclk_active = false;
+
   bool init(codec_config_t codec_cfg) {
+    if (is_mclk_active) {
+      is_mclk_active = false;
+      return es7243_adc_configure(&codec_cfg, getI2C()) == RESULT_OK;
+    }
     return es7243_adc_init(&codec_cfg, getI2C()) == RESULT_OK;
   }
+
+  /// mclk pulses (ES7243_MCLK_HALF_PERIOD_MS per level) and begin()
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step < 2 * ES7243_MCLK_PULSES) {
+      es7243_mclk_write(step % 2);
+      waitMs = ES7243_MCLK_HALF_PERIOD_MS;
+      return PollResult::Pending;
+    }
+    is_mclk_active = true;
+    bool result = begin(codecCfg, pins);
+    is_mclk_active = false;
+    return result ? PollResult::Done : PollResult::Error;
+  }
   bool deinit() { return es7243_adc_deinit() == RESULT_OK; }
 
   bool controlState(codec_mode_t mode) {
@@ -724,6 +1550,11 @@ class AudioDriverES8156Class : public AudioDriver {
   }
   bool deinit() { return es8156_codec_deinit() == RESULT_OK; }
 
+  bool getStateRegisters(RegisterBlock &block) override {
+    block = {0x08, 0x00, ES8156_ANALOG_SYS5_REG25 + 1, ES_I2C_AUTO_INCREMENT};
+    return true;
+  }
+
   bool controlState(codec_mode_t mode) {
     return es8156_codec_ctrl_state_active(mode, true) == RESULT_OK;
   }
@@ -749,6 +1580,18 @@ class AudioDriverES8311Class : public AudioDriver {
     es8311_codec_get_voice_volume(&vol);
     return vol;
   }
+  int getSupportedRates(uint32_t mclk, uint32_t *rates, int max) override {
+    return es8311_get_rates(mclk, rates, max);
+  }
+  /// Writes only the clock registers while the dac is muted
+  bool setSampleRate(int rate) override {
+    CodecConfig cfg;
+    if (!getRateConfig(rate, cfg) ||
+        es8311_config_sample(cfg.i2s.rate) != RESULT_OK)
+      return false;
+    codec_cfg = cfg;
+    return true;
+  }
 
  protected:
   int i2c_address;
@@ -766,14 +1609,47 @@ class AudioDriverES8311Class : public AudioDriver {
     return es8311_codec_init(&codec_cfg, getI2C(), mclk_src, i2c_address) ==
            RESULT_OK;
   }
+
+  /// reset (ES8311_RESET_TIME_MS) and begin()
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step == 0) {
+      if (i2c_address <= 0) i2c_address = getI2CAddress();
+      if (es8311_reset(getI2C(), i2c_address) != RESULT_OK)
+        return PollResult::Error;
+      waitMs = ES8311_RESET_TIME_MS;
+      return PollResult::Pending;
+    }
+    return begin(codecCfg, pins) ? PollResult::Done : PollResult::Error;
+  }
   bool deinit() { return es8311_codec_deinit() == RESULT_OK; }
 
+  bool getStateRegisters(RegisterBlock &block) override {
+    uint8_t addr = i2c_address > 0 ? i2c_address : 0x18;
+    block = {addr, 0x00, ES8311_GP_REG45 + 1, ES_I2C_AUTO_INCREMENT};
+    return true;
+  }
+
   bool controlState(codec_mode_t mode) {
     return es8311_codec_ctrl_state_active(mode, true) == RESULT_OK;
   }
   bool configInterface(codec_mode_t mode, I2SDefinition iface) {
     return es8311_codec_config_i2s(mode, &iface) == RESULT_OK;
   }
+
+  clock_solver_t getClockSolver() override { return solveClock; }
+
+  /// Entry of the coefficient table for mclk (default: 256 * rate)
+  static bool solveClock(const ClockRequest &request, ClockPlan &plan) {
+    uint32_t mclk = request.mclk != 0 ? request.mclk : request.rate * 256;
+    int coeff = es8311_get_coeff(mclk, request.rate);
+    if (coeff < 0) return false;
+    ClockRequest req = request;
+    req.mclk = mclk;
+    if (!ClockPlanner::solveRatio(req, plan)) return false;
+    plan.index = coeff;
+    return true;
+  }
 };
 
 /**
@@ -905,6 +1781,23 @@ class AudioDriverES8388Class : public AudioDriver {
   }
   bool deinit() { return es8388_deinit() == RESULT_OK; }
 
+  bool getStateRegisters(RegisterBlock &block) override {
+    // including the DLL registers 0x35 - 0x39 of the init sequence
+    block = {ES8388_ADDR, 0x00, ES8388_DLL_LAST + 1, ES_I2C_AUTO_INCREMENT};
+    return true;
+  }
+
+  /// DAC mute, DAC and ADC power down
+  const i2c_seq_t *getPowerDownSequence(int &count) override {
+    static const i2c_seq_t seq[] = {
+        {I2C_SEQ_UPDATE, ES8388_DACCONTROL3, 0x04, 0x04},
+        {I2C_SEQ_WRITE, ES8388_DACPOWER, 0xC0, 0},
+        {I2C_SEQ_WRITE, ES8388_ADCPOWER, 0xFF, 0},
+    };
+    count = sizeof(seq) / sizeof(seq[0]);
+    return seq;
+  }
+
   bool controlState(codec_mode_t mode) {
     return es8388_ctrl_state_active(mode, true) == RESULT_OK;
   }
@@ -932,10 +1825,57 @@ class AudioDriverTAS5805MClass : public AudioDriver {
   }
 
  protected:
+  bool is_powered = false;
+
   bool init(codec_config_t codec_cfg) {
+    // status and clock monitor registers
+    for (uint8_t reg = 0x37; reg <= 0x39; reg++) {
+      shadow_bus.setVolatile(TAS5805M_ADDR, reg);
+    }
+    // page and book select
+    shadow_bus.setPageRegister(TAS5805M_ADDR, 0x00);
+    shadow_bus.setPageRegister(TAS5805M_ADDR, 0x7F);
+    if (is_powered) {
+      is_powered = false;
+      return tas5805m_load_registers(getI2C()) == RESULT_OK;
+    }
     return tas5805m_init(&codec_cfg, getI2C()) == RESULT_OK;
   }
+
+  /// power off, power on (TAS5805M_POWER_TIME_MS each) and begin()
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step < 2) {
+      tas5805m_set_power(step == 1);
+      waitMs = TAS5805M_POWER_TIME_MS;
+      return PollResult::Pending;
+    }
+    is_powered = true;
+    bool result = begin(codecCfg, pins);
+    is_powered = false;
+    return result ? PollResult::Done : PollResult::Error;
+  }
   bool deinit() { return tas5805m_deinit() == RESULT_OK; }
+  // the configuration is defined by the register table of init()
+  bool controlState(codec_mode_t mode) { return true; }
+  bool configInterface(codec_mode_t mode, I2SDefinition iface) { return true; }
+
+  /// Book 0 / page 0 control registers up to the analog gain
+  bool getVerifyRegisters(RegisterBlock &block) override {
+    block = {TAS5805M_ADDR, 0x02, 0x53, true};
+    return true;
+  }
+  /// The DSP configuration is lost as well: we need to upload it again
+  bool isRecoveryByInit() override { return true; }
+  /// The DSP upload leaves an other book selected
+  bool selectRegisterPage(RegisterBlock &block) override {
+    static const i2c_reg_value_t seq[] = {
+        {TAS5805M_REG_00, TAS5805M_PAGE_00},
+        {TAS5805M_REG_7F, TAS5805M_BOOK_00},
+        {TAS5805M_REG_00, TAS5805M_PAGE_00},
+    };
+    return getI2C()->writeSeq(TAS5805M_ADDR, seq, 3, false) == RESULT_OK;
+  }
 };
 
 /**
@@ -945,10 +1885,15 @@ class AudioDriverTAS5805MClass : public AudioDriver {
  */
 class AudioDriverWM8960Class : public AudioDriver {
  public:
+  /// the registers are write-only
+  int getI2CProbeRegister() override { return -1; }
+
   bool begin(CodecConfig codecCfg, DriverPins &pins) {
     codec_cfg = codecCfg;
 
-    // define wire object
+    // define wire object: the 9 bit values can not be filtered, the driver
+    // keeps its own register cache
+    shadow_bus.setFilterActive(WM8960_I2C_ADDRESS, false);
     mtb_wm8960_set_wire(getI2C());
     mtb_wm8960_set_write_retry_count(i2c_retry_count);
 
@@ -990,6 +1935,17 @@ class AudioDriverWM8960Class : public AudioDriver {
 
   int getVolume() { return volume_out; }
 
+  /// Writes only the PLL and divider registers while the dac is muted
+  bool setSampleRate(int rate) override {
+    CodecConfig cfg;
+    if (!getRateConfig(rate, cfg)) return false;
+    codec_cfg = cfg;
+    mtb_wm8960_set(WM8960_REG_CTR1, WM8960_CTR1_DACMU_MUTE);
+    bool result = configure_clocking();
+    mtb_wm8960_clear(WM8960_REG_CTR1, WM8960_CTR1_DACMU_MUTE);
+    return result;
+  }
+
   bool setInputVolume(int volume) {
     volume_in = limitValue(volume, 0, 100);
     int vol_int = map(volume_in, 0, 100, 0, 30);
@@ -1005,7 +1961,8 @@ class AudioDriverWM8960Class : public AudioDriver {
   /// Configuration: enable/disable PLL (active by default)
   void setEnablePLL(bool active) { vs1053_enable_pll = active; }
 
-  /// Configuration: define master clock frequency (default: 0)
+  /// Configuration: define master clock frequency (default: 0 = 12.288 MHz
+  /// or 11.2896 MHz depending on the rate)
   void setMclkHz(uint32_t hz) { vs1053_mclk_hz = hz; }
 
   void dumpRegisters() { mtb_wm8960_dump(); }
@@ -1051,13 +2008,13 @@ class AudioDriverWM8960Class : public AudioDriver {
   }
 
   bool configure_clocking() {
-    if (vs1053_mclk_hz == 0) {
-      // just pick a multiple of the sample rate
-      vs1053_mclk_hz = 512 * codec_cfg.getRateNumeric();
+    ClockPlan plan;
+    if (!getClockPlan(plan)) {
+      AD_LOGE("No clock solution for mclk %u", (unsigned)vs1053_mclk_hz);
+      return false;
     }
     if (!mtb_wm8960_configure_clocking(
-            vs1053_mclk_hz, vs1053_enable_pll,
-            sampleRate(codec_cfg.getRateNumeric()),
+            plan.mclk, vs1053_enable_pll, sampleRate(plan.rate),
             wordLength(codec_cfg.getBitsNumeric()),
             modeMasterSlave(codec_cfg.i2s.mode == MODE_MASTER))) {
       AD_LOGE("mtb_wm8960_configure_clocking");
@@ -1066,6 +2023,50 @@ class AudioDriverWM8960Class : public AudioDriver {
     return true;
   }
 
+  clock_solver_t getClockSolver() override { return solveClock; }
+
+  ClockRequest getClockRequest(CodecConfig &cfg) override {
+    ClockRequest request = AudioDriver::getClockRequest(cfg);
+    request.mclk = vs1053_mclk_hz;
+    request.pll = vs1053_enable_pll;
+    return request;
+  }
+
+  /// The sysclk is 12.288 MHz or 11.2896 MHz depending on the rate: it is
+  /// the mclk (default) or it is generated by the PLL from the mclk
+  static bool solveClock(const ClockRequest &request, ClockPlan &plan) {
+    uint32_t sysclk;
+    switch (request.rate) {
+      case 48000:
+      case 32000:
+      case 24000:
+      case 16000:
+      case 12000:
+      case 8000:
+        sysclk = 12288000;
+        break;
+      case 44100:
+      case 22050:
+      case 11025:
+      case 8018:
+        sysclk = 11289600;
+        break;
+      default:
+        return false;
+    }
+    uint32_t mclk = request.mclk != 0 ? request.mclk : sysclk;
+    plan.rate = request.rate;
+    plan.mclk = mclk;
+    plan.bclk = request.rate * request.bits * request.channels;
+    if (!request.pll) return mclk == sysclk;
+    mtb_wm8960_pll_t pll;
+    if (!mtb_wm8960_calculate_pll(mclk, sysclk, &pll)) return false;
+    plan.pll_n = pll.n;
+    plan.pll_k = pll.k;
+    plan.pll_out = 8 * sysclk;
+    return true;
+  }
+
   mtb_wm8960_adc_dac_sample_rate_t sampleRate(int rate) {
     switch (rate) {
       case 48000:
@@ -1125,13 +2126,15 @@ class AudioDriverWM8978Class : public AudioDriver {
  public:
   AudioDriverWM8978Class() = default;
 
+  /// the registers are write-only
+  int getI2CProbeRegister() override { return -1; }
+
   bool begin(CodecConfig codecCfg, DriverPins &pins) override {
     bool rc = true;
-    auto i2c = pins.getI2CPins(PinFunction::CODEC);
-    if (i2c && i2c.value().p_wire != nullptr) {
-      auto i2c_pins = i2c.value();
-      wm8078.setWire(*i2c_pins.p_wire);
-    }
+    p_pins = &pins;
+    // the 9 bit values can not be filtered, the driver keeps its own cache
+    shadow_bus.setFilterActive(WM8978_ADDR, false);
+    wm8078.setControlBus(*getI2C());
     rc = wm8078.begin();
     setConfig(codecCfg);
 
@@ -1170,6 +2173,42 @@ class AudioDriverWM8978Class : public AudioDriver {
     return true;
   }
 
+  /// The chip is write only: the state is taken from the register map of the
+  /// driver (2 bytes per register)
+  int saveState(uint8_t *data, int len) override {
+    int count = wm8078.getRegisterCount();
+    int size = count * 2 + 3;
+    if (data == nullptr) return size;
+    if (len < size) {
+      AD_LOGE("saveState: %d bytes required", size);
+      return 0;
+    }
+    data[0] = WM8978_ADDR;
+    data[1] = 0;
+    data[2] = count;
+    for (int j = 0; j < count; j++) {
+      uint16_t value = wm8078.getRegister(j);
+      data[3 + j * 2] = value >> 8;
+      data[4 + j * 2] = value & 0xFF;
+    }
+    return size;
+  }
+
+  bool restoreState(const uint8_t *data, int len) override {
+    int count = wm8078.getRegisterCount();
+    if (data == nullptr || len < count * 2 + 3 || data[0] != WM8978_ADDR ||
+        data[1] != 0 || data[2] != count) {
+      AD_LOGE("restoreState: invalid data");
+      return false;
+    }
+    uint16_t values[64];
+    if (count > 64) return false;
+    for (int j = 0; j < count; j++) {
+      values[j] = (data[3 + j * 2] << 8) | data[4 + j * 2];
+    }
+    return wm8078.restoreRegisters(values, count);
+  }
+
   /// Mute line 0 = speaker, line 1 = headphones
   bool setMute(bool mute, int line) override {
     int scaled = mute ? 0 : map(volume, 0, 100, 0, 63);
@@ -1275,17 +2314,11 @@ class AudioDriverWM8994Class : public AudioDriver {
 
   void setI2CAddress(uint16_t adr) { deviceAddr = adr; }
 
-  virtual bool begin(CodecConfig codecCfg, DriverPins &pins) {
-    codec_cfg = codecCfg;
-    // manage reset pin -> active high
-    setPAPower(true);
-    delay(10);
-    p_pins = &pins;
-    int vol = map(volume, 0, 100, DEFAULT_VOLMIN, DEFAULT_VOLMAX);
-    uint32_t freq = codecCfg.getRateNumeric();
-    uint16_t outputDevice = getOutput(codec_cfg.output_device);
+  /// the registers have 16 bit addresses
+  int getI2CProbeRegister() override { return -1; }
 
-    return wm8994_Init(deviceAddr, outputDevice, vol, freq, getI2C()) == 0;
+  virtual bool begin(CodecConfig codecCfg, DriverPins &pins) {
+    return beginSteps(codecCfg, pins);
   }
 
   bool setMute(bool mute) {
@@ -1303,6 +2336,33 @@ class AudioDriverWM8994Class : public AudioDriver {
  protected:
   uint16_t deviceAddr;
   int volume = 100;
+  uint32_t init_errors = 0;
+
+  /// Step 0 powers the codec, the following steps execute wm8994_InitStep()
+  /// so that the VMID, charge pump and DC servo settle times do not block
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step == 0) {
+      p_pins = &pins;
+      codec_cfg = codecCfg;
+      init_errors = 0;
+      // manage reset pin -> active high
+      setPAPower(true);
+      waitMs = 10;
+      return PollResult::Pending;
+    }
+    int vol = map(volume, 0, 100, DEFAULT_VOLMIN, DEFAULT_VOLMAX);
+    uint32_t freq = codec_cfg.getRateNumeric();
+    uint16_t outputDevice = getOutput(codec_cfg.output_device);
+    init_errors += wm8994_InitStep(deviceAddr, outputDevice, vol, freq,
+                                   getI2C(), step - 1, &waitMs);
+    if (waitMs > 0) return PollResult::Pending;
+    if (init_errors != 0) {
+      AD_LOGE("error: wm8994_Init");
+      return PollResult::Error;
+    }
+    return PollResult::Done;
+  }
 
   bool deinit() {
     int cnt = wm8994_Stop(deviceAddr, AUDIO_MUTE_ON);
@@ -1326,6 +2386,95 @@ class AudioDriverWM8994Class : public AudioDriver {
   }
 };
 
+/**
+ * @brief Starts the codecs of a board with several chips: the steps of their
+ * beginAsync() are interleaved, so that the register writes of one chip are
+ * executed while another chip waits for its reset or power ramp. So the board
+ * is ready after the longest chain of waits and not after the sum of all
+ * waits. Use begin() to wait for the result or beginAsync() and poll().
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class AudioDriverBootScheduler {
+ public:
+  /// Adds a driver: returns false if there is no space left
+  bool add(AudioDriver &driver, CodecConfig cfg, DriverPins &pins) {
+    if (count >= BOOT_MAX_DRIVERS) return false;
+    entries[count].p_driver = &driver;
+    entries[count].cfg = cfg;
+    entries[count].p_pins = &pins;
+    entries[count].result = PollResult::Idle;
+    count++;
+    return true;
+  }
+
+  /// Removes all drivers
+  void clear() { count = 0; }
+
+  /// Starts all drivers and waits until they are ready: returns true if all
+  /// of them have succeeded
+  bool begin() {
+    beginAsync();
+    PollResult result;
+    while ((result = poll()) == PollResult::Pending) {
+      int32_t wait_ms = getWakeUpTime() - millis();
+      if (wait_ms > 0) delay(wait_ms);
+    }
+    return result == PollResult::Done;
+  }
+
+  /// Starts all drivers without blocking: call poll() until it does not
+  /// return PollResult::Pending
+  void beginAsync() {
+    for (int j = 0; j < count; j++) {
+      Entry &entry = entries[j];
+      entry.p_driver->beginAsync(entry.cfg, *entry.p_pins);
+      entry.result = PollResult::Pending;
+    }
+    wake_up_ms = millis();
+  }
+
+  /// Executes the next step of all drivers which are due: returns
+  /// PollResult::Error if any driver failed after all have completed
+  PollResult poll() {
+    bool pending = false;
+    bool error = false;
+    bool idle = false;
+    wake_up_ms = millis() + 0x7FFFFFFF;
+    for (int j = 0; j < count; j++) {
+      Entry &entry = entries[j];
+      if (entry.result == PollResult::Pending) {
+        entry.result = entry.p_driver->poll();
+      }
+      if (entry.result == PollResult::Pending) {
+        pending = true;
+        uint32_t wake_up = entry.p_driver->getWakeUpTime();
+        if ((int32_t)(wake_up - wake_up_ms) < 0) wake_up_ms = wake_up;
+      }
+      if (entry.result == PollResult::Error) error = true;
+      if (entry.result == PollResult::Idle) idle = true;
+    }
+    if (idle) return PollResult::Idle;
+    if (pending) return PollResult::Pending;
+    return error ? PollResult::Error : PollResult::Done;
+  }
+
+  /// Time in ms (see millis()) at which poll() needs to be called again
+  uint32_t getWakeUpTime() { return wake_up_ms; }
+
+ protected:
+  struct Entry {
+    AudioDriver *p_driver;
+    CodecConfig cfg;
+    DriverPins *p_pins;
+    PollResult result = PollResult::Idle;
+  };
+  Entry entries[BOOT_MAX_DRIVERS];
+  int count = 0;
+  uint32_t wake_up_ms = 0;
+};
+
 /**
  * @brief Driver API for Lyrat Mini with a ES8311 and a ES7243 codec chip
  * @author Phil Schatzmann
@@ -1334,12 +2483,18 @@ class AudioDriverWM8994Class : public AudioDriver {
 class AudioDriverLyratMiniClass : public AudioDriver {
  public:
   bool begin(CodecConfig codecCfg, DriverPins &pins) {
-    int rc = 0;
-    if (codecCfg.output_device != DAC_OUTPUT_NONE)
-      rc += !dac.begin(codecCfg, pins);
-    if (codecCfg.input_device != ADC_INPUT_NONE)
-      rc += !adc.begin(codecCfg, pins);
-    return rc == 0;
+    cfg = codecCfg;
+    p_pins = &pins;
+    // the ADC uses the CODEC_ADC I2C pins if they are defined
+    adc.setI2CFunction(PinFunction::CODEC_ADC);
+    // codecs on separate buses are set up concurrently
+    if (isSeparateBus()) {
+      ParallelTasks tasks;
+      if (codecCfg.output_device != DAC_OUTPUT_NONE) tasks.add(beginDAC, this);
+      if (codecCfg.input_device != ADC_INPUT_NONE) tasks.add(beginADC, this);
+      return tasks.run();
+    }
+    return beginSteps(codecCfg, pins);
   }
   bool end(void) {
     int rc = 0;
@@ -1359,6 +2514,48 @@ class AudioDriverLyratMiniClass : public AudioDriver {
  protected:
   AudioDriverES8311Class dac;
   AudioDriverES7243Class adc;
+  CodecConfig cfg;
+  AudioDriverBootScheduler scheduler;
+
+  /// The steps of the DAC and ADC are interleaved
+  PollResult beginStep(int step, CodecConfig &codecCfg, DriverPins &pins,
+                       uint32_t &waitMs) override {
+    if (step == 0) {
+      cfg = codecCfg;
+      p_pins = &pins;
+      adc.setI2CFunction(PinFunction::CODEC_ADC);
+      scheduler.clear();
+      if (codecCfg.output_device != DAC_OUTPUT_NONE)
+        scheduler.add(dac, codecCfg, pins);
+      if (codecCfg.input_device != ADC_INPUT_NONE)
+        scheduler.add(adc, codecCfg, pins);
+      scheduler.beginAsync();
+    }
+    PollResult result = scheduler.poll();
+    if (result == PollResult::Pending) {
+      int32_t wait_ms = scheduler.getWakeUpTime() - millis();
+      waitMs = wait_ms > 0 ? wait_ms : 0;
+    }
+    return result;
+  }
+
+  static bool beginDAC(void *ref) {
+    AudioDriverLyratMiniClass *self = (AudioDriverLyratMiniClass *)ref;
+    return self->dac.begin(self->cfg, self->pins());
+  }
+
+  static bool beginADC(void *ref) {
+    AudioDriverLyratMiniClass *self = (AudioDriverLyratMiniClass *)ref;
+    return self->adc.begin(self->cfg, self->pins());
+  }
+
+  /// Checks if the DAC and ADC are connected to different TwoWire objects
+  bool isSeparateBus() {
+    auto dac_i2c = pins().getI2CPins(PinFunction::CODEC);
+    auto adc_i2c = pins().getI2CPins(PinFunction::CODEC_ADC);
+    if (!dac_i2c || !adc_i2c) return false;
+    return dac_i2c.value().p_wire != adc_i2c.value().p_wire;
+  }
 };
 
 // -- Drivers
@@ -1381,6 +2578,8 @@ static AudioDriverES8374Class AudioDriverES8374;
 /// @ingroup audio_driver
 static AudioDriverES8388Class AudioDriverES8388;
 /// @ingroup audio_driver
+static AudioDriverTAS5805MClass AudioDriverTAS5805M;
+/// @ingroup audio_driver
 static AudioDriverWM8960Class AudioDriverWM8960;
 /// @ingroup audio_driver
 static AudioDriverWM8978Class AudioDriverWM8978;
@@ -7,6 +7,8 @@
 
 static i2c_bus_handle_t i2c_handle = NULL;
 static int i2c_addr_ac101 = AC101_ADDR;
+/* image of the registers, so that bit updates need no read */
+static i2c_reg_map_t *ac101_regs = NULL;
 
 #define AC_ASSERT(a, format, b, ...)          \
 	if ((a) != 0)                             \
@@ -20,7 +22,16 @@ static error_t ac101_write_reg(uint8_t reg_add, uint16_t data){
 	uint8_t send_buff[2];
 	send_buff[0] = (data >> 8) & 0xff;
 	send_buff[1] = data & 0xff;
-    return i2c_bus_write_bytes(i2c_handle, i2c_addr_ac101, &reg_add, sizeof(reg_add), (uint8_t*) send_buff, sizeof(send_buff));
+	error_t ret = i2c_bus_write_bytes(i2c_handle, i2c_addr_ac101, &reg_add, sizeof(reg_add), (uint8_t*) send_buff, sizeof(send_buff));
+	if (reg_add == CHIP_AUDIO_RS) {
+		// soft reset: all registers are back at their defaults
+		i2c_reg_map_invalidate(ac101_regs);
+	} else if (ret == RESULT_OK) {
+		i2c_reg_map_store(ac101_regs, reg_add, data);
+	} else {
+		i2c_reg_map_forget(ac101_regs, reg_add);
+	}
+	return ret;
 }
 
 static error_t ac101_read_i2c(uint8_t devAddr, uint8_t reg_add, uint8_t *p_data, size_t size) {
@@ -28,17 +39,66 @@ static error_t ac101_read_i2c(uint8_t devAddr, uint8_t reg_add, uint8_t *p_data,
 }
 
 
+// reads count consecutive 16 bit registers with a minimum number of transactions
+static error_t ac101_read_regs(uint8_t reg_addr, uint16_t *values, int count)
+{
+	error_t ret = RESULT_OK;
+	uint8_t data_rd[I2C_MAX_READ_LEN];
+	int pos = 0;
+	while (pos < count) {
+		int len = count - pos;
+		if (!AC101_I2C_AUTO_INCREMENT) len = 1;
+		if (len > I2C_MAX_READ_LEN / 2) len = I2C_MAX_READ_LEN / 2;
+		ret |= ac101_read_i2c(i2c_addr_ac101, reg_addr + pos, data_rd, len * 2);
+		for (int j = 0; j < len; j++) {
+			values[pos + j] = (data_rd[2 * j] << 8) + data_rd[2 * j + 1];
+		}
+		pos += len;
+	}
+	return ret;
+}
+
+// a known value is taken from the register map
+static error_t ac101_read_reg_cached(uint8_t reg_addr, uint16_t *value)
+{
+	if (i2c_reg_map_lookup(ac101_regs, reg_addr, value))
+		return RESULT_OK;
+	error_t ret = ac101_read_regs(reg_addr, value, 1);
+	if (ret == RESULT_OK)
+		i2c_reg_map_store(ac101_regs, reg_addr, *value);
+	return ret;
+}
+
 static uint16_t ac101_read_reg(uint8_t reg_addr)
 {
 	uint16_t val = 0;
-	uint8_t data_rd[2];
-	ac101_read_i2c(i2c_addr_ac101, reg_addr, data_rd, 2);
-	val = (data_rd[0] << 8) + data_rd[1];
+	ac101_read_reg_cached(reg_addr, &val);
 	return val;
 }
 
+// read-modify-write of the bits in mask: only written if the value changes
+static error_t ac101_update_reg(uint8_t reg_addr, uint16_t mask, uint16_t value)
+{
+	uint16_t val = 0;
+	if (ac101_read_reg_cached(reg_addr, &val) != RESULT_OK)
+		return RESULT_FAIL;
+	uint16_t new_val = (val & ~mask) | (value & mask);
+	if (new_val == val)
+		return RESULT_OK;
+	return ac101_write_reg(reg_addr, new_val);
+}
+
+void ac101_read_all()
+{
+	uint16_t regs[DAC_DAP_ENA + 1] = {0};
+	ac101_read_regs(0, regs, DAC_DAP_ENA + 1);
+	for (int i = 0; i <= DAC_DAP_ENA; i++) {
+		AD_LOGI("%x: %x", i, regs[i]);
+	}
+}
+
 
-void set_codec_clk(samplerate_t sampledata)
+error_t set_codec_clk(samplerate_t sampledata)
 {
 	uint16_t sample_fre;
 	switch (sampledata)
@@ -70,7 +130,7 @@ void set_codec_clk(samplerate_t sampledata)
 	default:
 		sample_fre = 44100;
 	}
-	ac101_write_reg(I2S_SR_CTRL, sample_fre);
+	return ac101_write_reg(I2S_SR_CTRL, sample_fre);
 }
 
 /// Determines the value for the SRC register based on the selected input_device
@@ -99,23 +159,36 @@ uint16_t get_src_value(input_device_t input_device){
 }
 
 error_t ac101_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle, int addr)
+{
+	error_t res = ac101_reset(handle, addr);
+	i2c_bus_delay(i2c_handle, AC101_RESET_TIME_MS);
+	if (res != RESULT_OK) return res;
+	return ac101_configure(codec_cfg);
+}
+
+error_t ac101_reset(i2c_bus_handle_t handle, int addr)
 {
 	error_t res = RESULT_OK;
     i2c_handle = handle;
 	if (addr>0){
 		i2c_addr_ac101 = addr;
 	}
+	i2c_reg_map_release(ac101_regs);
+	ac101_regs = i2c_reg_map_get(i2c_handle, i2c_addr_ac101);
 
 	res = ac101_write_reg(CHIP_AUDIO_RS, 0x123);
-	delay(1000);
-
 	if (res != RESULT_OK)
 	{
 		AD_LOGE("reset failed!");
-		return res;
 	} else {
 		AD_LOGI("reset");
 	}
+	return res;
+}
+
+error_t ac101_configure(codec_config_t *codec_cfg)
+{
+	error_t res = RESULT_OK;
 	res |= ac101_write_reg(SPKOUT_CTRL, 0xe880);
 
 	//Enable the PLL from 256*44.1KHz MCLK source
@@ -167,15 +240,7 @@ error_t ac101_set_spk_volume(uint8_t volume)
 		volume = 0x3f;
 	volume = volume / 2;
 
-	uint16_t res;
-	error_t ret;
-
-	res = ac101_read_reg(SPKOUT_CTRL);
-	res &= (~0x1f);
-	volume &= 0x1f;
-	res |= volume;
-	ret = ac101_write_reg(SPKOUT_CTRL, res);
-	return ret;
+	return ac101_update_reg(SPKOUT_CTRL, 0x1f, volume);
 }
 
 int ac101_get_earph_volume(void)
@@ -190,43 +255,27 @@ error_t ac101_set_earph_volume(uint8_t volume)
 	if (volume > 0x3f)
 		volume = 0x3f;
 
-	uint16_t res, tmp;
-	error_t ret;
-	res = ac101_read_reg(HPOUT_CTRL);
-	tmp = ~(0x3f << 4);
-	res &= tmp;
-	volume &= 0x3f;
-	res |= (volume << 4);
-	ret = ac101_write_reg(HPOUT_CTRL, res);
-	return ret;
+	return ac101_update_reg(HPOUT_CTRL, 0x3f << 4, volume << 4);
 }
 
 error_t ac101_set_output_mixer_gain(ac_output_mixer_gain_t gain, ac_output_mixer_source_t source)
 {
-	uint16_t regval, temp, clrbit;
-	error_t ret;
-	regval = ac101_read_reg(OMIXER_BST1_CTRL);
+	int shift;
 	switch (source)
 	{
 	case SRC_MIC1:
-		temp = (gain & 0x7) << 6;
-		clrbit = ~(0x7 << 6);
+		shift = 6;
 		break;
 	case SRC_MIC2:
-		temp = (gain & 0x7) << 3;
-		clrbit = ~(0x7 << 3);
+		shift = 3;
 		break;
 	case SRC_LINEIN:
-		temp = (gain & 0x7);
-		clrbit = ~0x7;
+		shift = 0;
 		break;
 	default:
 		return -1;
 	}
-	regval &= clrbit;
-	regval |= temp;
-	ret = ac101_write_reg(OMIXER_BST1_CTRL, regval);
-	return ret;
+	return ac101_update_reg(OMIXER_BST1_CTRL, 0x7 << shift, (gain & 0x7) << shift);
 }
 
 error_t AC101_start(ac_module_t mode)
@@ -253,12 +302,12 @@ error_t AC101_start(ac_module_t mode)
 		res |= ac101_write_reg(OMIXER_DACA_CTRL, 0xff80);
 		res |= ac101_write_reg(HPOUT_CTRL, 0xc3c1);
 		res |= ac101_write_reg(HPOUT_CTRL, 0xcb00);
-		delay(100);
+		i2c_bus_delay(i2c_handle, 100);
 		res |= ac101_write_reg(HPOUT_CTRL, 0xfbc0);
 
 		//* Enable Speaker output
 		res |= ac101_write_reg(SPKOUT_CTRL, 0xeabd);
-		delay(10);
+		i2c_bus_delay(i2c_handle, 10);
 		ac101_set_voice_volume(30);
 	}
 
@@ -275,8 +324,10 @@ error_t AC101_stop(ac_module_t mode)
 
 error_t ac101_deinit(void)
 {
-
-	return ac101_write_reg(CHIP_AUDIO_RS, 0x123); //soft reset
+	error_t res = ac101_write_reg(CHIP_AUDIO_RS, 0x123); //soft reset
+	i2c_reg_map_release(ac101_regs);
+	ac101_regs = NULL;
+	return res;
 }
 
 error_t ac101_ctrl_state_active(codec_mode_t mode, bool ctrl_state_active)
@@ -384,26 +435,17 @@ error_t ac101_config_i2s(codec_mode_t mode, I2SDefinition *iface)
 	default:
 		sample_fre = 44100;
 	}
-	regval = ac101_read_reg(I2S1LCK_CTRL);
-	regval &= 0xffc3;
-	regval |= (iface->mode << 15);
-	regval |= (bits << 4);
-	regval |= (fmat << 2);
-	res |= ac101_write_reg(I2S1LCK_CTRL, regval);
+	regval = (iface->mode << 15) | (bits << 4) | (fmat << 2);
+	// bits 2-5 are replaced, the master mode bit is only set
+	res |= ac101_update_reg(I2S1LCK_CTRL, 0x003c | regval, regval);
 	res |= ac101_write_reg(I2S_SR_CTRL, sample_fre);
 	return res;
 }
 
 error_t AC101_i2s_config_clock(ac_i2s_clock_t *cfg)
 {
-	error_t res = 0;
-	uint16_t regval = 0;
-	regval = ac101_read_reg(I2S1LCK_CTRL);
-	regval &= 0xe03f;
-	regval |= (cfg->bclk_div << 9);
-	regval |= (cfg->lclk_div << 6);
-	res = ac101_write_reg(I2S1LCK_CTRL, regval);
-	return res;
+	uint16_t regval = (cfg->bclk_div << 9) | (cfg->lclk_div << 6);
+	return ac101_update_reg(I2S1LCK_CTRL, 0x1fc0 | regval, regval);
 }
 
 error_t ac101_set_voice_mute(bool enable)
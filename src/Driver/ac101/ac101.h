@@ -167,13 +167,22 @@ typedef struct {
 } ac_i2s_clock_t;
 
 
+/* time in ms which the codec needs after ac101_reset() */
+#define AC101_RESET_TIME_MS 1000
+
 error_t ac101_init(codec_config_t* codec_cfg, i2c_bus_handle_t i2c_handle, int addr);
+/* ac101_init() in steps: ac101_reset(), wait AC101_RESET_TIME_MS, ac101_configure() */
+error_t ac101_reset(i2c_bus_handle_t i2c_handle, int addr);
+error_t ac101_configure(codec_config_t* codec_cfg);
 error_t ac101_deinit(void);
 error_t ac101_ctrl_state_active(codec_mode_t mode, bool ctrl_state_active);
 error_t ac101_config_i2s(codec_mode_t mode, I2SDefinition* iface);
+/* changes only the sample rate register */
+error_t set_codec_clk(samplerate_t sampledata);
 error_t ac101_set_voice_mute(bool enable);
 error_t ac101_set_voice_volume(int volume);
 error_t ac101_get_voice_volume(int* volume);
+void ac101_read_all();
 
 
 #ifdef __cplusplus
@@ -469,20 +469,18 @@ Bit Value Function Description
 
 bool AD1938::begin(codec_config_t configVal, int clatchPin, int resetPin,
                    SPIClass &spi) {
-  ad1938_clatch_pin = clatchPin;
-  ad1938_reset_pin = resetPin;
-  cfg = configVal;
-  p_spi = &spi;
+  setup(configVal, clatchPin, resetPin, spi);
+  return begin(configVal, resetPin, spi_bus);
+}
 
-  // setup pins
-  pinMode(ad1938_clatch_pin, OUTPUT);
-  pinMode(ad1938_reset_pin, OUTPUT);
+bool AD1938::begin(codec_config_t configVal, int resetPin, ControlBus &bus) {
+  setup(configVal, resetPin, bus);
 
   // reset codec
-  digitalWrite(ad1938_reset_pin, LOW);
-  delay(200);
-  digitalWrite(ad1938_reset_pin, HIGH);
-  delay(400);  // wait for 300ms to load the code
+  setReset(true);
+  p_bus->delayMs(200);
+  setReset(false);
+  p_bus->delayMs(400);  // wait for 300ms to load the code
 
   // setup basic information from codec_config_t
   config();
@@ -490,57 +488,42 @@ bool AD1938::begin(codec_config_t configVal, int clatchPin, int resetPin,
   return true;
 }
 
-unsigned char AD1938::spi_read_reg(unsigned char reg) {
-  unsigned char result = 0;
-  unsigned char data[AD1938_SPI_WRITE_BYTE_COUNT];
-
-  data[0] = AD1938_READ_ADDRESS;
-  data[1] = reg;
-  data[2] = 0x0;
-
-  // and configure settings
-  p_spi->beginTransaction(
-      SPISettings(AD1938_SPI_CLK_FREQ, MSBFIRST, SPI_MODE3));
-  // take the chip select low to select the device:
-  digitalWrite(ad1938_clatch_pin, LOW);
+void AD1938::setup(codec_config_t configVal, int clatchPin, int resetPin,
+                   SPIClass &spi) {
+  spi_bus.setSPI(spi, clatchPin, AD1938_SPI_CLK_FREQ, SPI_MODE3);
+  setup(configVal, resetPin, spi_bus);
+}
 
-  p_spi->transfer(
-      &data[0],
-      AD1938_SPI_READ_BYTE_COUNT);  // Send register location , read byte is 2
+void AD1938::setup(codec_config_t configVal, int resetPin, ControlBus &bus) {
+  ad1938_reset_pin = resetPin;
+  cfg = configVal;
+  p_bus = &bus;
 
-  // send a value of 0 to read the first byte returned:
-  result = (unsigned char)p_spi->transfer(0x00);
+  // setup pins
+  pinMode(ad1938_reset_pin, OUTPUT);
+}
 
-  // take the chip select high to de-select:
-  digitalWrite(ad1938_clatch_pin, HIGH);
-  // release control of the SPI port
-  p_spi->endTransaction();
+void AD1938::setReset(bool active) {
+  digitalWrite(ad1938_reset_pin, active ? LOW : HIGH);
+}
 
+unsigned char AD1938::spi_read_reg(unsigned char reg) {
+  unsigned char result = 0;
+  // the bus sends AD1938_READ_ADDRESS and the register location and then
+  // reads the returned byte
+  p_bus->read(AD1938_GLOBAL_ADDRESS, &reg, 1, &result, 1);
   return (result);
 }
 
 bool AD1938::spi_write_reg(unsigned char reg, unsigned char val) {
-  unsigned char data[AD1938_SPI_WRITE_BYTE_COUNT];
-
-  /*fill the buffer as per AD1938 format*/
-  data[0] = AD1938_WRITE_ADDRESS;
-  data[1] = reg;
-  data[2] = val;
-
-  // and configure settings
-  p_spi->beginTransaction(SPISettings(
-      AD1938_SPI_CLK_FREQ, MSBFIRST,
-      SPI_MODE3));  // 3
-                    //  take the chip select low to select the device:
-  digitalWrite(ad1938_clatch_pin, LOW);
-
-  p_spi->transfer(&data[0], AD1938_SPI_WRITE_BYTE_COUNT);
-  // take the chip select high to de-select:
-  digitalWrite(ad1938_clatch_pin, HIGH);
-  // release control of the SPI port
-  p_spi->endTransaction();
+  // the bus sends the 3 byte frame: AD1938_WRITE_ADDRESS, reg, val
+  return p_bus->write(AD1938_GLOBAL_ADDRESS, &reg, 1, &val, 1) == RESULT_OK;
+}
 
-  return true;
+bool AD1938::spi_write_seq(const i2c_reg_value_t *seq, int count) {
+  // the bus is claimed only once for all frames
+  return p_bus->writeSeq(AD1938_GLOBAL_ADDRESS, seq, count, false) ==
+         RESULT_OK;
 }
 
 bool AD1938::config() {
@@ -632,81 +615,86 @@ bool AD1938::config() {
 }
 
 bool AD1938::configMaster() {
-  // 0 PLL and Clock Control 0
-  spi_write_reg(AD1938_PLL_CLK_CTRL0, (DIS_ADC_DAC | INPUT512 | PLL_IN_MCLK |
-                                       MCLK_OUT_XTAL | PLL_PWR_DWN));
-
-  // 1 PLL and Clock Control 1
-  spi_write_reg(AD1938_PLL_CLK_CTRL1, (DAC_CLK_MCLK | ADC_CLK_MCLK | ENA_VREF));
-
-  // 2 DAC Control 0
-  spi_write_reg(AD1938_DAC_CTRL0,
-                (dac_mode | DAC_BCLK_DLY_1 | dac_fs | DAC_PWR_UP));
-
-  // 3 DAC Control 1
-  spi_write_reg(AD1938_DAC_CTRL1,
-                (DAC_BCLK_SRC_INTERNAL | DAC_BCLK_SLAVE | DAC_LRCLK_SLAVE |
-                 DAC_LRCLK_POL_NORM | dac_channels | DAC_LATCH_MID));
-
-  // 4 DAC Control 2
-  spi_write_reg(AD1938_DAC_CTRL2, dac_wl);
-
-  // 5 DAC individual channel mutes
-  spi_write_reg(AD1938_DAC_CHNL_MUTE, 0x00); /*unmute*/
-
-  setVolume(DACVOL_MAX);
-
-  // 14 ADC Control 0
-  spi_write_reg(AD1938_ADC_CTRL0, adc_fs);
-
-  // 15 ADC Control 1
-  spi_write_reg(AD1938_ADC_CTRL1,
-                (ADC_LATCH_MID | adc_mode | ADC_BCLK_DLY_1 | adc_wl));
-
-  // 16 ADC Control 2
-  spi_write_reg(AD1938_ADC_CTRL2,
-                (ADC_BCLK_SRC_INTERNAL | ADC_BCLK_MASTER | adc_channels |
-                 ADC_LRCLK_MASTER | ADC_LRCLK_FMT_50_50 | ADC_LRCLK_POL_NORM |
-                 ADC_BCLK_POL_NORM));
-  return true;
+  const i2c_reg_value_t seq[] = {
+      // 0 PLL and Clock Control 0
+      {AD1938_PLL_CLK_CTRL0, (DIS_ADC_DAC | INPUT512 | PLL_IN_MCLK |
+                              MCLK_OUT_XTAL | PLL_PWR_DWN)},
+      // 1 PLL and Clock Control 1
+      {AD1938_PLL_CLK_CTRL1, (DAC_CLK_MCLK | ADC_CLK_MCLK | ENA_VREF)},
+      // 2 DAC Control 0
+      {AD1938_DAC_CTRL0,
+       (unsigned char)(dac_mode | DAC_BCLK_DLY_1 | dac_fs | DAC_PWR_UP)},
+      // 3 DAC Control 1
+      {AD1938_DAC_CTRL1,
+       (unsigned char)(DAC_BCLK_SRC_INTERNAL | DAC_BCLK_SLAVE |
+                       DAC_LRCLK_SLAVE | DAC_LRCLK_POL_NORM | dac_channels |
+                       DAC_LATCH_MID)},
+      // 4 DAC Control 2
+      {AD1938_DAC_CTRL2, dac_wl},
+      // 5 DAC individual channel mutes
+      {AD1938_DAC_CHNL_MUTE, 0x00}, /*unmute*/
+      // 6-13 DAC volumes
+      {AD1938_DAC_L1_VOL, DACVOL_MAX},
+      {AD1938_DAC_R1_VOL, DACVOL_MAX},
+      {AD1938_DAC_L2_VOL, DACVOL_MAX},
+      {AD1938_DAC_R2_VOL, DACVOL_MAX},
+      {AD1938_DAC_L3_VOL, DACVOL_MAX},
+      {AD1938_DAC_R3_VOL, DACVOL_MAX},
+      {AD1938_DAC_L4_VOL, DACVOL_MAX},
+      {AD1938_DAC_R4_VOL, DACVOL_MAX},
+      // 14 ADC Control 0
+      {AD1938_ADC_CTRL0, adc_fs},
+      // 15 ADC Control 1
+      {AD1938_ADC_CTRL1,
+       (unsigned char)(ADC_LATCH_MID | adc_mode | ADC_BCLK_DLY_1 | adc_wl)},
+      // 16 ADC Control 2
+      {AD1938_ADC_CTRL2,
+       (unsigned char)(ADC_BCLK_SRC_INTERNAL | ADC_BCLK_MASTER | adc_channels |
+                       ADC_LRCLK_MASTER | ADC_LRCLK_FMT_50_50 |
+                       ADC_LRCLK_POL_NORM | ADC_BCLK_POL_NORM)},
+  };
+  return spi_write_seq(seq, sizeof(seq) / sizeof(seq[0]));
 }
-bool AD1938::configSlave() {
-  // 0 PLL and Clock Control 0
-  spi_write_reg(AD1938_PLL_CLK_CTRL0, (DIS_ADC_DAC | INPUT512 | PLL_IN_ALRCLK |
-                                       MCLK_OUT_OFF | PLL_PWR_DWN));
-
-  // 1 PLL and Clock Control 1
-  spi_write_reg(AD1938_PLL_CLK_CTRL1, (DAC_CLK_PLL | ADC_CLK_PLL | ENA_VREF));
 
-  // 2 DAC Control 0
-  spi_write_reg(AD1938_DAC_CTRL0,
-                (dac_mode | DAC_BCLK_DLY_1 | dac_fs | DAC_PWR_UP));
-
-  // 3 DAC Control 1
-  spi_write_reg(AD1938_DAC_CTRL1,
-                (DAC_BCLK_SRC_PIN | DAC_BCLK_SLAVE | DAC_LRCLK_SLAVE |
-                 DAC_LRCLK_POL_NORM | dac_channels | DAC_LATCH_MID));
-  // 4 DAC Control 2
-  spi_write_reg(AD1938_DAC_CTRL2, dac_wl);
-
-  // 5 DAC individual channel mutes
-  spi_write_reg(AD1938_DAC_CHNL_MUTE, 0x00); /*mute*/
-
-  setVolume(DACVOL_MAX);
-
-  // 14 ADC Control 0
-  spi_write_reg(AD1938_ADC_CTRL0, adc_fs);
-
-  // 15 ADC Control 1
-  spi_write_reg(AD1938_ADC_CTRL1,
-                (ADC_LATCH_MID | adc_mode | ADC_BCLK_DLY_0 | adc_wl));
-
-  // 16 ADC Control 2
-  spi_write_reg(
-      AD1938_ADC_CTRL2,
-      (ADC_BCLK_SRC_PIN | ADC_BCLK_SLAVE | adc_channels | ADC_LRCLK_SLAVE |
-       ADC_LRCLK_FMT_50_50 | ADC_LRCLK_POL_NORM | ADC_BCLK_POL_NORM));
-  return true;
+bool AD1938::configSlave() {
+  const i2c_reg_value_t seq[] = {
+      // 0 PLL and Clock Control 0
+      {AD1938_PLL_CLK_CTRL0, (DIS_ADC_DAC | INPUT512 | PLL_IN_ALRCLK |
+                              MCLK_OUT_OFF | PLL_PWR_DWN)},
+      // 1 PLL and Clock Control 1
+      {AD1938_PLL_CLK_CTRL1, (DAC_CLK_PLL | ADC_CLK_PLL | ENA_VREF)},
+      // 2 DAC Control 0
+      {AD1938_DAC_CTRL0,
+       (unsigned char)(dac_mode | DAC_BCLK_DLY_1 | dac_fs | DAC_PWR_UP)},
+      // 3 DAC Control 1
+      {AD1938_DAC_CTRL1,
+       (unsigned char)(DAC_BCLK_SRC_PIN | DAC_BCLK_SLAVE | DAC_LRCLK_SLAVE |
+                       DAC_LRCLK_POL_NORM | dac_channels | DAC_LATCH_MID)},
+      // 4 DAC Control 2
+      {AD1938_DAC_CTRL2, dac_wl},
+      // 5 DAC individual channel mutes
+      {AD1938_DAC_CHNL_MUTE, 0x00}, /*mute*/
+      // 6-13 DAC volumes
+      {AD1938_DAC_L1_VOL, DACVOL_MAX},
+      {AD1938_DAC_R1_VOL, DACVOL_MAX},
+      {AD1938_DAC_L2_VOL, DACVOL_MAX},
+      {AD1938_DAC_R2_VOL, DACVOL_MAX},
+      {AD1938_DAC_L3_VOL, DACVOL_MAX},
+      {AD1938_DAC_R3_VOL, DACVOL_MAX},
+      {AD1938_DAC_L4_VOL, DACVOL_MAX},
+      {AD1938_DAC_R4_VOL, DACVOL_MAX},
+      // 14 ADC Control 0
+      {AD1938_ADC_CTRL0, adc_fs},
+      // 15 ADC Control 1
+      {AD1938_ADC_CTRL1,
+       (unsigned char)(ADC_LATCH_MID | adc_mode | ADC_BCLK_DLY_0 | adc_wl)},
+      // 16 ADC Control 2
+      {AD1938_ADC_CTRL2,
+       (unsigned char)(ADC_BCLK_SRC_PIN | ADC_BCLK_SLAVE | adc_channels |
+                       ADC_LRCLK_SLAVE | ADC_LRCLK_FMT_50_50 |
+                       ADC_LRCLK_POL_NORM | ADC_BCLK_POL_NORM)},
+  };
+  return spi_write_seq(seq, sizeof(seq) / sizeof(seq[0]));
 }
 
 bool AD1938::isPllLocked(void) {
@@ -746,11 +734,21 @@ bool AD1938::disable(void) {
 }
 
 bool AD1938::setVolumeDAC(int dac_num, int volume) {
-  if (dac_num > 3) return false;
-  spi_write_reg(AD1938_DAC_L1_VOL + dac_num, volume);
-  spi_write_reg(AD1938_DAC_R1_VOL + dac_num, volume);
+  if (dac_num < 0 || dac_num > 3) return false;
+  // the left and right volume registers of a DAC are next to each other
+  const i2c_reg_value_t seq[] = {
+      {(uint8_t)(AD1938_DAC_L1_VOL + 2 * dac_num), (uint8_t)volume},
+      {(uint8_t)(AD1938_DAC_R1_VOL + 2 * dac_num), (uint8_t)volume}};
+  return spi_write_seq(seq, 2);
+}
 
-  return true;
+bool AD1938::setVolume(int volume) {
+  i2c_reg_value_t seq[8];
+  for (int j = 0; j < 8; j++) {
+    seq[j].reg = AD1938_DAC_L1_VOL + j;
+    seq[j].value = volume;
+  }
+  return spi_write_seq(seq, 8);
 }
 
 bool AD1938::setMuteDAC(bool mute) {
@@ -27,6 +27,7 @@
 #include <SPI.h>
 #include "DriverCommon.h"
 #include "Driver/DriverConstants.h"
+#include "Utils/ControlBus.h"
 
 /**
  * @brief The AD1938 is a high performance, single-chip codec that pro-
@@ -42,6 +43,23 @@ class AD1938 {
   bool begin(codec_config_t cfg, int clatchPin, int resetPin,
              SPIClass &spi = SPI);
 
+  /// Starts the processing using the indicated ControlBus for the register
+  /// access
+  bool begin(codec_config_t cfg, int resetPin, ControlBus &bus);
+
+  /// Defines the configuration, reset pin and SPI without any bus access:
+  /// begin() in steps is setup(), setReset(true), setReset(false), config()
+  void setup(codec_config_t cfg, int clatchPin, int resetPin,
+             SPIClass &spi = SPI);
+  /// Defines the configuration, reset pin and ControlBus without any bus
+  /// access
+  void setup(codec_config_t cfg, int resetPin, ControlBus &bus);
+  /// Activates (true) or releases (false) the reset: the codec needs 200ms
+  /// in reset and 400ms after the release to load the code
+  void setReset(bool active);
+  /// Writes the configuration registers
+  bool config();
+
   bool end() {
     setMute(true);
     return disable();
@@ -51,18 +69,12 @@ class AD1938 {
   
   bool disable(void);
 
-  bool setVolume(float volume) {
-    int vol = scaleVolume(volume);
-    for (int j = 0; j > 4; j++) setVolumeDAC(j, vol);
-    return true;
-  }
+  bool setVolume(float volume) { return setVolume(scaleVolume(volume)); }
   bool setVolume(int dac, float volume) {
     return setVolumeDAC(dac, scaleVolume(volume));
   }
-  bool setVolume(int volume) {
-    for (int j = 0; j > 4; j++) setVolumeDAC(j, volume);
-    return true;
-  }
+  /// Sets the attenuation (0: 0dB, 255: -95dB) of all DACs with one bus claim
+  bool setVolume(int volume);
   bool setVolumeDAC(int dac, int volume);
 
   bool setMuteADC(bool mute);
@@ -73,9 +85,9 @@ class AD1938 {
 
  protected:
   codec_config_t cfg;
-  int ad1938_clatch_pin;
   int ad1938_reset_pin;
-  SPIClass *p_spi = nullptr;
+  ControlBusSPI spi_bus;
+  ControlBus *p_bus = &spi_bus;
   unsigned char dac_fs = 0;
   unsigned char adc_fs = 0;
   unsigned char dac_mode = 0;
@@ -85,10 +97,10 @@ class AD1938 {
   unsigned char dac_channels = 0;
   unsigned char adc_channels = 0;
 
-  bool config();
   bool configMaster();
   bool configSlave();
   bool spi_write_reg(unsigned char reg, unsigned char val);
+  bool spi_write_seq(const i2c_reg_value_t *seq, int count);
   unsigned char spi_read_reg(unsigned char reg);
   bool isPllLocked();
   int scaleVolume(float volume) {
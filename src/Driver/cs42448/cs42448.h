@@ -27,6 +27,7 @@
 #include "DriverCommon.h"
 #include "Driver/DriverConstants.h"
 #include "Utils/I2C.h"
+#include "Utils/RegisterMap.h"
 
 /*
  *  Definitions for Audio registers for CS42448
@@ -153,6 +154,9 @@ class CS42448 {
     if (i2cAddress > 0) {
       this->i2c_address = i2cAddress;
     }
+    // the chip state is unknown: the status is always read from the chip
+    regs.invalidate();
+    regs.setVolatile(CS42448_Status);
 
     if (is_active){
       setMuteADC(true);
@@ -234,12 +238,9 @@ class CS42448 {
   }
   // line starts at 0
   bool setMuteDAC(uint8_t line, bool mute) {
-    uint8_t mute_reg_value;
     if (line >= 8) return false;
-    if (!readReg(CS42448_DAC_Channel_Mute, &mute_reg_value)) return false;
-    setBit(mute_reg_value, line, mute);
-    if (!writeReg(CS42448_DAC_Channel_Mute, mute_reg_value)) return false;
-    return true;
+    uint8_t mask = 1 << line;
+    return updateReg(CS42448_DAC_Channel_Mute, mask, mute ? mask : 0);
   }
 
   bool setMuteDAC(bool mute) {
@@ -251,14 +252,27 @@ class CS42448 {
   }
 
   bool setMuteADC(bool mute) {
-    uint8_t transition_ctl;
+    return updateReg(CS42448_Transition_Control, 0x08, mute ? 0xFF : 0);
+  }
+
+  bool setMute(bool mute) { return setMuteADC(mute) && setMuteDAC(mute); }
+
+  /// Provides the DAC mute bits (bit n: line n) and the ADC mute
+  bool getMuteState(uint8_t& dac, bool& adc) {
+    uint8_t transition_ctl = 0;
+    if (!readReg(CS42448_DAC_Channel_Mute, &dac)) return false;
     if (!readReg(CS42448_Transition_Control, &transition_ctl)) return false;
-    setBit(transition_ctl, 3, mute);
-    if (!writeReg(CS42448_Transition_Control, transition_ctl)) return false;
+    adc = transition_ctl & 0x08;
     return true;
   }
 
-  bool setMute(bool mute) { return setMuteADC(mute) && setMuteDAC(mute); }
+  /// Restores the mute state which was provided by getMuteState()
+  bool setMuteState(uint8_t dac, bool adc) {
+    freeze(true);
+    if (!writeReg(CS42448_DAC_Channel_Mute, dac)) return false;
+    freeze(false);
+    return setMuteADC(adc);
+  }
 
   bool setVolumeDAC(uint8_t vol) {
     freeze(true);
@@ -357,61 +371,34 @@ class CS42448 {
 
   /// Device Power
   bool setPower(bool active) {
-    uint8_t power;
-    if (!readReg(CS42448_Power_Control, &power)) return false;
-    setBit(power, 0, active);
-    if (!writeReg(CS42448_Power_Control, power)) return false;
-    return true;
+    return updateReg(CS42448_Power_Control, 0x01, active ? 0xFF : 0);
   }
 
   /// Power on individual DAC from 1 to 4
   bool setPowerDAC(int dac, bool active) {
-    uint8_t power;
     if (dac >= 4) return false;
-    if (!readReg(CS42448_Power_Control, &power)) return false;
-    setBit(power, dac, active);
-    if (!writeReg(CS42448_Power_Control, power)) return false;
-    return true;
+    uint8_t mask = 1 << dac;
+    return updateReg(CS42448_Power_Control, mask, active ? mask : 0);
   }
 
   bool setPowerDAC(bool active) {
-    uint8_t power;
-    if (!readReg(CS42448_Power_Control, &power)) return false;
-    setBit(power, 1, active);
-    setBit(power, 2, active);
-    setBit(power, 3, active);
-    setBit(power, 4, active);
-    if (!writeReg(CS42448_Power_Control, power)) return false;
-    return true;
+    return updateReg(CS42448_Power_Control, 0x1E, active ? 0xFF : 0);
   }
 
   /// Power on individual ADC from 1 to 3
   bool setPowerADC(int adc, bool active) {
-    uint8_t power;
     if (adc > 3) return false;
-    if (!readReg(CS42448_Power_Control, &power)) return false;
-    setBit(power, adc + 4, active);
-    if (!writeReg(CS42448_Power_Control, power)) return false;
-    return true;
+    uint8_t mask = 1 << (adc + 4);
+    return updateReg(CS42448_Power_Control, mask, active ? mask : 0);
   }
 
   bool setPowerADC(bool active) {
-    uint8_t power;
-    if (!readReg(CS42448_Power_Control, &power)) return false;
-    setBit(power, 5, active);
-    setBit(power, 6, active);
-    setBit(power, 7, active);
-    if (!writeReg(CS42448_Power_Control, power)) return false;
-    return true;
+    return updateReg(CS42448_Power_Control, 0xE0, active ? 0xFF : 0);
   }
 
   /// All mute and volume values are activated on unfreeze
   bool freeze(bool freeze) {
-    uint8_t fmt;
-    if (!readReg(CS42448_Interface_Formats, &fmt)) return false;
-    setBit(fmt, 7, freeze);
-    if (!writeReg(CS42448_Interface_Formats, fmt)) return false;
-    return true;
+    return updateReg(CS42448_Interface_Formats, 0x80, freeze ? 0xFF : 0);
   }
 
   bool setFormat(CS42448::Format fmt) {
@@ -433,19 +420,12 @@ class CS42448 {
   }
 
   bool setAutoMute(bool autoMute) {
-    uint8_t transition_ctl;
-    if (!readReg(CS42448_Transition_Control, &transition_ctl)) return false;
-    setBit(transition_ctl, 4, autoMute);
-    if (!writeReg(CS42448_Transition_Control, transition_ctl)) return false;
-    return true;
+    return updateReg(CS42448_Transition_Control, 0x10, autoMute ? 0xFF : 0);
   }
 
   bool setDACInvert(uint8_t channel, int invert) {
-    uint8_t invert_reg_value;
-    if (!readReg(CS42448_DAC_Channel_Invert, &invert_reg_value)) return false;
-    setBit(invert_reg_value, channel, invert);
-    if (!writeReg(CS42448_DAC_Channel_Invert, invert_reg_value)) return false;
-    return true;
+    uint8_t mask = 1 << channel;
+    return updateReg(CS42448_DAC_Channel_Invert, mask, invert ? mask : 0);
   }
 
   bool setDACInvert(int invert) {
@@ -455,11 +435,8 @@ class CS42448 {
   }
 
   bool setADCInvert(uint8_t channel, int invert) {
-    uint8_t invert_reg_value;
-    if (!readReg(CS42448_ADC_Channel_Invert, &invert_reg_value)) return false;
-    setBit(invert_reg_value, channel, invert);
-    if (!writeReg(CS42448_ADC_Channel_Invert, invert_reg_value)) return false;
-    return true;
+    uint8_t mask = 1 << channel;
+    return updateReg(CS42448_ADC_Channel_Invert, mask, invert ? mask : 0);
   }
 
   bool setADCInvert(int invert) {
@@ -483,57 +460,28 @@ class CS42448 {
   }
 
   bool setADCHighPassFilterFreeze12(bool freeze) {
-    uint8_t control_reg_value;
-    if (!readReg(CS42448_ADC_Control_DAC_DeEmphasis, &control_reg_value))
-      return false;
-    setBit(control_reg_value, 7, freeze);
-    if (!writeReg(CS42448_ADC_Control_DAC_DeEmphasis, control_reg_value))
-      return false;
-    return true;
+    return updateReg(CS42448_ADC_Control_DAC_DeEmphasis, 0x80,
+                     freeze ? 0xFF : 0);
   }
 
   bool setADCHighPassFilterFreeze3(bool freeze) {
-    uint8_t control_reg_value;
-    if (!readReg(CS42448_ADC_Control_DAC_DeEmphasis, &control_reg_value))
-      return false;
-    setBit(control_reg_value, 6, freeze);
-    if (!writeReg(CS42448_ADC_Control_DAC_DeEmphasis, control_reg_value))
-      return false;
-    return true;
+    return updateReg(CS42448_ADC_Control_DAC_DeEmphasis, 0x40,
+                     freeze ? 0xFF : 0);
   }
 
   bool setDACDeEmphasisControl(bool on) {
-    uint8_t control_reg_value;
-    if (!readReg(CS42448_ADC_Control_DAC_DeEmphasis, &control_reg_value))
-      return false;
-    setBit(control_reg_value, 6, on);
-    if (!writeReg(CS42448_ADC_Control_DAC_DeEmphasis, control_reg_value))
-      return false;
-    return true;
+    return updateReg(CS42448_ADC_Control_DAC_DeEmphasis, 0x40, on ? 0xFF : 0);
   }
 
   bool setADCSingleEnded(int adc, bool on) {
-    uint8_t control_reg_value;
     if (adc > 3) return false;
     if (adc < 1) return false;
-    if (!readReg(CS42448_ADC_Control_DAC_DeEmphasis, &control_reg_value))
-      return false;
-    setBit(control_reg_value, 5 - adc, on);
-    if (!writeReg(CS42448_ADC_Control_DAC_DeEmphasis, control_reg_value))
-      return false;
-    return true;
+    uint8_t mask = 1 << (5 - adc);
+    return updateReg(CS42448_ADC_Control_DAC_DeEmphasis, mask, on ? mask : 0);
   }
 
   bool setADCSingleEnded(bool on) {
-    uint8_t control_reg_value;
-    if (!readReg(CS42448_ADC_Control_DAC_DeEmphasis, &control_reg_value))
-      return false;
-    setBit(control_reg_value, 2, on);
-    setBit(control_reg_value, 3, on);
-    setBit(control_reg_value, 4, on);
-    if (!writeReg(CS42448_ADC_Control_DAC_DeEmphasis, control_reg_value))
-      return false;
-    return true;
+    return updateReg(CS42448_ADC_Control_DAC_DeEmphasis, 0x1C, on ? 0xFF : 0);
   }
 
   uint8_t getChipID() {
@@ -553,6 +501,7 @@ class CS42448 {
   i2c_bus_handle_t i2c;
   int i2c_address = 0x48;
   bool is_active = false;
+  RegisterMap<CS42448_MUTEC_Pin_Control + 1> regs;
 
   /// Set I2S format based on codec_config
   bool setFormat() {
@@ -582,16 +531,37 @@ class CS42448 {
   bool writeReg(uint8_t reg, uint8_t value) { return writeReg(reg, &value, 1); }
 
   bool writeReg(uint8_t reg, uint8_t* value, int len) {
-    return i2c_bus_write_bytes(i2c, i2c_address, &reg, 1, value, len) ==
-           RESULT_OK;
+    if (i2c_bus_write_bytes(i2c, i2c_address, &reg, 1, value, len) !=
+        RESULT_OK)
+      return false;
+    for (int j = 0; j < len; j++) regs.store(reg + j, value[j]);
+    return true;
   }
 
+  /// Reads the registers: known values are taken from the register map
   bool readReg(uint8_t reg, uint8_t* outdata, int datalen = 1) {
-    return i2c_bus_read_bytes(i2c, i2c_address, &reg, 1, outdata, datalen) ==
-           RESULT_OK;
+    bool is_cached = true;
+    for (int j = 0; j < datalen; j++) {
+      if (!regs.isValid(reg + j)) is_cached = false;
+    }
+    if (is_cached) {
+      for (int j = 0; j < datalen; j++) outdata[j] = regs.get(reg + j);
+      return true;
+    }
+    if (i2c_bus_read_bytes(i2c, i2c_address, &reg, 1, outdata, datalen) !=
+        RESULT_OK)
+      return false;
+    for (int j = 0; j < datalen; j++) regs.store(reg + j, outdata[j]);
+    return true;
   }
 
-  inline uint8_t setBit(uint8_t number, uint8_t n, bool x) {
-    return (number & ~((uint8_t)1 << n)) | ((uint8_t)x << n);
+  /// Read-modify-write of the bits in mask: the current value is taken from
+  /// the register map and the register is only written if the value changes
+  bool updateReg(uint8_t reg, uint8_t mask, uint8_t value) {
+    uint8_t reg_value;
+    if (!readReg(reg, &reg_value)) return false;
+    uint8_t new_value = (reg_value & ~mask) | (value & mask);
+    if (new_value == reg_value && regs.isValid(reg)) return true;
+    return writeReg(reg, new_value);
   }
 };
@@ -34,6 +34,7 @@
   */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
 #include "cs43l22.h"
 
 /** @addtogroup BSP
@@ -114,6 +115,29 @@ volatile uint8_t OutputDev = 0;
   * @{
   */
 static uint8_t CODEC_IO_Write(uint8_t Addr, uint8_t Reg, uint8_t Value);
+static uint8_t CODEC_IO_WriteSeq(uint8_t Addr, const i2c_seq_t *Seq, int Count);
+
+/* Set the Speaker Mono mode and the Speaker attenuation level */
+static const i2c_seq_t speaker_seq[] = {
+  {I2C_SEQ_WRITE, CS43L22_REG_PLAYBACK_CTL2, 0x06, 0},
+  {I2C_SEQ_WRITE, CS43L22_REG_SPEAKER_A_VOL, 0x00, 0},
+  {I2C_SEQ_WRITE, CS43L22_REG_SPEAKER_B_VOL, 0x00, 0},
+};
+
+/* Settings which reduce the time needed for the Codec to power off */
+static const i2c_seq_t power_off_seq[] = {
+  /* Disable the analog soft ramp */
+  {I2C_SEQ_WRITE, CS43L22_REG_ANALOG_ZC_SR_SETT, 0x00, 0},
+  /* Disable the digital soft ramp */
+  {I2C_SEQ_WRITE, CS43L22_REG_MISC_CTL, 0x04, 0},
+  /* Disable the limiter attack level */
+  {I2C_SEQ_WRITE, CS43L22_REG_LIMIT_CTL1, 0x00, 0},
+  /* Adjust Bass and Treble levels */
+  {I2C_SEQ_WRITE, CS43L22_REG_TONE_CTL, 0x0F, 0},
+  /* Adjust PCM volume level */
+  {I2C_SEQ_WRITE, CS43L22_REG_PCMA_VOL, 0x0A, 0},
+  {I2C_SEQ_WRITE, CS43L22_REG_PCMB_VOL, 0x0A, 0},
+};
 /**
   * @}
   */ 
@@ -138,9 +162,6 @@ uint32_t cs43l22_Init(uint16_t DeviceAddr, uint16_t OutputDevice, uint8_t Volume
   /* Initialize the Control interface of the Audio Codec */
   AUDIO_IO_Init();     
     
-  /* Keep Codec powered OFF */
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_POWER_CTL1, 0x01);  
-  
   /*Save Output device for mute ON/OFF procedure*/
   switch (OutputDevice)
   {
@@ -165,13 +186,16 @@ uint32_t cs43l22_Init(uint16_t DeviceAddr, uint16_t OutputDevice, uint8_t Volume
     break;    
   }
   
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_POWER_CTL2, OutputDev);
-  
-  /* Clock configuration: Auto detection */  
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_CLOCKING_CTL, 0x81);
-  
-  /* Set the Slave Mode and the audio Standard */  
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_INTERFACE_CTL1, CODEC_STANDARD);
+  const i2c_seq_t start_seq[] = {
+    /* Keep Codec powered OFF */
+    {I2C_SEQ_WRITE, CS43L22_REG_POWER_CTL1, 0x01, 0},
+    {I2C_SEQ_WRITE, CS43L22_REG_POWER_CTL2, OutputDev, 0},
+    /* Clock configuration: Auto detection */  
+    {I2C_SEQ_WRITE, CS43L22_REG_CLOCKING_CTL, 0x81, 0},
+    /* Set the Slave Mode and the audio Standard */  
+    {I2C_SEQ_WRITE, CS43L22_REG_INTERFACE_CTL1, CODEC_STANDARD, 0},
+  };
+  counter += CODEC_IO_WriteSeq(DeviceAddr, start_seq, sizeof(start_seq) / sizeof(start_seq[0]));
   
   /* Set the Master volume */
   counter += cs43l22_SetVolume(DeviceAddr, Volume);
@@ -179,12 +203,7 @@ uint32_t cs43l22_Init(uint16_t DeviceAddr, uint16_t OutputDevice, uint8_t Volume
   /* If the Speaker is enabled, set the Mono mode and volume attenuation level */
   if(OutputDevice != OUTPUT_DEVICE_HEADPHONE)
   {
-    /* Set the Speaker Mono mode */  
-    counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_PLAYBACK_CTL2, 0x06);
-    
-    /* Set the Speaker attenuation level */  
-    counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_SPEAKER_A_VOL, 0x00);
-    counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_SPEAKER_B_VOL, 0x00);
+    counter += CODEC_IO_WriteSeq(DeviceAddr, speaker_seq, sizeof(speaker_seq) / sizeof(speaker_seq[0]));
   }
   
   /* Additional configuration for the CODEC. These configurations are done to reduce
@@ -193,18 +212,7 @@ uint32_t cs43l22_Init(uint16_t DeviceAddr, uint16_t OutputDevice, uint8_t Volume
   off the I2S peripheral MCLK clock (which is the operating clock for Codec).
   If this delay is not inserted, then the codec will not shut down properly and
   it results in high noise after shut down. */
-  
-  /* Disable the analog soft ramp */
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_ANALOG_ZC_SR_SETT, 0x00);
-  /* Disable the digital soft ramp */
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_MISC_CTL, 0x04);
-  /* Disable the limiter attack level */
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_LIMIT_CTL1, 0x00);
-  /* Adjust Bass and Treble levels */
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_TONE_CTL, 0x0F);
-  /* Adjust PCM volume level */
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_PCMA_VOL, 0x0A);
-  counter += CODEC_IO_Write(DeviceAddr, CS43L22_REG_PCMB_VOL, 0x0A);
+  counter += CODEC_IO_WriteSeq(DeviceAddr, power_off_seq, sizeof(power_off_seq) / sizeof(power_off_seq[0]));
   
   /* Return communication control value */
   return counter;  
@@ -475,11 +483,40 @@ static uint8_t CODEC_IO_Write(uint8_t Addr, uint8_t Reg, uint8_t Value)
   return result;
 }
 
+/**
+  * @brief  Writes a register sequence: the registers are addressed individually
+  *         because the auto-increment needs the MSB of the register address.
+  * @param  Addr: I2C address
+  * @param  Seq: register sequence
+  * @param  Count: number of entries
+  * @retval 0 if correct communication, else wrong communication
+  */
+static uint8_t CODEC_IO_WriteSeq(uint8_t Addr, const i2c_seq_t *Seq, int Count)
+{
+  uint8_t result = i2c_bus_run_seq(i2c_handle, Addr, NULL, Seq, Count, false) == RESULT_OK ? 0 : 1;
+  
+#ifdef VERIFY_WRITTENDATA
+  /* Verify that the data has been correctly written */  
+  for (int j = 0; j < Count; j++)
+  {
+    if (Seq[j].op == I2C_SEQ_WRITE && AUDIO_IO_Read(Addr, Seq[j].reg) != Seq[j].value)
+      result = 1;
+  }
+#endif /* VERIFY_WRITTENDATA */
+  
+  return result;
+}
+
 void      AUDIO_IO_Init(void) {}
 void      AUDIO_IO_DeInit(void) {}
 void      AUDIO_IO_Write(uint8_t addr, uint8_t reg, uint8_t value) {
   i2c_bus_write_bytes(i2c_handle, addr, &reg, 1, &value, 1);
 }
+uint8_t   AUDIO_IO_Read(uint8_t addr, uint8_t reg) {
+  uint8_t value = 0;
+  i2c_bus_read_bytes(i2c_handle, addr, &reg, 1, &value, 1);
+  return value;
+}
 
 
 /**
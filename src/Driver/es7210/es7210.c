@@ -53,6 +53,8 @@ struct _coeff_div {
 };
 
 static i2c_bus_handle_t i2c_handle;
+/* write-through image of the registers, so that bit updates need no read */
+static i2c_reg_map_t *es7210_regs = NULL;
 static es7210_input_mics_t mic_select = ES7210_INPUT_MIC1 | ES7210_INPUT_MIC2;         /* Number of microphones */
 
 /* Codec hifi mclk clock divider coefficients
@@ -120,29 +122,89 @@ static const struct _coeff_div coeff_div[] = {
     {19200000,  96000,  0x01,  0x05,  0x00,  0x01,  0x28,  0x00,    0x00,  0xc8},
 };
 
+/*
+ * Rows of coeff_div[] for each lrck (sorted by lrck): this index must be
+ * updated together with the table
+ */
+struct _coeff_range {
+    uint32_t lrck;
+    uint8_t  first;
+    uint8_t  count;
+};
+
+static const struct _coeff_range coeff_ranges[] = {
+    {8000 ,   0,  4},
+    {11025,   4,  1},
+    {12000,   5,  2},
+    {16000,   7,  4},
+    {22050,  11,  1},
+    {24000,  12,  2},
+    {32000,  14,  3},
+    {44100,  17,  1},
+    {48000,  18,  2},
+    {64000,  20,  2},
+    {88200,  22,  1},
+    {96000,  23,  2},
+};
+
 static error_t es7210_write_reg(uint8_t reg_addr, uint8_t data)
 {
-    return i2c_bus_write_bytes(i2c_handle, ES7210_ADDR, &reg_addr, sizeof(reg_addr), &data, sizeof(data));
+    return i2c_bus_write_reg_cached(i2c_handle, ES7210_ADDR, es7210_regs, reg_addr, data);
+}
+
+static error_t es7210_run_seq(const i2c_seq_t *seq, int count)
+{
+    return i2c_bus_run_seq(i2c_handle, ES7210_ADDR, es7210_regs, seq, count, ES_I2C_AUTO_INCREMENT);
 }
 
 static error_t es7210_update_reg_bit(uint8_t reg_addr, uint8_t update_bits, uint8_t data)
 {
-    uint8_t regv;
-    regv = es7210_read_reg(reg_addr);
-    regv = (regv & (~update_bits)) | (update_bits & data);
-    return es7210_write_reg(reg_addr, regv);
+    return i2c_bus_update_reg_cached(i2c_handle, ES7210_ADDR, es7210_regs, reg_addr, update_bits, data);
 }
 
 
-static int get_coeff(uint32_t mclk, uint32_t lrck)
+static const struct _coeff_range *get_coeff_range(uint32_t lrck)
 {
-    for (unsigned i = 0; i < (sizeof(coeff_div) / sizeof(coeff_div[0])); i++) {
-        if (coeff_div[i].lrck == lrck && coeff_div[i].mclk == mclk)
+    int low = 0;
+    int high = sizeof(coeff_ranges) / sizeof(coeff_ranges[0]) - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (coeff_ranges[mid].lrck == lrck)
+            return &coeff_ranges[mid];
+        if (coeff_ranges[mid].lrck < lrck)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return NULL;
+}
+
+int es7210_get_coeff(uint32_t mclk, uint32_t lrck)
+{
+    const struct _coeff_range *range = get_coeff_range(lrck);
+    if (range == NULL)
+        return -1;
+    for (int i = range->first; i < range->first + range->count; i++) {
+        if (coeff_div[i].mclk == mclk)
             return i;
     }
     return -1;
 }
 
+int es7210_get_rates(uint32_t mclk, uint32_t *rates, int max)
+{
+    int count = 0;
+    for (unsigned i = 0; i < (sizeof(coeff_ranges) / sizeof(coeff_ranges[0])); i++) {
+        uint32_t lrck = coeff_ranges[i].lrck;
+        if (es7210_get_coeff(mclk != 0 ? mclk : lrck * MCLK_DIV_FRE, lrck) < 0)
+            continue;
+        if (rates != NULL && count < max)
+            rates[count] = lrck;
+        count++;
+    }
+    return count;
+}
+
 int8_t get_es7210_mclk_src(void)
 {
     return ES7210_MCLK_SOURCE;
@@ -150,18 +212,19 @@ int8_t get_es7210_mclk_src(void)
 
 int es7210_read_reg(uint8_t reg_addr)
 {
-    uint8_t data;
-    i2c_bus_read_bytes(i2c_handle, ES7210_ADDR, &reg_addr, sizeof(reg_addr), &data, sizeof(data));
+    uint8_t data = 0;
+    i2c_bus_read_reg_cached(i2c_handle, ES7210_ADDR, es7210_regs, reg_addr, &data);
     return (int)data;
 }
 
-error_t es7210_config_sample(samplerate_t sample)
+/*
+ * Determines the coeff_div[] entry for the sample rate: -1 if it is not supported
+ */
+static int es7210_get_sample_coeff(samplerate_t sample)
 {
-    uint8_t regv;
     int coeff;
     int sample_fre = 0;
     int mclk_fre = 0;
-    error_t ret = RESULT_OK;
     switch (sample) {
         case RATE_8K:
             sample_fre = 8000;
@@ -192,9 +255,19 @@ error_t es7210_config_sample(samplerate_t sample)
             break;
     }
     mclk_fre = sample_fre * MCLK_DIV_FRE;
-    coeff = get_coeff(mclk_fre, sample_fre);
+    coeff = es7210_get_coeff(mclk_fre, sample_fre);
     if (coeff < 0) {
         AD_LOGE( "Unable to configure sample rate %dHz with %dHz MCLK", sample_fre, mclk_fre);
+    }
+    return coeff;
+}
+
+error_t es7210_config_sample(samplerate_t sample)
+{
+    uint8_t regv;
+    error_t ret = RESULT_OK;
+    int coeff = es7210_get_sample_coeff(sample);
+    if (coeff < 0) {
         return RESULT_FAIL;
     }
     /* Set clock parammeters */
@@ -258,19 +331,38 @@ error_t es7210_mic_select(es7210_input_mics_t mic)
     return ret;
 }
 
+error_t es7210_adc_reset(void* i2c)
+{
+    uint8_t reg = ES7210_RESET_REG00;
+    uint8_t value = 0xff;
+    return i2c_bus_write_bytes(i2c, ES7210_ADDR, &reg, 1, &value, 1);
+}
+
 error_t es7210_adc_init(codec_config_t *codec_cfg, void* i2c)
 {
     i2c_handle = i2c;
     error_t ret = RESULT_OK;
-    ret |= es7210_write_reg(ES7210_RESET_REG00, 0xff);
-    ret |= es7210_write_reg(ES7210_RESET_REG00, 0x41);
-    ret |= es7210_write_reg(ES7210_CLOCK_OFF_REG01, 0x1f);
-    ret |= es7210_write_reg(ES7210_TIME_CONTROL0_REG09, 0x30);      /* Set chip state cycle */
-    ret |= es7210_write_reg(ES7210_TIME_CONTROL1_REG0A, 0x30);      /* Set power on state cycle */
-    ret |= es7210_write_reg(ES7210_ADC12_HPF2_REG23, 0x2a);         /* Quick setup */
-    ret |= es7210_write_reg(ES7210_ADC12_HPF1_REG22, 0x0a);
-    ret |= es7210_write_reg(ES7210_ADC34_HPF2_REG20, 0x0a);
-    ret |= es7210_write_reg(ES7210_ADC34_HPF1_REG21, 0x2a);
+    /* unsupported rates are rejected before the chip is changed */
+    if (es7210_get_sample_coeff(codec_cfg->i2s.rate) < 0) {
+        return RESULT_FAIL;
+    }
+    /* the reset below restores the default values: forget the old ones */
+    i2c_reg_map_release(es7210_regs);
+    es7210_regs = i2c_reg_map_get(i2c_handle, ES7210_ADDR);
+    i2c_reg_map_invalidate(es7210_regs);
+    i2c_reg_map_set_volatile(es7210_regs, ES7210_RESET_REG00);
+    const i2c_seq_t reset_seq[] = {
+        {I2C_SEQ_WRITE, ES7210_RESET_REG00, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_RESET_REG00, 0x41, 0},
+        {I2C_SEQ_WRITE, ES7210_CLOCK_OFF_REG01, 0x1f, 0},
+        {I2C_SEQ_WRITE, ES7210_TIME_CONTROL0_REG09, 0x30, 0},     /* Set chip state cycle */
+        {I2C_SEQ_WRITE, ES7210_TIME_CONTROL1_REG0A, 0x30, 0},     /* Set power on state cycle */
+        {I2C_SEQ_WRITE, ES7210_ADC12_HPF2_REG23, 0x2a, 0},        /* Quick setup */
+        {I2C_SEQ_WRITE, ES7210_ADC12_HPF1_REG22, 0x0a, 0},
+        {I2C_SEQ_WRITE, ES7210_ADC34_HPF2_REG20, 0x0a, 0},
+        {I2C_SEQ_WRITE, ES7210_ADC34_HPF1_REG21, 0x2a, 0},
+    };
+    ret |= es7210_run_seq(reset_seq, sizeof(reset_seq) / sizeof(reset_seq[0]));
     /* Set master/slave audio interface */
     I2SDefinition *i2s_cfg = & (codec_cfg->i2s);
     switch (i2s_cfg->mode) {
@@ -297,11 +389,14 @@ error_t es7210_adc_init(codec_config_t *codec_cfg, void* i2c)
         default:
             ret |= es7210_update_reg_bit(ES7210_MODE_CONFIG_REG08, 0x01, 0x00);
     }
-    ret |= es7210_write_reg(ES7210_ANALOG_REG40, 0x43);               /* Select power off analog, vdda = 3.3V, close vx20ff, VMID select 5KΩ start */
-    ret |= es7210_write_reg(ES7210_MIC12_BIAS_REG41, 0x70);           /* Select 2.87v */
-    ret |= es7210_write_reg(ES7210_MIC34_BIAS_REG42, 0x70);           /* Select 2.87v */
-    ret |= es7210_write_reg(ES7210_OSR_REG07, 0x20);
-    ret |= es7210_write_reg(ES7210_MAINCLK_REG02, 0xc1);              /* Set the frequency division coefficient and use dll except clock doubler, and need to set 0xc1 to clear the state */
+    const i2c_seq_t analog_seq[] = {
+        {I2C_SEQ_WRITE, ES7210_ANALOG_REG40, 0x43, 0},            /* Select power off analog, vdda = 3.3V, close vx20ff, VMID select 5KΩ start */
+        {I2C_SEQ_WRITE, ES7210_MIC12_BIAS_REG41, 0x70, 0},        /* Select 2.87v */
+        {I2C_SEQ_WRITE, ES7210_MIC34_BIAS_REG42, 0x70, 0},        /* Select 2.87v */
+        {I2C_SEQ_WRITE, ES7210_OSR_REG07, 0x20, 0},
+        {I2C_SEQ_WRITE, ES7210_MAINCLK_REG02, 0xc1, 0},           /* Set the frequency division coefficient and use dll except clock doubler, and need to set 0xc1 to clear the state */
+    };
+    ret |= es7210_run_seq(analog_seq, sizeof(analog_seq) / sizeof(analog_seq[0]));
     ret |= es7210_config_sample(i2s_cfg->rate);
     ret |= es7210_mic_select(mic_select);
     ret |= es7210_adc_set_gain(ES7210_GAIN_30DB);
@@ -310,6 +405,8 @@ error_t es7210_adc_init(codec_config_t *codec_cfg, void* i2c)
 
 error_t es7210_adc_deinit()
 {
+    i2c_reg_map_release(es7210_regs);
+    es7210_regs = NULL;
     return RESULT_OK;
 }
 
@@ -373,6 +470,9 @@ error_t es7210_set_bits(sample_bits_t bits)
 error_t es7210_adc_config_i2s(codec_mode_t mode, I2SDefinition *iface)
 {
     error_t ret = RESULT_OK;
+    if (es7210_get_sample_coeff(iface->rate) < 0) {
+        return RESULT_FAIL;
+    }
     ret |= es7210_set_bits(iface->bits);
     ret |= es7210_config_fmt(iface->fmt);
     ret |= es7210_config_sample(iface->rate);
@@ -382,13 +482,16 @@ error_t es7210_adc_config_i2s(codec_mode_t mode, I2SDefinition *iface)
 error_t es7210_start(uint8_t clock_reg_value)
 {
     error_t ret = RESULT_OK;
-    ret |= es7210_write_reg(ES7210_CLOCK_OFF_REG01, clock_reg_value);
-    ret |= es7210_write_reg(ES7210_POWER_DOWN_REG06, 0x00);
-    ret |= es7210_write_reg(ES7210_ANALOG_REG40, 0x43);
-    ret |= es7210_write_reg(ES7210_MIC1_POWER_REG47, 0x00);
-    ret |= es7210_write_reg(ES7210_MIC2_POWER_REG48, 0x00);
-    ret |= es7210_write_reg(ES7210_MIC3_POWER_REG49, 0x00);
-    ret |= es7210_write_reg(ES7210_MIC4_POWER_REG4A, 0x00);
+    const i2c_seq_t seq[] = {
+        {I2C_SEQ_WRITE, ES7210_CLOCK_OFF_REG01, clock_reg_value, 0},
+        {I2C_SEQ_WRITE, ES7210_POWER_DOWN_REG06, 0x00, 0},
+        {I2C_SEQ_WRITE, ES7210_ANALOG_REG40, 0x43, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC1_POWER_REG47, 0x00, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC2_POWER_REG48, 0x00, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC3_POWER_REG49, 0x00, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC4_POWER_REG4A, 0x00, 0},
+    };
+    ret |= es7210_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
     ret |= es7210_mic_select(mic_select);
     return ret;
 }
@@ -396,15 +499,18 @@ error_t es7210_start(uint8_t clock_reg_value)
 error_t es7210_stop(void)
 {
     error_t ret = RESULT_OK;
-    ret |= es7210_write_reg(ES7210_MIC1_POWER_REG47, 0xff);
-    ret |= es7210_write_reg(ES7210_MIC2_POWER_REG48, 0xff);
-    ret |= es7210_write_reg(ES7210_MIC3_POWER_REG49, 0xff);
-    ret |= es7210_write_reg(ES7210_MIC4_POWER_REG4A, 0xff);
-    ret |= es7210_write_reg(ES7210_MIC12_POWER_REG4B,0xff);
-    ret |= es7210_write_reg(ES7210_MIC34_POWER_REG4C, 0xff);
-    ret |= es7210_write_reg(ES7210_ANALOG_REG40, 0xc0);
-    ret |= es7210_write_reg(ES7210_CLOCK_OFF_REG01, 0x7f);
-    ret |= es7210_write_reg(ES7210_POWER_DOWN_REG06, 0x07);
+    const i2c_seq_t seq[] = {
+        {I2C_SEQ_WRITE, ES7210_MIC1_POWER_REG47, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC2_POWER_REG48, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC3_POWER_REG49, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC4_POWER_REG4A, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC12_POWER_REG4B, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_MIC34_POWER_REG4C, 0xff, 0},
+        {I2C_SEQ_WRITE, ES7210_ANALOG_REG40, 0xc0, 0},
+        {I2C_SEQ_WRITE, ES7210_CLOCK_OFF_REG01, 0x7f, 0},
+        {I2C_SEQ_WRITE, ES7210_POWER_DOWN_REG06, 0x07, 0},
+    };
+    ret |= es7210_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
     return ret;
 }
 
@@ -487,13 +593,26 @@ error_t es7210_adc_set_volume(int volume)
 error_t es7210_set_mute(bool enable)
 {
     AD_LOGD( "ES7210 SetMute :%d", enable);
-    return RESULT_OK;
+    error_t ret = RESULT_OK;
+    uint8_t value = enable ? 0x03 : 0x00;
+    ret |= es7210_update_reg_bit(ES7210_ADC34_MUTERANGE_REG14, 0x03, value);
+    ret |= es7210_update_reg_bit(ES7210_ADC12_MUTERANGE_REG15, 0x03, value);
+    return ret;
+}
+
+error_t es7210_get_mute(bool *enable)
+{
+    uint8_t value = 0;
+    error_t ret = i2c_bus_read_reg_cached(i2c_handle, ES7210_ADDR, es7210_regs, ES7210_ADC12_MUTERANGE_REG15, &value);
+    *enable = (value & 0x03) == 0x03;
+    return ret;
 }
 
 void es7210_read_all(void)
 {
+    uint8_t regs[0x4F] = {0};
+    i2c_bus_read_regs(i2c_handle, ES7210_ADDR, 0, regs, sizeof(regs), ES_I2C_AUTO_INCREMENT);
     for (int i = 0; i <= 0x4E; i++) {
-        uint8_t reg = es7210_read_reg(i);
-        AD_LOGI("REG:%02x, %02x", reg, i);
+        AD_LOGI("REG:%02x, %02x", regs[i], i);
     }
 }
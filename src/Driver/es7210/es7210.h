@@ -48,10 +48,14 @@ extern "C" {
 #define  ES7210_SDP_INTERFACE2_REG12        0x12        /* Pins state */
 #define  ES7210_ADC_AUTOMUTE_REG13          0x13        /* Set mute */
 #define  ES7210_ADC34_MUTERANGE_REG14       0x14        /* Set mute range */
+#define  ES7210_ADC12_MUTERANGE_REG15       0x15        /* Set mute range */
 #define  ES7210_ADC34_HPF2_REG20            0x20        /* HPF */
 #define  ES7210_ADC34_HPF1_REG21            0x21
 #define  ES7210_ADC12_HPF1_REG22            0x22
 #define  ES7210_ADC12_HPF2_REG23            0x23
+#define  ES7210_CHIP_ID1_REG3D              0x3D        /* Chip ID high byte: 0x72 */
+#define  ES7210_CHIP_ID0_REG3E              0x3E        /* Chip ID low byte: 0x10 */
+#define  ES7210_CHIP_VERSION_REG3F          0x3F
 #define  ES7210_ANALOG_REG40                0x40        /* ANALOG Power */
 #define  ES7210_MIC12_BIAS_REG41            0x41
 #define  ES7210_MIC34_BIAS_REG42            0x42
@@ -66,6 +70,8 @@ extern "C" {
 #define  ES7210_MIC12_POWER_REG4B           0x4B        /* MICBias & ADC & PGA Power */
 #define  ES7210_MIC34_POWER_REG4C           0x4C
 
+#define  ES7210_CHIP_ID                     0x7210      /* value of REG3D and REG3E */
+
 typedef enum {
     ES7210_AD1_AD0_00 = 0x80,
     ES7210_AD1_AD0_01 = 0x82,
@@ -109,6 +115,12 @@ typedef enum gain_value{
  */
 error_t es7210_adc_init(codec_config_t *codec_cfg, void* i2c);
 
+/* time in ms for which es7210_adc_reset() holds the chip in reset */
+#define ES7210_RESET_TIME_MS 10
+/* begin in steps: es7210_adc_reset(), wait ES7210_RESET_TIME_MS and
+   es7210_adc_init(), which releases the reset */
+error_t es7210_adc_reset(void* i2c);
+
 /**
  * @brief Deinitialize ES7210 ADC chip
  *
@@ -130,6 +142,17 @@ error_t es7210_adc_deinit();
  */
 error_t es7210_adc_config_i2s(codec_mode_t mode, I2SDefinition *iface);
 
+/**
+ * @brief Changes only the clock configuration for the sample rate
+ *
+ * @param[in] sample:  sample rate
+ *
+ * @return
+ *     - RESULT_FAIL the rate is not supported
+ *     - RESULT_OK   Success
+ */
+error_t es7210_config_sample(samplerate_t sample);
+
 /**
  * @brief Control ES7210 ADC chip
  *
@@ -194,6 +217,17 @@ error_t es7210_adc_set_volume(int volume);
  */
 error_t es7210_set_mute(bool enable);
 
+/**
+ * @brief Get ES7210 ADC mute status
+ *
+ * @param[out] enable: true if the ADCs are muted
+ *
+ * @return
+ *     - RESULT_FAIL
+ *     - RESULT_OK
+ */
+error_t es7210_get_mute(bool *enable);
+
 /**
  * @brief Select ES7210 mic
  *
@@ -221,6 +255,30 @@ int es7210_read_reg(uint8_t reg_addr);
  */
 void es7210_read_all(void);
 
+/**
+ * @brief Looks up the clock coefficients for the mclk and lrck
+ *
+ * @param mclk: master clock frequency in Hz
+ * @param lrck: sample rate in Hz
+ *
+ * @return
+ *     - index of the entry in the coefficient table
+ *     - (-1) if the combination is not supported
+ */
+int es7210_get_coeff(uint32_t mclk, uint32_t lrck);
+
+/**
+ * @brief Provides the sample rates which are supported with the mclk
+ *
+ * @param mclk: master clock frequency in Hz (0: 256 * rate)
+ * @param[out] rates: array which receives the rates (can be NULL)
+ * @param max: size of the rates array
+ *
+ * @return
+ *     - number of supported rates
+ */
+int es7210_get_rates(uint32_t mclk, uint32_t *rates, int max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,7 +27,6 @@
 #include "Utils/etc.h"
 #include "Utils/etc.h"
 
-#define MCLK_PULSES_NUMBER    (20)
 #define ES_ASSERT(a, format, b, ...) \
     if ((a) != 0) { \
         AD_LOGE( format, ##__VA_ARGS__); \
@@ -48,6 +47,15 @@ static error_t es7243_write_reg(uint8_t reg_add, uint8_t data)
 }
 
 
+static const i2c_seq_t es7243_init_seq[] = {
+    {I2C_SEQ_WRITE, 0x00, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x06, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x05, 0x1B, 0},
+    {I2C_SEQ_WRITE, 0x01, 0x0C, 0},
+    {I2C_SEQ_WRITE, 0x08, 0x43, 0},
+    {I2C_SEQ_WRITE, 0x05, 0x13, 0},
+};
+
 error_t es7243_adc_set_addr(int addr)
 {
     es7243_addr = addr;
@@ -55,35 +63,41 @@ error_t es7243_adc_set_addr(int addr)
 }
 
 
-static error_t es7243_mclk_active(uint8_t mclk_gpio)
+void es7243_mclk_write(int level)
 {
 #ifndef ARDUINO_ARCH_NRF52840
     pinMode(mclk_gpio, OUTPUT);
-#endif    /*
+#endif
+    digitalWrite(mclk_gpio, level);
+}
+
+static error_t es7243_mclk_active(uint8_t mclk_gpio)
+{
+    /*
         Before initializing es7243, it is necessary to output
         mclk to es7243 to activate the I2C configuration.
         So give some clocks to active es7243.
     */
-    for (int i = 0; i < MCLK_PULSES_NUMBER; ++i) {
-        digitalWrite(mclk_gpio, 0);
-        delay(1);
-        digitalWrite(mclk_gpio, 1);
-        delay(1);
+    for (int i = 0; i < ES7243_MCLK_PULSES; ++i) {
+        es7243_mclk_write(0);
+        delay(ES7243_MCLK_HALF_PERIOD_MS);
+        es7243_mclk_write(1);
+        delay(ES7243_MCLK_HALF_PERIOD_MS);
     }
     return RESULT_OK;
 }
 
 error_t es7243_adc_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle)
+{
+    es7243_mclk_active(mclk_gpio);
+    return es7243_adc_configure(codec_cfg, handle);
+}
+
+error_t es7243_adc_configure(codec_config_t *codec_cfg, i2c_bus_handle_t handle)
 {
     error_t ret = RESULT_OK;
     i2c_handle = handle;
-    es7243_mclk_active(mclk_gpio);
-    ret |= es7243_write_reg(0x00, 0x01);
-    ret |= es7243_write_reg(0x06, 0x00);
-    ret |= es7243_write_reg(0x05, 0x1B);
-    ret |= es7243_write_reg(0x01, 0x0C);
-    ret |= es7243_write_reg(0x08, 0x43);
-    ret |= es7243_write_reg(0x05, 0x13);
+    ret |= i2c_bus_run_seq(i2c_handle, es7243_addr, NULL, es7243_init_seq, sizeof(es7243_init_seq) / sizeof(es7243_init_seq[0]), false);
     if (ret) {
         AD_LOGE( "Es7243 initialize failed!");
         return RESULT_FAIL;
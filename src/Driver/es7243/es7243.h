@@ -36,6 +36,17 @@ extern "C" {
 
 void es7243_mclk_gpio(int gpio);
 
+/* number of mclk pulses which activate the I2C interface */
+#define ES7243_MCLK_PULSES 20
+/* time in ms of each mclk level */
+#define ES7243_MCLK_HALF_PERIOD_MS 1
+
+/* es7243_adc_init() in steps: ES7243_MCLK_PULSES times es7243_mclk_write(0)
+   and es7243_mclk_write(1), each followed by ES7243_MCLK_HALF_PERIOD_MS, and
+   es7243_adc_configure() */
+void es7243_mclk_write(int level);
+error_t es7243_adc_configure(codec_config_t *codec_cfg, i2c_bus_handle_t handle);
+
 /**
  * @brief Initialize ES7243 adc chip
  *
@@ -22,6 +22,7 @@
  *
  */
 
+#include <stddef.h>
 #include "es7243e.h"
 
 
@@ -29,11 +30,82 @@
 static i2c_bus_handle_t i2c_handle;
 static int es7243e_addr = 0x10; //0x20 >> 1;
 
-static error_t es7243e_write_reg(uint8_t reg_add, uint8_t data)
+static error_t es7243e_run_seq(const i2c_seq_t *seq, int count)
 {
-    return i2c_bus_write_bytes(i2c_handle, es7243e_addr, &reg_add, sizeof(reg_add), &data, sizeof(data));
+    return i2c_bus_run_seq(i2c_handle, es7243e_addr, NULL, seq, count, ES_I2C_AUTO_INCREMENT);
 }
 
+static const i2c_seq_t es7243e_init_seq[] = {
+    {I2C_SEQ_WRITE, 0x01, 0x3A, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x80, 0},
+    {I2C_SEQ_WRITE, 0xF9, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x04, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x04, 0x01, 0},
+    {I2C_SEQ_WRITE, 0xF9, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x1E, 0},
+    {I2C_SEQ_WRITE, 0x01, 0x00, 0},
+
+    {I2C_SEQ_WRITE, 0x02, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x03, 0x20, 0},
+    {I2C_SEQ_WRITE, 0x04, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x0D, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x05, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x06, 0x03, 0}, // SCLK=MCLK/4
+    {I2C_SEQ_WRITE, 0x07, 0x00, 0}, // LRCK=MCLK/256
+    {I2C_SEQ_WRITE, 0x08, 0xFF, 0}, // LRCK=MCLK/256
+
+    {I2C_SEQ_WRITE, 0x09, 0xCA, 0},
+    {I2C_SEQ_WRITE, 0x0A, 0x85, 0},
+    {I2C_SEQ_WRITE, 0x0B, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x0E, 0xBF, 0},
+    {I2C_SEQ_WRITE, 0x0F, 0x80, 0},
+    {I2C_SEQ_WRITE, 0x14, 0x0C, 0},
+    {I2C_SEQ_WRITE, 0x15, 0x0C, 0},
+    {I2C_SEQ_WRITE, 0x17, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x18, 0x26, 0},
+    {I2C_SEQ_WRITE, 0x19, 0x77, 0},
+    {I2C_SEQ_WRITE, 0x1A, 0xF4, 0},
+    {I2C_SEQ_WRITE, 0x1B, 0x66, 0},
+    {I2C_SEQ_WRITE, 0x1C, 0x44, 0},
+    {I2C_SEQ_WRITE, 0x1E, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x1F, 0x0C, 0},
+    {I2C_SEQ_WRITE, 0x20, 0x1A, 0}, //PGA gain +30dB
+    {I2C_SEQ_WRITE, 0x21, 0x1A, 0}, //PGA gain +30dB
+
+    {I2C_SEQ_WRITE, 0x00, 0x80, 0}, //Slave  Mode
+    {I2C_SEQ_WRITE, 0x01, 0x3A, 0},
+    {I2C_SEQ_WRITE, 0x16, 0x3F, 0},
+    {I2C_SEQ_WRITE, 0x16, 0x00, 0},
+};
+
+static const i2c_seq_t es7243e_start_seq[] = {
+    {I2C_SEQ_WRITE, 0xF9, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x04, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x17, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x20, 0x10, 0},
+    {I2C_SEQ_WRITE, 0x21, 0x10, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x80, 0},
+    {I2C_SEQ_WRITE, 0x01, 0x3A, 0},
+    {I2C_SEQ_WRITE, 0x16, 0x3F, 0},
+    {I2C_SEQ_WRITE, 0x16, 0x00, 0},
+};
+
+static const i2c_seq_t es7243e_stop_seq[] = {
+    {I2C_SEQ_WRITE, 0x04, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x04, 0x01, 0},
+    {I2C_SEQ_WRITE, 0xF7, 0x30, 0},
+    {I2C_SEQ_WRITE, 0xF9, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x16, 0xFF, 0},
+    {I2C_SEQ_WRITE, 0x17, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x01, 0x38, 0},
+    {I2C_SEQ_WRITE, 0x20, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x21, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x1E, 0},
+    {I2C_SEQ_WRITE, 0x01, 0x30, 0},
+    {I2C_SEQ_WRITE, 0x01, 0x00, 0},
+};
+
 
 error_t es7243e_adc_set_addr(int addr)
 {
@@ -45,46 +117,7 @@ error_t es7243e_adc_init(codec_config_t *codec_cfg, void *i2c)
 {
     i2c_handle = i2c;
     error_t ret = RESULT_OK;
-    ret |= es7243e_write_reg(0x01, 0x3A);
-    ret |= es7243e_write_reg(0x00, 0x80);
-    ret |= es7243e_write_reg(0xF9, 0x00);
-    ret |= es7243e_write_reg(0x04, 0x02);
-    ret |= es7243e_write_reg(0x04, 0x01);
-    ret |= es7243e_write_reg(0xF9, 0x01);
-    ret |= es7243e_write_reg(0x00, 0x1E);
-    ret |= es7243e_write_reg(0x01, 0x00);
-
-    ret |= es7243e_write_reg(0x02, 0x00);
-    ret |= es7243e_write_reg(0x03, 0x20);
-    ret |= es7243e_write_reg(0x04, 0x01);
-    ret |= es7243e_write_reg(0x0D, 0x00);
-    ret |= es7243e_write_reg(0x05, 0x00);
-    ret |= es7243e_write_reg(0x06, 0x03); // SCLK=MCLK/4
-    ret |= es7243e_write_reg(0x07, 0x00); // LRCK=MCLK/256
-    ret |= es7243e_write_reg(0x08, 0xFF); // LRCK=MCLK/256
-
-    ret |= es7243e_write_reg(0x09, 0xCA);
-    ret |= es7243e_write_reg(0x0A, 0x85);
-    ret |= es7243e_write_reg(0x0B, 0x00);
-    ret |= es7243e_write_reg(0x0E, 0xBF);
-    ret |= es7243e_write_reg(0x0F, 0x80);
-    ret |= es7243e_write_reg(0x14, 0x0C);
-    ret |= es7243e_write_reg(0x15, 0x0C);
-    ret |= es7243e_write_reg(0x17, 0x02);
-    ret |= es7243e_write_reg(0x18, 0x26);
-    ret |= es7243e_write_reg(0x19, 0x77);
-    ret |= es7243e_write_reg(0x1A, 0xF4);
-    ret |= es7243e_write_reg(0x1B, 0x66);
-    ret |= es7243e_write_reg(0x1C, 0x44);
-    ret |= es7243e_write_reg(0x1E, 0x00);
-    ret |= es7243e_write_reg(0x1F, 0x0C);
-    ret |= es7243e_write_reg(0x20, 0x1A); //PGA gain +30dB
-    ret |= es7243e_write_reg(0x21, 0x1A); //PGA gain +30dB
-
-    ret |= es7243e_write_reg(0x00, 0x80); //Slave  Mode
-    ret |= es7243e_write_reg(0x01, 0x3A);
-    ret |= es7243e_write_reg(0x16, 0x3F);
-    ret |= es7243e_write_reg(0x16, 0x00);
+    ret |= es7243e_run_seq(es7243e_init_seq, sizeof(es7243e_init_seq) / sizeof(es7243e_init_seq[0]));
     if (ret) {
         AD_LOGE("Es7243e initialize failed!");
         return RESULT_FAIL;
@@ -101,30 +134,10 @@ error_t es7243e_adc_ctrl_state_active(codec_mode_t mode, bool ctrl_state_active)
 {
     error_t ret = RESULT_OK;
     if (ctrl_state_active) {
-        ret |= es7243e_write_reg(0xF9, 0x00);
-        ret |= es7243e_write_reg(0x04, 0x01);
-        ret |= es7243e_write_reg(0x17, 0x01);
-        ret |= es7243e_write_reg(0x20, 0x10);
-        ret |= es7243e_write_reg(0x21, 0x10);
-        ret |= es7243e_write_reg(0x00, 0x80);
-        ret |= es7243e_write_reg(0x01, 0x3A);
-        ret |= es7243e_write_reg(0x16, 0x3F);
-        ret |= es7243e_write_reg(0x16, 0x00);
+        ret |= es7243e_run_seq(es7243e_start_seq, sizeof(es7243e_start_seq) / sizeof(es7243e_start_seq[0]));
     } else {
         AD_LOGW("The codec going to stop");
-        ret |= es7243e_write_reg(0x04, 0x02);
-        ret |= es7243e_write_reg(0x04, 0x01);
-        ret |= es7243e_write_reg(0xF7, 0x30);
-        ret |= es7243e_write_reg(0xF9, 0x01);
-        ret |= es7243e_write_reg(0x16, 0xFF);
-        ret |= es7243e_write_reg(0x17, 0x00);
-        ret |= es7243e_write_reg(0x01, 0x38);
-        ret |= es7243e_write_reg(0x20, 0x00);
-        ret |= es7243e_write_reg(0x21, 0x00);
-        ret |= es7243e_write_reg(0x00, 0x00);
-        ret |= es7243e_write_reg(0x00, 0x1E);
-        ret |= es7243e_write_reg(0x01, 0x30);
-        ret |= es7243e_write_reg(0x01, 0x00);
+        ret |= es7243e_run_seq(es7243e_stop_seq, sizeof(es7243e_stop_seq) / sizeof(es7243e_stop_seq[0]));
     }
     return ret;
 }
@@ -72,6 +72,57 @@ static error_t es8156_write_reg(uint8_t reg_addr, uint8_t data)
     return i2c_bus_write_bytes(i2c_handle, ES8156_ADDR, &reg_addr, sizeof(reg_addr), &data, sizeof(data));
 }
 
+static error_t es8156_run_seq(const i2c_seq_t *seq, int count)
+{
+    return i2c_bus_run_seq(i2c_handle, ES8156_ADDR, NULL, seq, count, ES_I2C_AUTO_INCREMENT);
+}
+
+static const i2c_seq_t es8156_standby_seq[] = {
+    {I2C_SEQ_WRITE, 0x14, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x19, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x21, 0x1F, 0},
+    {I2C_SEQ_WRITE, 0x22, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x25, 0x21, 0},
+    {I2C_SEQ_WRITE, 0x25, 0xA1, 0},
+    {I2C_SEQ_WRITE, 0x18, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x09, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x09, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x08, 0x00, 0},
+};
+
+static const i2c_seq_t es8156_resume_seq[] = {
+    {I2C_SEQ_WRITE, 0x08, 0x3F, 0},
+    {I2C_SEQ_WRITE, 0x09, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x18, 0x00, 0},
+
+    {I2C_SEQ_WRITE, 0x25, 0x20, 0},
+    {I2C_SEQ_WRITE, 0x22, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x21, 0x3C, 0},
+    {I2C_SEQ_WRITE, 0x19, 0x20, 0},
+    {I2C_SEQ_WRITE, 0x14, 179, 0},
+};
+
+static const i2c_seq_t es8156_init_seq[] = {
+    {I2C_SEQ_WRITE, 0x02, 0x04, 0},
+    {I2C_SEQ_WRITE, 0x20, 0x2A, 0},
+    {I2C_SEQ_WRITE, 0x21, 0x3C, 0},
+    {I2C_SEQ_WRITE, 0x22, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x24, 0x07, 0},
+    {I2C_SEQ_WRITE, 0x23, 0x00, 0},
+
+    {I2C_SEQ_WRITE, 0x0A, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x0B, 0x01, 0},
+    {I2C_SEQ_WRITE, 0x11, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x14, 179, 0}, // volume 70%
+
+    {I2C_SEQ_WRITE, 0x0D, 0x14, 0},
+    {I2C_SEQ_WRITE, 0x18, 0x00, 0},
+    {I2C_SEQ_WRITE, 0x08, 0x3F, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x02, 0},
+    {I2C_SEQ_WRITE, 0x00, 0x03, 0},
+    {I2C_SEQ_WRITE, 0x25, 0x20, 0},
+};
+
 static int es8156_read_reg(uint8_t reg_addr)
 {
     uint8_t data;
@@ -83,31 +134,14 @@ static int es8156_read_reg(uint8_t reg_addr)
 static error_t es8156_standby(void)
 {
     error_t ret = 0;
-    ret = es8156_write_reg(0x14, 0x00);
-    ret |= es8156_write_reg(0x19, 0x02);
-    ret |= es8156_write_reg(0x21, 0x1F);
-    ret |= es8156_write_reg(0x22, 0x02);
-    ret |= es8156_write_reg(0x25, 0x21);
-    ret |= es8156_write_reg(0x25, 0xA1);
-    ret |= es8156_write_reg(0x18, 0x01);
-    ret |= es8156_write_reg(0x09, 0x02);
-    ret |= es8156_write_reg(0x09, 0x01);
-    ret |= es8156_write_reg(0x08, 0x00);
+    ret = es8156_run_seq(es8156_standby_seq, sizeof(es8156_standby_seq) / sizeof(es8156_standby_seq[0]));
     return ret;
 }
 
 static error_t es8156_resume(void)
 {
     error_t ret = 0;
-    ret |= es8156_write_reg(0x08, 0x3F);
-    ret |= es8156_write_reg(0x09, 0x00);
-    ret |= es8156_write_reg(0x18, 0x00);
-
-    ret |= es8156_write_reg(0x25, 0x20);
-    ret |= es8156_write_reg(0x22, 0x00);
-    ret |= es8156_write_reg(0x21, 0x3C);
-    ret |= es8156_write_reg(0x19, 0x20);
-    ret |= es8156_write_reg(0x14, 179);
+    ret |= es8156_run_seq(es8156_resume_seq, sizeof(es8156_resume_seq) / sizeof(es8156_resume_seq[0]));
     return ret;
 }
 
@@ -129,24 +163,7 @@ error_t es8156_codec_init(codec_config_t *cfg, void* i2c)
     }
     codec_init_flag = true;
 
-    es8156_write_reg(0x02, 0x04);
-    es8156_write_reg(0x20, 0x2A);
-    es8156_write_reg(0x21, 0x3C);
-    es8156_write_reg(0x22, 0x00);
-    es8156_write_reg(0x24, 0x07);
-    es8156_write_reg(0x23, 0x00);
-
-    es8156_write_reg(0x0A, 0x01);
-    es8156_write_reg(0x0B, 0x01);
-    es8156_write_reg(0x11, 0x00);
-    es8156_write_reg(0x14, 179);  // volume 70%
-
-    es8156_write_reg(0x0D, 0x14);
-    es8156_write_reg(0x18, 0x00);
-    es8156_write_reg(0x08, 0x3F);
-    es8156_write_reg(0x00, 0x02);
-    es8156_write_reg(0x00, 0x03);
-    es8156_write_reg(0x25, 0x20);
+    es8156_run_seq(es8156_init_seq, sizeof(es8156_init_seq) / sizeof(es8156_init_seq[0]));
 
     // gpio_config_t io_conf;
     // memset(&io_conf, 0, sizeof(io_conf));
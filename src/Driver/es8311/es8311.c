@@ -55,6 +55,8 @@
 
 static i2c_bus_handle_t i2c_handle;
 static int i2c_address_es8311 = ES8311_ADDR;
+/* write-through image of the registers, so that bit updates need no read */
+static i2c_reg_map_t *es8311_regs = NULL;
 
 // /*
 //  * operate function of codec
@@ -192,6 +194,31 @@ static const struct coeff_div coeff_div[] = {
     {1536000 , 96000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10},
 };
 
+/*
+ * Rows of coeff_div[] for each rate (sorted by rate): this index must be
+ * updated together with the table
+ */
+struct coeff_range {
+    uint32_t rate;
+    uint8_t first;
+    uint8_t count;
+};
+
+static const struct coeff_range coeff_ranges[] = {
+    {8000 ,  0, 10},
+    {11025, 10,  4},
+    {12000, 14,  4},
+    {16000, 18, 10},
+    {22050, 28,  4},
+    {24000, 32,  5},
+    {32000, 37, 10},
+    {44100, 47,  4},
+    {48000, 51,  5},
+    {64000, 56, 10},
+    {88200, 66,  4},
+    {96000, 70,  5},
+};
+
 
 #define ES_ASSERT(a, format, b, ...) \
     if ((a) != 0) { \
@@ -207,29 +234,71 @@ int8_t get_es8311_mclk_src(void) {
 
 static error_t es8311_write_reg(uint8_t reg_addr, uint8_t data)
 {
-    return i2c_bus_write_bytes(i2c_handle, i2c_address_es8311, &reg_addr, sizeof(reg_addr), &data, sizeof(data));
+    return i2c_bus_write_reg_cached(i2c_handle, i2c_address_es8311, es8311_regs, reg_addr, data);
+}
+
+static error_t es8311_run_seq(const i2c_seq_t *seq, int count)
+{
+    return i2c_bus_run_seq(i2c_handle, i2c_address_es8311, es8311_regs, seq, count, ES_I2C_AUTO_INCREMENT);
 }
 
 static int es8311_read_reg(uint8_t reg_addr)
 {
-    uint8_t data;
-    i2c_bus_read_bytes(i2c_handle, i2c_address_es8311, &reg_addr, sizeof(reg_addr), &data, sizeof(data));
+    uint8_t data = 0;
+    i2c_bus_read_reg_cached(i2c_handle, i2c_address_es8311, es8311_regs, reg_addr, &data);
     return (int)data;
 }
 
 
 /*
-* look for the coefficient in coeff_div[] table
+* look for the rows of the rate with a binary search in coeff_ranges[]
 */
-static int get_coeff(uint32_t mclk, uint32_t rate)
+static const struct coeff_range *get_coeff_range(uint32_t rate)
 {
-    for (unsigned i = 0; i < (sizeof(coeff_div) / sizeof(coeff_div[0])); i++) {
-        if (coeff_div[i].rate == rate && coeff_div[i].mclk == mclk)
+    int low = 0;
+    int high = sizeof(coeff_ranges) / sizeof(coeff_ranges[0]) - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (coeff_ranges[mid].rate == rate)
+            return &coeff_ranges[mid];
+        if (coeff_ranges[mid].rate < rate)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return NULL;
+}
+
+/*
+* look for the coefficient in coeff_div[] table: only the rows of the rate
+* are checked
+*/
+int es8311_get_coeff(uint32_t mclk, uint32_t rate)
+{
+    const struct coeff_range *range = get_coeff_range(rate);
+    if (range == NULL)
+        return -1;
+    for (int i = range->first; i < range->first + range->count; i++) {
+        if (coeff_div[i].mclk == mclk)
             return i;
     }
     return -1;
 }
 
+int es8311_get_rates(uint32_t mclk, uint32_t *rates, int max)
+{
+    int count = 0;
+    for (unsigned i = 0; i < (sizeof(coeff_ranges) / sizeof(coeff_ranges[0])); i++) {
+        uint32_t rate = coeff_ranges[i].rate;
+        if (es8311_get_coeff(mclk != 0 ? mclk : rate * MCLK_DIV_FRE, rate) < 0)
+            continue;
+        if (rates != NULL && count < max)
+            rates[count] = rate;
+        count++;
+    }
+    return count;
+}
+
 /*
 * set es8311 dac mute or not
 * if mute = 0, dac un-mute
@@ -257,15 +326,18 @@ static void es8311_mute(int mute)
 static void es8311_suspend(void)
 {
     AD_LOGI( "Enter into es8311_suspend()");
-    es8311_write_reg(ES8311_DAC_REG32, 0x00);
-    es8311_write_reg(ES8311_ADC_REG17, 0x00);
-    es8311_write_reg(ES8311_SYSTEM_REG0E, 0xFF);
-    es8311_write_reg(ES8311_SYSTEM_REG12, 0x02);
-    es8311_write_reg(ES8311_SYSTEM_REG14, 0x00);
-    es8311_write_reg(ES8311_SYSTEM_REG0D, 0xFA);
-    es8311_write_reg(ES8311_ADC_REG15, 0x00);
-    es8311_write_reg(ES8311_DAC_REG37, 0x08);
-    es8311_write_reg(ES8311_GP_REG45, 0x01);
+    const i2c_seq_t seq[] = {
+        {I2C_SEQ_WRITE, ES8311_DAC_REG32, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG17, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG0E, 0xFF, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG12, 0x02, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG14, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG0D, 0xFA, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG15, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_DAC_REG37, 0x08, 0},
+        {I2C_SEQ_WRITE, ES8311_GP_REG45, 0x01, 0},
+    };
+    es8311_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
 }
 
 // /*
@@ -281,73 +353,15 @@ static void es8311_suspend(void)
 //     }
 // }
 
-error_t es8311_codec_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle, int8_t mclk_src, int i2c_address)
+/*
+ * Determines the coeff_div[] entry for the sample rate: -1 if it is not supported
+ */
+static int es8311_get_sample_coeff(samplerate_t sample)
 {
-    es8311_mclk_src = mclk_src;
-    uint8_t datmp, regv;
     int coeff;
-    error_t ret = RESULT_OK;
-    i2c_handle = handle;
-    if (i2c_address > 0){
-       i2c_address_es8311 = i2c_address;
-    }
-
-    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, 0x30);
-    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG02, 0x00);
-    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG03, 0x10);
-    ret |= es8311_write_reg(ES8311_ADC_REG16, 0x24);
-    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG04, 0x10);
-    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG05, 0x00);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG0B, 0x00);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG0C, 0x00);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG10, 0x1F);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG11, 0x7F);
-    ret |= es8311_write_reg(ES8311_RESET_REG00, 0x80);
-    /*
-     * Set Codec into Master or Slave mode
-     */
-    regv = es8311_read_reg(ES8311_RESET_REG00);
-    /*
-     * Set master/slave audio interface
-     */
-    I2SDefinition *i2s_cfg = &(codec_cfg->i2s);
-    switch (i2s_cfg->mode) {
-        case MODE_MASTER:    /* MASTER MODE */
-            AD_LOGI( "ES8311 in Master mode");
-            regv |= 0x40;
-            break;
-        case MODE_SLAVE:    /* SLAVE MODE */
-            AD_LOGI( "ES8311 in Slave mode");
-            regv &= 0xBF;
-            break;
-        default:
-            regv &= 0xBF;
-    }
-    ret |= es8311_write_reg(ES8311_RESET_REG00, regv);
-    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, 0x3F);
-    /*
-     * Select clock source for internal mclk
-     */
-    switch (get_es8311_mclk_src()) {
-        case FROM_MCLK_PIN:
-            regv = es8311_read_reg(ES8311_CLK_MANAGER_REG01);
-            regv &= 0x7F;
-            ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, regv);
-            break;
-        case FROM_SCLK_PIN:
-            regv = es8311_read_reg(ES8311_CLK_MANAGER_REG01);
-            regv |= 0x80;
-            ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, regv);
-            break;
-        default:
-            regv = es8311_read_reg(ES8311_CLK_MANAGER_REG01);
-            regv &= 0x7F;
-            ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, regv);
-            break;
-    }
     int sample_fre = 0;
     int mclk_fre = 0;
-    switch (i2s_cfg->rate) {
+    switch (sample) {
         case RATE_8K:
             sample_fre = 8000;
             break;
@@ -377,100 +391,146 @@ error_t es8311_codec_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle, in
             break;
     }
     mclk_fre = sample_fre * MCLK_DIV_FRE;
-    coeff = get_coeff(mclk_fre, sample_fre);
+    coeff = es8311_get_coeff(mclk_fre, sample_fre);
     if (coeff < 0) {
         AD_LOGE( "Unable to configure sample rate %dHz with %dHz MCLK", sample_fre, mclk_fre);
-        return RESULT_FAIL;
     }
-    /*
-     * Set clock parammeters
-     */
-    if (coeff >= 0) {
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG02) & 0x07;
-        regv |= (coeff_div[coeff].pre_div - 1) << 5;
-        datmp = 0;
-        switch (coeff_div[coeff].pre_multi) {
-            case 1:
-                datmp = 0;
-                break;
-            case 2:
-                datmp = 1;
-                break;
-            case 4:
-                datmp = 2;
-                break;
-            case 8:
-                datmp = 3;
-                break;
-            default:
-                break;
-        }
-
-        if (get_es8311_mclk_src() == FROM_SCLK_PIN) {
-            datmp = 3;     /* DIG_MCLK = LRCK * 256 = BCLK * 8 */
-        }
-        regv |= (datmp) << 3;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG02, regv);
-
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG05) & 0x00;
-        regv |= (coeff_div[coeff].adc_div - 1) << 4;
-        regv |= (coeff_div[coeff].dac_div - 1) << 0;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG05, regv);
-
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG03) & 0x80;
-        regv |= coeff_div[coeff].fs_mode << 6;
-        regv |= coeff_div[coeff].adc_osr << 0;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG03, regv);
-
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG04) & 0x80;
-        regv |= coeff_div[coeff].dac_osr << 0;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG04, regv);
-
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG07) & 0xC0;
-        regv |= coeff_div[coeff].lrck_h << 0;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG07, regv);
-
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG08) & 0x00;
-        regv |= coeff_div[coeff].lrck_l << 0;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG08, regv);
-
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG06) & 0xE0;
-        if (coeff_div[coeff].bclk_div < 19) {
-            regv |= (coeff_div[coeff].bclk_div - 1) << 0;
-        } else {
-            regv |= (coeff_div[coeff].bclk_div) << 0;
-        }
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG06, regv);
+    return coeff;
+}
+
+/*
+ * Writes the clock registers for the coeff_div[] entry
+ */
+static error_t es8311_config_clock(int coeff)
+{
+    uint8_t datmp, regv;
+    error_t ret = RESULT_OK;
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG02) & 0x07;
+    regv |= (coeff_div[coeff].pre_div - 1) << 5;
+    datmp = 0;
+    switch (coeff_div[coeff].pre_multi) {
+        case 1:
+            datmp = 0;
+            break;
+        case 2:
+            datmp = 1;
+            break;
+        case 4:
+            datmp = 2;
+            break;
+        case 8:
+            datmp = 3;
+            break;
+        default:
+            break;
     }
 
-    /*
-     * mclk inverted or not
-     */
-    if (INVERT_MCLK) {
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG01);
-        regv |= 0x40;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, regv);
-    } else {
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG01);
-        regv &= ~(0x40);
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG01, regv);
+    if (get_es8311_mclk_src() == FROM_SCLK_PIN) {
+        datmp = 3;     /* DIG_MCLK = LRCK * 256 = BCLK * 8 */
     }
-    /*
-     * sclk inverted or not
-     */
-    if (INVERT_SCLK) {
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG06);
-        regv |= 0x20;
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG06, regv);
+    regv |= (datmp) << 3;
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG02, regv);
+
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG05) & 0x00;
+    regv |= (coeff_div[coeff].adc_div - 1) << 4;
+    regv |= (coeff_div[coeff].dac_div - 1) << 0;
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG05, regv);
+
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG03) & 0x80;
+    regv |= coeff_div[coeff].fs_mode << 6;
+    regv |= coeff_div[coeff].adc_osr << 0;
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG03, regv);
+
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG04) & 0x80;
+    regv |= coeff_div[coeff].dac_osr << 0;
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG04, regv);
+
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG07) & 0xC0;
+    regv |= coeff_div[coeff].lrck_h << 0;
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG07, regv);
+
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG08) & 0x00;
+    regv |= coeff_div[coeff].lrck_l << 0;
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG08, regv);
+
+    regv = es8311_read_reg(ES8311_CLK_MANAGER_REG06) & 0xE0;
+    if (coeff_div[coeff].bclk_div < 19) {
+        regv |= (coeff_div[coeff].bclk_div - 1) << 0;
     } else {
-        regv = es8311_read_reg(ES8311_CLK_MANAGER_REG06);
-        regv &= ~(0x20);
-        ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG06, regv);
+        regv |= (coeff_div[coeff].bclk_div) << 0;
     }
+    ret |= es8311_write_reg(ES8311_CLK_MANAGER_REG06, regv);
+    return ret;
+}
 
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG13, 0x10);
-    ret |= es8311_write_reg(ES8311_ADC_REG1B, 0x0A);
-    ret |= es8311_write_reg(ES8311_ADC_REG1C, 0x6A);
+error_t es8311_reset(i2c_bus_handle_t handle, int i2c_address)
+{
+    uint8_t reg = ES8311_RESET_REG00;
+    uint8_t value = 0x1F;
+    if (i2c_address <= 0) {
+        i2c_address = i2c_address_es8311;
+    }
+    return i2c_bus_write_bytes(handle, i2c_address, &reg, 1, &value, 1);
+}
+
+error_t es8311_codec_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle, int8_t mclk_src, int i2c_address)
+{
+    es8311_mclk_src = mclk_src;
+    int coeff;
+    error_t ret = RESULT_OK;
+    i2c_handle = handle;
+    if (i2c_address > 0){
+       i2c_address_es8311 = i2c_address;
+    }
+    /* unsupported rates are rejected before the chip is changed */
+    coeff = es8311_get_sample_coeff(codec_cfg->i2s.rate);
+    if (coeff < 0) {
+        return RESULT_FAIL;
+    }
+    /* the chip state is unknown: the reset register is always read */
+    i2c_reg_map_release(es8311_regs);
+    es8311_regs = i2c_reg_map_get(i2c_handle, i2c_address_es8311);
+    i2c_reg_map_invalidate(es8311_regs);
+    i2c_reg_map_set_volatile(es8311_regs, ES8311_RESET_REG00);
+
+    /* Set master/slave audio interface */
+    bool master = codec_cfg->i2s.mode == MODE_MASTER;
+    AD_LOGI("ES8311 in %s mode", master ? "Master" : "Slave");
+
+    const i2c_seq_t init_seq[] = {
+        {I2C_SEQ_WRITE, ES8311_CLK_MANAGER_REG01, 0x30, 0},
+        {I2C_SEQ_WRITE, ES8311_CLK_MANAGER_REG02, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_CLK_MANAGER_REG03, 0x10, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG16, 0x24, 0},
+        {I2C_SEQ_WRITE, ES8311_CLK_MANAGER_REG04, 0x10, 0},
+        {I2C_SEQ_WRITE, ES8311_CLK_MANAGER_REG05, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG0B, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG0C, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG10, 0x1F, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG11, 0x7F, 0},
+        {I2C_SEQ_WRITE, ES8311_RESET_REG00, 0x80, 0},
+        /* Set Codec into Master or Slave mode */
+        {I2C_SEQ_UPDATE, ES8311_RESET_REG00, master ? 0x40 : 0x00, 0x40},
+        {I2C_SEQ_WRITE, ES8311_CLK_MANAGER_REG01, 0x3F, 0},
+        /* Select clock source for internal mclk */
+        {I2C_SEQ_UPDATE, ES8311_CLK_MANAGER_REG01, get_es8311_mclk_src() == FROM_SCLK_PIN ? 0x80 : 0x00, 0x80},
+    };
+    ret |= es8311_run_seq(init_seq, sizeof(init_seq) / sizeof(init_seq[0]));
+    /*
+     * Set clock parammeters
+     */
+    ret |= es8311_config_clock(coeff);
+
+    const i2c_seq_t adc_seq[] = {
+        /* mclk inverted or not */
+        {I2C_SEQ_UPDATE, ES8311_CLK_MANAGER_REG01, INVERT_MCLK ? 0x40 : 0x00, 0x40},
+        /* sclk inverted or not */
+        {I2C_SEQ_UPDATE, ES8311_CLK_MANAGER_REG06, INVERT_SCLK ? 0x20 : 0x00, 0x20},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG13, 0x10, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG1B, 0x0A, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG1C, 0x6A, 0},
+    };
+    ret |= es8311_run_seq(adc_seq, sizeof(adc_seq) / sizeof(adc_seq[0]));
 
     //es8311_pa_power(true);
     return RESULT_OK;
@@ -478,6 +538,8 @@ error_t es8311_codec_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle, in
 
 error_t es8311_codec_deinit()
 {
+    i2c_reg_map_release(es8311_regs);
+    es8311_regs = NULL;
     return RESULT_OK;
 }
 
@@ -612,32 +674,21 @@ error_t es8311_start(codec_mode_t mode)
         dac_iface &= ~(BIT(6));
     }
 
-    ret |= es8311_write_reg(ES8311_SDPIN_REG09, dac_iface);
-    ret |= es8311_write_reg(ES8311_SDPOUT_REG0A, adc_iface);
-
-    ret |= es8311_write_reg(ES8311_ADC_REG17, 0xBF);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG0E, 0x02);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG12, 0x00);
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG14, 0x1A);
-
-    /*
-     * pdm dmic enable or disable
-     */
-    int regv = 0;
-    if (IS_DMIC) {
-        regv = es8311_read_reg(ES8311_SYSTEM_REG14);
-        regv |= 0x40;
-        ret |= es8311_write_reg(ES8311_SYSTEM_REG14, regv);
-    } else {
-        regv = es8311_read_reg(ES8311_SYSTEM_REG14);
-        regv &= ~(0x40);
-        ret |= es8311_write_reg(ES8311_SYSTEM_REG14, regv);
-    }
-
-    ret |= es8311_write_reg(ES8311_SYSTEM_REG0D, 0x01);
-    ret |= es8311_write_reg(ES8311_ADC_REG15, 0x40);
-    ret |= es8311_write_reg(ES8311_DAC_REG37, 0x48);
-    ret |= es8311_write_reg(ES8311_GP_REG45, 0x00);
+    const i2c_seq_t start_seq[] = {
+        {I2C_SEQ_WRITE, ES8311_SDPIN_REG09, dac_iface, 0},
+        {I2C_SEQ_WRITE, ES8311_SDPOUT_REG0A, adc_iface, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG17, 0xBF, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG0E, 0x02, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG12, 0x00, 0},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG14, 0x1A, 0},
+        /* pdm dmic enable or disable */
+        {I2C_SEQ_UPDATE, ES8311_SYSTEM_REG14, IS_DMIC ? 0x40 : 0x00, 0x40},
+        {I2C_SEQ_WRITE, ES8311_SYSTEM_REG0D, 0x01, 0},
+        {I2C_SEQ_WRITE, ES8311_ADC_REG15, 0x40, 0},
+        {I2C_SEQ_WRITE, ES8311_DAC_REG37, 0x48, 0},
+        {I2C_SEQ_WRITE, ES8311_GP_REG45, 0x00, 0},
+    };
+    ret |= es8311_run_seq(start_seq, sizeof(start_seq) / sizeof(start_seq[0]));
 
     return ret;
 }
@@ -685,6 +736,24 @@ error_t es8311_set_voice_mute(bool enable)
     return RESULT_OK;
 }
 
+error_t es8311_config_sample(samplerate_t sample)
+{
+    error_t ret = RESULT_OK;
+    int mute = 0;
+    int coeff = es8311_get_sample_coeff(sample);
+    if (coeff < 0) {
+        return RESULT_FAIL;
+    }
+    /* the dac is muted while the clocks change */
+    es8311_get_voice_mute(&mute);
+    es8311_mute(1);
+    ret |= es8311_config_clock(coeff);
+    if (!mute) {
+        es8311_mute(0);
+    }
+    return ret;
+}
+
 error_t es8311_get_voice_mute(int *mute)
 {
     error_t res = RESULT_OK;
@@ -706,8 +775,9 @@ error_t es8311_set_mic_gain(es8311_mic_gain_t gain_db)
 
 void es8311_read_all()
 {
+    uint8_t regs[0x4A] = {0};
+    i2c_bus_read_regs(i2c_handle, i2c_address_es8311, 0, regs, sizeof(regs), ES_I2C_AUTO_INCREMENT);
     for (int i = 0; i < 0x4A; i++) {
-        uint8_t reg = es8311_read_reg(i);
-        AD_LOGI("REG:%02x, %02x", reg, i);
+        AD_LOGI("REG:%02x, %02x", regs[i], i);
     }
 }
@@ -126,6 +126,12 @@ typedef enum {
  */
 error_t es8311_codec_init(codec_config_t *codec_cfg, i2c_bus_handle_t handle, int8_t mclk_src, int i2c_address);
 
+/* time in ms for which es8311_reset() holds the digital blocks in reset */
+#define ES8311_RESET_TIME_MS 10
+/* begin in steps: es8311_reset(), wait ES8311_RESET_TIME_MS and
+   es8311_codec_init(), which powers on the chip again */
+error_t es8311_reset(i2c_bus_handle_t handle, int i2c_address);
+
 /**
  * @brief Deinitialize ES8311 codec chip
  *
@@ -258,6 +264,18 @@ error_t es8311_get_voice_mute(int *mute);
  */
 error_t es8311_set_mic_gain(es8311_mic_gain_t gain_db);
 
+/**
+ * @brief Changes only the clock configuration for the sample rate: the dac is
+ *        muted during the change
+ *
+ * @param sample: sample rate
+ *
+ * @return
+ *     - RESULT_FAIL the rate is not supported
+ *     - RESULT_OK   Success
+ */
+error_t es8311_config_sample(samplerate_t sample);
+
 /**
  * @brief Print all ES8311 registers
  *
@@ -266,6 +284,30 @@ error_t es8311_set_mic_gain(es8311_mic_gain_t gain_db);
  */
 void es8311_read_all();
 
+/**
+ * @brief Looks up the clock coefficients for the mclk and sample rate
+ *
+ * @param mclk: master clock frequency in Hz
+ * @param rate: sample rate in Hz
+ *
+ * @return
+ *     - index of the entry in the coefficient table
+ *     - (-1) if the combination is not supported
+ */
+int es8311_get_coeff(uint32_t mclk, uint32_t rate);
+
+/**
+ * @brief Provides the sample rates which are supported with the mclk
+ *
+ * @param mclk: master clock frequency in Hz (0: 256 * rate)
+ * @param[out] rates: array which receives the rates (can be NULL)
+ * @param max: size of the rates array
+ *
+ * @return
+ *     - number of supported rates
+ */
+int es8311_get_rates(uint32_t mclk, uint32_t *rates, int max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,8 @@
 static int codec_init_flag = 0;
 static i2c_bus_handle_t i2c_handle;
 static int i2c_address_es8374 = ES8374_ADDR;
+/* image of the registers, so that bit updates need no read */
+static i2c_reg_map_t *es8374_regs = NULL;
 
 
 static bool es8374_codec_initialized()
@@ -45,12 +47,18 @@ static bool es8374_codec_initialized()
 
 static error_t es_write_reg(uint8_t slave_addr, uint8_t reg_add, uint8_t data)
 {
-    return i2c_bus_write_bytes(i2c_handle, slave_addr, &reg_add, sizeof(reg_add), &data, sizeof(data));
+    return i2c_bus_write_reg_cached(i2c_handle, slave_addr, es8374_regs, reg_add, data);
 }
 
 static error_t es_read_reg(uint8_t slave_addr, uint8_t reg_add, uint8_t *p_data)
 {
-    return i2c_bus_read_bytes(i2c_handle, slave_addr, &reg_add, sizeof(reg_add), p_data, 1);
+    return i2c_bus_read_reg_cached(i2c_handle, slave_addr, es8374_regs, reg_add, p_data);
+}
+
+// read-modify-write of the bits in mask: only written if the value changes
+static error_t es8374_update_reg(uint8_t reg_add, uint8_t mask, uint8_t value)
+{
+    return i2c_bus_update_reg_cached(i2c_handle, i2c_address_es8374, es8374_regs, reg_add, mask, value);
 }
 
 
@@ -59,6 +67,120 @@ error_t es8374_write_reg(uint8_t reg_add, uint8_t data)
     return es_write_reg(i2c_address_es8374, reg_add, data);
 }
 
+static error_t es8374_run_seq(const i2c_seq_t *seq, int count)
+{
+    return i2c_bus_run_seq(i2c_handle, i2c_address_es8374, es8374_regs, seq, count, ES_I2C_AUTO_INCREMENT);
+}
+
+static const i2c_seq_t es8374_reset_seq[] = {
+    {I2C_SEQ_WRITE, 0x00, 0x3F, 0}, //IC Rst start
+    {I2C_SEQ_WRITE, 0x00, 0x03, 0}, //IC Rst stop
+    {I2C_SEQ_WRITE, 0x01, 0x7F, 0}, //IC clk on
+};
+
+static const i2c_seq_t es8374_pll_seq[] = {
+    {I2C_SEQ_WRITE, 0x6F, 0xA0, 0}, //pll set:mode enable
+    {I2C_SEQ_WRITE, 0x72, 0x41, 0}, //pll set:mode set
+    {I2C_SEQ_WRITE, 0x09, 0x01, 0}, //pll set:reset on ,set start
+    {I2C_SEQ_WRITE, 0x0C, 0x22, 0}, //pll set:k
+    {I2C_SEQ_WRITE, 0x0D, 0x2E, 0}, //pll set:k
+    {I2C_SEQ_WRITE, 0x0E, 0xC6, 0}, //pll set:k
+    {I2C_SEQ_WRITE, 0x0A, 0x3A, 0}, //pll set:
+    {I2C_SEQ_WRITE, 0x0B, 0x07, 0}, //pll set:n
+    {I2C_SEQ_WRITE, 0x09, 0x41, 0}, //pll set:reset off ,set stop
+};
+
+static const i2c_seq_t es8374_timing_seq[] = {
+    {I2C_SEQ_WRITE, 0x24, 0x08, 0}, //adc set
+    {I2C_SEQ_WRITE, 0x36, 0x00, 0}, //dac set
+    {I2C_SEQ_WRITE, 0x12, 0x30, 0}, //timming set
+    {I2C_SEQ_WRITE, 0x13, 0x20, 0}, //timming set
+};
+
+static const i2c_seq_t es8374_adc_seq[] = {
+    {I2C_SEQ_WRITE, 0x21, 0x50, 0}, //adc set: SEL LIN1 CH+PGAGAIN=0DB
+    {I2C_SEQ_WRITE, 0x22, 0xFF, 0}, //adc set: PGA GAIN=0DB
+    {I2C_SEQ_WRITE, 0x21, 0x14, 0}, //adc set: SEL LIN1 CH+PGAGAIN=18DB
+    {I2C_SEQ_WRITE, 0x22, 0x55, 0}, //pga = +15db
+    {I2C_SEQ_WRITE, 0x08, 0x21, 0}, //set class d divider = 33, to avoid the high frequency tone on laudspeaker
+    {I2C_SEQ_WRITE, 0x00, 0x80, 0}, // IC START
+};
+
+static const i2c_seq_t es8374_output_seq[] = {
+    {I2C_SEQ_WRITE, 0x14, 0x8A, 0}, // IC START
+    {I2C_SEQ_WRITE, 0x15, 0x40, 0}, // IC START
+    {I2C_SEQ_WRITE, 0x1A, 0xA0, 0}, // monoout set
+    {I2C_SEQ_WRITE, 0x1B, 0x19, 0}, // monoout set
+    {I2C_SEQ_WRITE, 0x1C, 0x90, 0}, // spk set
+    {I2C_SEQ_WRITE, 0x1D, 0x01, 0}, // spk set
+    {I2C_SEQ_WRITE, 0x1F, 0x00, 0}, // spk set
+    {I2C_SEQ_WRITE, 0x1E, 0x20, 0}, // spk on
+    {I2C_SEQ_WRITE, 0x28, 0x00, 0}, // alc set
+    {I2C_SEQ_WRITE, 0x25, 0x00, 0}, // ADCVOLUME on
+    {I2C_SEQ_WRITE, 0x38, 0x00, 0}, // DACVOLUME on
+    {I2C_SEQ_WRITE, 0x37, 0x30, 0}, // dac set
+    {I2C_SEQ_WRITE, 0x6D, 0x60, 0}, //SEL:GPIO1=DMIC CLK OUT+SEL:GPIO2=PLL CLK OUT
+    {I2C_SEQ_WRITE, 0x71, 0x05, 0}, //for automute setting
+    {I2C_SEQ_WRITE, 0x73, 0x70, 0},
+};
+
+static const i2c_seq_t es8374_output_device_seq[] = {
+    {I2C_SEQ_WRITE, 0x1D, 0x02, 0},    // spk set
+    {I2C_SEQ_UPDATE, 0x1C, 0x80, 0x80}, // set spk mixer
+    {I2C_SEQ_WRITE, 0x1D, 0x02, 0},    // spk set
+    {I2C_SEQ_WRITE, 0x1F, 0x00, 0},    // spk set
+    {I2C_SEQ_WRITE, 0x1E, 0xA0, 0},    // spk on
+};
+
+static const i2c_seq_t es8374_start_line_in_seq[] = {
+    {I2C_SEQ_UPDATE, 0x1A, 0x60, 0x68}, //set monomixer
+    {I2C_SEQ_UPDATE, 0x1C, 0x40, 0x40}, // set spk mixer
+    {I2C_SEQ_WRITE, 0x1D, 0x02, 0},     // spk set
+    {I2C_SEQ_WRITE, 0x1F, 0x00, 0},     // spk set
+    {I2C_SEQ_WRITE, 0x1E, 0xA0, 0},     // spk on
+};
+
+static const i2c_seq_t es8374_start_adc_seq[] = {
+    {I2C_SEQ_UPDATE, 0x21, 0x00, 0xC0}, //power up adc and input
+    {I2C_SEQ_UPDATE, 0x10, 0x00, 0xC0}, //power up adc and input
+};
+
+static const i2c_seq_t es8374_start_dac_seq[] = {
+    {I2C_SEQ_UPDATE, 0x1A, 0x08, 0x08}, //disable lout
+    {I2C_SEQ_UPDATE, 0x1A, 0x00, 0x20},
+    {I2C_SEQ_WRITE, 0x1D, 0x12, 0},     // mute speaker
+    {I2C_SEQ_WRITE, 0x1E, 0x20, 0},     // disable class d
+    {I2C_SEQ_UPDATE, 0x15, 0x00, 0x20}, //power up dac
+    {I2C_SEQ_UPDATE, 0x1A, 0x20, 0x20}, //disable lout
+    {I2C_SEQ_UPDATE, 0x1A, 0x00, 0x08},
+    {I2C_SEQ_WRITE, 0x1D, 0x02, 0},     // mute speaker
+    {I2C_SEQ_WRITE, 0x1E, 0xA0, 0},     // disable class d
+    {I2C_SEQ_UPDATE, 0x36, 0x00, 0x20}, // unmute
+};
+
+static const i2c_seq_t es8374_stop_line_in_seq[] = {
+    {I2C_SEQ_UPDATE, 0x1A, 0x08, 0x08}, //disable lout
+    {I2C_SEQ_UPDATE, 0x1A, 0x00, 0x60},
+    {I2C_SEQ_WRITE, 0x1D, 0x12, 0},     // mute speaker
+    {I2C_SEQ_WRITE, 0x1E, 0x20, 0},     // disable class d
+    {I2C_SEQ_UPDATE, 0x1C, 0x00, 0x40}, // disable spkmixer
+    {I2C_SEQ_WRITE, 0x1F, 0x00, 0},     // spk set
+};
+
+static const i2c_seq_t es8374_stop_dac_seq[] = {
+    {I2C_SEQ_UPDATE, 0x36, 0x20, 0x20}, // mute
+    {I2C_SEQ_UPDATE, 0x1A, 0x08, 0x08}, //disable lout
+    {I2C_SEQ_UPDATE, 0x1A, 0x00, 0x20},
+    {I2C_SEQ_WRITE, 0x1D, 0x12, 0},     // mute speaker
+    {I2C_SEQ_WRITE, 0x1E, 0x20, 0},     // disable class d
+    {I2C_SEQ_UPDATE, 0x15, 0x20, 0x20}, //power down dac
+};
+
+static const i2c_seq_t es8374_stop_adc_seq[] = {
+    {I2C_SEQ_UPDATE, 0x10, 0xC0, 0xC0}, //power down adc and input
+    {I2C_SEQ_UPDATE, 0x21, 0xC0, 0xC0}, //power down adc and input
+};
+
 int es8374_read_reg(uint8_t reg_add, uint8_t *regv)
 {
     uint8_t regdata = 0xFF;
@@ -76,25 +198,16 @@ int es8374_read_reg(uint8_t reg_add, uint8_t *regv)
 
 void es8374_read_all()
 {
+    uint8_t regs[50] = {0};
+    i2c_bus_read_regs(i2c_handle, i2c_address_es8374, 0, regs, sizeof(regs), ES_I2C_AUTO_INCREMENT);
     for (int i = 0; i < 50; i++) {
-        uint8_t reg = 0;
-        es8374_read_reg(i, &reg);
-        AD_LOGI( "%x: %x", i, reg);
+        AD_LOGI( "%x: %x", i, regs[i]);
     }
 }
 
 error_t es8374_set_voice_mute(bool enable)
 {
-    error_t res = RESULT_OK;
-    uint8_t reg = 0;
-
-    res |= es8374_read_reg(0x36, &reg);
-    if (res == 0) {
-        reg = reg & 0xdf;
-        res |= es8374_write_reg(0x36, reg | (((int)enable) << 5));
-    }
-
-    return res;
+    return es8374_update_reg(0x36, 0x20, ((int)enable) << 5);
 }
 
 error_t es8374_get_voice_mute(void)
@@ -113,22 +226,13 @@ error_t es8374_get_voice_mute(void)
 error_t es8374_set_bits_per_sample(codec_mode_t mode, sample_bits_t bit_per_sample)
 {
     error_t res = RESULT_OK;
-    uint8_t reg = 0;
     int bits = (int)bit_per_sample & 0x0f;
 
     if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH) {
-        res |= es8374_read_reg(0x10, &reg);
-        if (res == 0) {
-            reg = reg & 0xe3;
-            res |=  es8374_write_reg(0x10, reg | (bits << 2));
-        }
+        res |= es8374_update_reg(0x10, 0x1c, bits << 2);
     }
     if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
-        res |= es8374_read_reg(0x11, &reg);
-        if (res == 0) {
-            reg = reg & 0xe3;
-            res |= es8374_write_reg(0x11, reg | (bits << 2));
-        }
+        res |= es8374_update_reg(0x11, 0x1c, bits << 2);
     }
 
     return res;
@@ -137,24 +241,20 @@ error_t es8374_set_bits_per_sample(codec_mode_t mode, sample_bits_t bit_per_samp
 error_t es8374_config_fmt(codec_mode_t mode, i2s_format_t fmt)
 {
     error_t res = RESULT_OK;
-    uint8_t reg = 0;
     int fmt_tmp, fmt_i2s;
 
     fmt_tmp = ((fmt & 0xf0) >> 4);
     fmt_i2s =  fmt & 0x0f;
     if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH) {
-        res |= es8374_read_reg(0x10, &reg);
+        // the i2s format bits are ored in, like before
+        res |= es8374_update_reg(0x10, 0x03 | fmt_i2s, fmt_i2s);
         if (res == 0) {
-            reg = reg & 0xfc;
-            res |= es8374_write_reg(0x10, reg | fmt_i2s);
             res |= es8374_set_bits_per_sample(mode, fmt_tmp);
         }
     }
     if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
-        res |= es8374_read_reg(0x11, &reg);
+        res |= es8374_update_reg(0x11, 0x03 | fmt_i2s, fmt_i2s);
         if (res == 0) {
-            reg = reg & 0xfc;
-            res |= es8374_write_reg(0x11, reg | (fmt_i2s));
             res |= es8374_set_bits_per_sample(mode, fmt_tmp);
         }
     }
@@ -165,50 +265,15 @@ error_t es8374_config_fmt(codec_mode_t mode, i2s_format_t fmt)
 error_t es8374_start(codec_mode_t mode)
 {
     error_t res = RESULT_OK;
-    uint8_t reg = 0;
 
     if (mode == CODEC_MODE_LINE_IN) {
-        res |= es8374_read_reg(0x1a, &reg);       //set monomixer
-        reg |= 0x60;
-        reg |= 0x20;
-        reg &= 0xf7;
-        res |= es8374_write_reg( 0x1a, reg);
-        res |= es8374_read_reg(0x1c, &reg);        // set spk mixer
-        reg |= 0x40;
-        res |= es8374_write_reg( 0x1c, reg);
-        res |= es8374_write_reg(0x1D, 0x02);      // spk set
-        res |= es8374_write_reg(0x1F, 0x00);      // spk set
-        res |= es8374_write_reg(0x1E, 0xA0);      // spk on
+        res |= es8374_run_seq(es8374_start_line_in_seq, sizeof(es8374_start_line_in_seq) / sizeof(es8374_start_line_in_seq[0]));
     }
     if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH || mode == CODEC_MODE_LINE_IN) {
-        res |= es8374_read_reg(0x21, &reg);       //power up adc and input
-        reg &= 0x3f;
-        res |= es8374_write_reg(0x21, reg);
-        res |= es8374_read_reg(0x10, &reg);       //power up adc and input
-        reg &= 0x3f;
-        res |= es8374_write_reg(0x10, reg);
+        res |= es8374_run_seq(es8374_start_adc_seq, sizeof(es8374_start_adc_seq) / sizeof(es8374_start_adc_seq[0]));
     }
-
     if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH || mode == CODEC_MODE_LINE_IN) {
-        res |= es8374_read_reg(0x1a, &reg);       //disable lout
-        reg |= 0x08;
-        res |= es8374_write_reg( 0x1a, reg);
-        reg &= 0xdf;
-        res |= es8374_write_reg( 0x1a, reg);
-        res |= es8374_write_reg(0x1D, 0x12);      // mute speaker
-        res |= es8374_write_reg(0x1E, 0x20);      // disable class d
-        res |= es8374_read_reg(0x15, &reg);        //power up dac
-        reg &= 0xdf;
-        res |= es8374_write_reg(0x15, reg);
-        res |= es8374_read_reg(0x1a, &reg);        //disable lout
-        reg |= 0x20;
-        res |= es8374_write_reg( 0x1a, reg);
-        reg &= 0xf7;
-        res |= es8374_write_reg( 0x1a, reg);
-        res |= es8374_write_reg(0x1D, 0x02);      // mute speaker
-        res |= es8374_write_reg(0x1E, 0xa0);      // disable class d
-
-        res |= es8374_set_voice_mute(false);
+        res |= es8374_run_seq(es8374_start_dac_seq, sizeof(es8374_start_dac_seq) / sizeof(es8374_start_dac_seq[0]));
     }
 
     return res;
@@ -217,43 +282,15 @@ error_t es8374_start(codec_mode_t mode)
 error_t es8374_stop(codec_mode_t mode)
 {
     error_t res = RESULT_OK;
-    uint8_t reg = 0;
 
     if (mode == CODEC_MODE_LINE_IN) {
-        res |= es8374_read_reg(0x1a, &reg);       //disable lout
-        reg |= 0x08;
-        res |= es8374_write_reg( 0x1a, reg);
-        reg &= 0x9f;
-        res |= es8374_write_reg( 0x1a, reg);
-        res |= es8374_write_reg(0x1D, 0x12);      // mute speaker
-        res |= es8374_write_reg(0x1E, 0x20);      // disable class d
-        res |= es8374_read_reg(0x1c, &reg);        // disable spkmixer
-        reg &= 0xbf;
-        res |= es8374_write_reg( 0x1c, reg);
-        res |= es8374_write_reg(0x1F, 0x00);      // spk set
+        res |= es8374_run_seq(es8374_stop_line_in_seq, sizeof(es8374_stop_line_in_seq) / sizeof(es8374_stop_line_in_seq[0]));
     }
     if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
-        res |= es8374_set_voice_mute(true);
-
-        res |= es8374_read_reg(0x1a, &reg);        //disable lout
-        reg |= 0x08;
-        res |= es8374_write_reg( 0x1a, reg);
-        reg &= 0xdf;
-        res |= es8374_write_reg( 0x1a, reg);
-        res |= es8374_write_reg(0x1D, 0x12);      // mute speaker
-        res |= es8374_write_reg(0x1E, 0x20);      // disable class d
-        res |= es8374_read_reg(0x15, &reg);        //power up dac
-        reg |= 0x20;
-        res |= es8374_write_reg(0x15, reg);
+        res |= es8374_run_seq(es8374_stop_dac_seq, sizeof(es8374_stop_dac_seq) / sizeof(es8374_stop_dac_seq[0]));
     }
     if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH) {
-
-        res |= es8374_read_reg(0x10, &reg);       //power up adc and input
-        reg |= 0xc0;
-        res |= es8374_write_reg(0x10, reg);
-        res |= es8374_read_reg(0x21, &reg);       //power up adc and input
-        reg |= 0xc0;
-        res |= es8374_write_reg(0x21, reg);
+        res |= es8374_run_seq(es8374_stop_adc_seq, sizeof(es8374_stop_adc_seq) / sizeof(es8374_stop_adc_seq[0]));
     }
 
     return res;
@@ -263,10 +300,7 @@ error_t es8374_i2s_config_clock(es_i2s_clock_t cfg)
 {
 
     error_t res = RESULT_OK;
-    uint8_t reg = 0;
 
-    res |= es8374_read_reg(0x0f, &reg);       //power up adc and input
-    reg &= 0xe0;
     int divratio = 0;
     switch (cfg.sclk_div) {
         case MCLK_DIV_1:
@@ -365,8 +399,7 @@ error_t es8374_i2s_config_clock(es_i2s_clock_t cfg)
         default:
             break;
     }
-    reg |= divratio;
-    res |= es8374_write_reg(0x0f, reg);
+    res |= es8374_update_reg(0x0f, 0x1f, divratio);       //power up adc and input
 
     int dacratio_l = 0;
     int dacratio_h = 0;
@@ -483,36 +516,15 @@ error_t es8374_i2s_config_clock(es_i2s_clock_t cfg)
 
 error_t es8374_config_output_device()
 {
-    error_t res = RESULT_OK;
-    uint8_t reg = 0;
-
-    reg = 0x1d;
-
-    res = es8374_write_reg(reg, 0x02);
-    res |= es8374_read_reg(0x1c, &reg); // set spk mixer
-    reg |= 0x80;
-    res |= es8374_write_reg(0x1c, reg);
-    res |= es8374_write_reg(0x1D, 0x02); // spk set
-    res |= es8374_write_reg(0x1F, 0x00); // spk set
-    res |= es8374_write_reg(0x1E, 0xA0); // spk on
-
-    return res;
+    return es8374_run_seq(es8374_output_device_seq, sizeof(es8374_output_device_seq) / sizeof(es8374_output_device_seq[0]));
 }
 
 
 
 error_t es8374_config_input_device()
 {
-    error_t res = RESULT_OK;
-    uint8_t reg = 0;
-
-    res |= es8374_read_reg(0x21, &reg);
-    if (res == 0) {
-        reg = (reg & 0xcf) | 0x14;
-        res |= es8374_write_reg( 0x21, reg);
-    }
-
-    return res;
+    // clears bits 4-5 and sets bits 2 and 4
+    return es8374_update_reg(0x21, 0x34, 0x14);
 }
 
 error_t es8374_set_mic_gain(es_mic_gain_t gain)
@@ -594,13 +606,9 @@ static int es8374_set_adc_dac_volume(int mode, int volume, int dot)
 static int es8374_set_d2se_pga(es_d2se_pga_t gain)
 {
     int res = 0;
-    uint8_t reg = 0;
 
     if (gain > ES8374_PGA_GAIN_MIN && gain < ES8374_PGA_GAIN_MAX) {
-        res = es8374_read_reg(0x21, &reg);
-        reg &= 0xfb;
-        reg |= gain << 2;
-        res = es8374_write_reg(0x21, reg); //MIC PGA
+        res = es8374_update_reg(0x21, 0x04, gain << 2); //MIC PGA
     } else {
         res = 0xff;
         AD_LOGI("invalid microphone gain!");
@@ -612,63 +620,32 @@ static int es8374_set_d2se_pga(es_d2se_pga_t gain)
 static int es8374_init_reg(codec_mode_t ms_mode, i2s_format_t fmt, es_i2s_clock_t cfg)
 {
     int res = 0;
-    uint8_t reg;
-
-    res |= es8374_write_reg(0x00, 0x3F); //IC Rst start
-    res |= es8374_write_reg(0x00, 0x03); //IC Rst stop
-    res |= es8374_write_reg(0x01, 0x7F); //IC clk on
-
-    res |= es8374_read_reg(0x0F, &reg);
-    reg &= 0x7f;
-    reg |=  (ms_mode << 7);
-    res |= es8374_write_reg( 0x0f, reg); //CODEC IN I2S SLAVE MODE
-
-    res |= es8374_write_reg(0x6F, 0xA0); //pll set:mode enable
-    res |= es8374_write_reg(0x72, 0x41); //pll set:mode set
-    res |= es8374_write_reg(0x09, 0x01); //pll set:reset on ,set start
-    res |= es8374_write_reg(0x0C, 0x22); //pll set:k
-    res |= es8374_write_reg(0x0D, 0x2E); //pll set:k
-    res |= es8374_write_reg(0x0E, 0xC6); //pll set:k
-    res |= es8374_write_reg(0x0A, 0x3A); //pll set:
-    res |= es8374_write_reg(0x0B, 0x07); //pll set:n
-    res |= es8374_write_reg(0x09, 0x41); //pll set:reset off ,set stop
+
+    /* the reset below restores the default values: forget the old ones */
+    i2c_reg_map_release(es8374_regs);
+    es8374_regs = i2c_reg_map_get(i2c_handle, i2c_address_es8374);
+    i2c_reg_map_invalidate(es8374_regs);
+    i2c_reg_map_set_volatile(es8374_regs, 0x00);
+    res |= es8374_run_seq(es8374_reset_seq, sizeof(es8374_reset_seq) / sizeof(es8374_reset_seq[0]));
+
+    res |= es8374_update_reg(0x0f, 0x80, ms_mode << 7); //CODEC IN I2S SLAVE MODE
+
+    res |= es8374_run_seq(es8374_pll_seq, sizeof(es8374_pll_seq) / sizeof(es8374_pll_seq[0]));
 
     res |= es8374_i2s_config_clock(cfg);
 
-    res |= es8374_write_reg(0x24, 0x08); //adc set
-    res |= es8374_write_reg(0x36, 0x00); //dac set
-    res |= es8374_write_reg(0x12, 0x30); //timming set
-    res |= es8374_write_reg(0x13, 0x20); //timming set
+    res |= es8374_run_seq(es8374_timing_seq, sizeof(es8374_timing_seq) / sizeof(es8374_timing_seq[0]));
 
     // TODO
     res |= es8374_config_fmt(CODEC_MODE_ENCODE, fmt);
     res |= es8374_config_fmt(CODEC_MODE_DECODE, fmt);
 
-    res |= es8374_write_reg(0x21, 0x50); //adc set: SEL LIN1 CH+PGAGAIN=0DB
-    res |= es8374_write_reg(0x22, 0xFF); //adc set: PGA GAIN=0DB
-    res |= es8374_write_reg(0x21, 0x14); //adc set: SEL LIN1 CH+PGAGAIN=18DB
-    res |= es8374_write_reg(0x22, 0x55); //pga = +15db
-    res |= es8374_write_reg(0x08, 0x21); //set class d divider = 33, to avoid the high frequency tone on laudspeaker
-    res |= es8374_write_reg(0x00, 0x80); // IC START
+    res |= es8374_run_seq(es8374_adc_seq, sizeof(es8374_adc_seq) / sizeof(es8374_adc_seq[0]));
 
     res |= es8374_set_adc_dac_volume(CODEC_MODE_ENCODE, 0, 0);      // 0db
     res |= es8374_set_adc_dac_volume(CODEC_MODE_DECODE, 0, 0);      // 0db
 
-    res |= es8374_write_reg(0x14, 0x8A); // IC START
-    res |= es8374_write_reg(0x15, 0x40); // IC START
-    res |= es8374_write_reg(0x1A, 0xA0); // monoout set
-    res |= es8374_write_reg(0x1B, 0x19); // monoout set
-    res |= es8374_write_reg(0x1C, 0x90); // spk set
-    res |= es8374_write_reg(0x1D, 0x01); // spk set
-    res |= es8374_write_reg(0x1F, 0x00); // spk set
-    res |= es8374_write_reg(0x1E, 0x20); // spk on
-    res |= es8374_write_reg(0x28, 0x00); // alc set
-    res |= es8374_write_reg(0x25, 0x00); // ADCVOLUME on
-    res |= es8374_write_reg(0x38, 0x00); // DACVOLUME on
-    res |= es8374_write_reg(0x37, 0x30); // dac set
-    res |= es8374_write_reg(0x6D, 0x60); //SEL:GPIO1=DMIC CLK OUT+SEL:GPIO2=PLL CLK OUT
-    res |= es8374_write_reg(0x71, 0x05); //for automute setting
-    res |= es8374_write_reg(0x73, 0x70);
+    res |= es8374_run_seq(es8374_output_seq, sizeof(es8374_output_seq) / sizeof(es8374_output_seq[0]));
 
     res |= es8374_config_output_device();  //0x3c Enable DAC and Enable Lout/Rout/1/2
     res |= es8374_config_input_device();  //0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input; DSSEL,use one DS Reg11; DSR, LINPUT1-RINPUT1
@@ -709,7 +686,10 @@ error_t es8374_codec_init(codec_config_t *cfg, codec_mode_t codec_mode, void* i2
 error_t es8374_codec_deinit(void)
 {
     codec_init_flag = 0;
-    return es8374_write_reg(0x00, 0x7F); // IC Reset and STOP
+    error_t res = es8374_write_reg(0x00, 0x7F); // IC Reset and STOP
+    i2c_reg_map_release(es8374_regs);
+    es8374_regs = NULL;
+    return res;
 }
 error_t es8374_codec_config_i2s(codec_mode_t mode, I2SDefinition *iface)
 {
@@ -41,6 +41,8 @@ typedef enum {
 // #include "audio_hal/board_pins_config.h"
 
 static i2c_bus_handle_t i2c_handle = NULL;
+/* image of the registers, so that bit updates need no read */
+static i2c_reg_map_t *es8388_regs = NULL;
 static int dac_power = 0x3c;
 
 #define ES_ASSERT(a, format, b, ...) \
@@ -50,21 +52,33 @@ static int dac_power = 0x3c;
   }
 
 static error_t es_write_reg(uint8_t slave_addr, uint8_t reg_add, uint8_t data) {
-  return i2c_bus_write_bytes(i2c_handle, slave_addr, &reg_add, sizeof(reg_add),
-                             &data, sizeof(data));
+  return i2c_bus_write_reg_cached(i2c_handle, slave_addr, es8388_regs, reg_add,
+                                  data);
+}
+
+static error_t es_run_seq(const i2c_seq_t *seq, int count) {
+  return i2c_bus_run_seq(i2c_handle, ES8388_ADDR, es8388_regs, seq, count,
+                         ES_I2C_AUTO_INCREMENT);
 }
 
 static error_t es_read_reg(uint8_t reg_add, uint8_t *p_data) {
-  return i2c_bus_read_bytes(i2c_handle, ES8388_ADDR, &reg_add, sizeof(reg_add),
-                            p_data, 1);
+  return i2c_bus_read_reg_cached(i2c_handle, ES8388_ADDR, es8388_regs, reg_add,
+                                 p_data);
+}
+
+// read-modify-write of the bits in mask: only written if the value changes
+static error_t es_update_reg(uint8_t reg_add, uint8_t mask, uint8_t value) {
+  return i2c_bus_update_reg_cached(i2c_handle, ES8388_ADDR, es8388_regs,
+                                   reg_add, mask, value);
 }
 
 void es8388_read_all() {
   AD_LOGD(LOG_METHOD);
+  uint8_t regs[50] = {0};
+  i2c_bus_read_regs(i2c_handle, ES8388_ADDR, 0, regs, sizeof(regs),
+                    ES_I2C_AUTO_INCREMENT);
   for (int i = 0; i < 50; i++) {
-    uint8_t reg = 0;
-    es_read_reg(i, &reg);
-    AD_LOGI("%x: %x", i, reg);
+    AD_LOGI("%x: %x", i, regs[i]);
   }
 }
 
@@ -73,46 +87,7 @@ error_t es8388_write_reg(uint8_t reg_add, uint8_t data) {
 }
 
 error_t es8388_read_reg(uint8_t reg_add, uint8_t *p_data) {
-  return i2c_bus_read_bytes(i2c_handle, ES8388_ADDR, &reg_add, sizeof(reg_add),
-                            p_data, 1);
-}
-
-/**
- * @brief Configure ES8388 ADC and DAC volume. Basicly you can consider this as
- * ADC and DAC gain
- *
- * @param mode:             set ADC or DAC or all
- * @param volume:           -96 ~ 0              for example
- * Es8388SetAdcDacVolume(CODEC_MODE_ENCODE, 30, 6); means set ADC volume -30.5db
- * @param dot:              whether include 0.5. for example
- * Es8388SetAdcDacVolume(CODEC_MODE_ENCODE, 30, 4); means set ADC volume -30db
- *
- * @return
- *     - (-1) Parameter error
- *     - (0)   Success
- */
-static int es8388_set_adc_dac_volume(int mode, int volume, int dot) {
-  AD_LOGD("es8388_set_adc_dac_volume: %d.%d", volume, dot);
-  int res = 0;
-  if (volume < -96 || volume > 0) {
-    AD_LOGW("Warning: volume < -96! or > 0!");
-    if (volume < -96)
-      volume = -96;
-    else
-      volume = 0;
-  }
-  dot = (dot >= 5 ? 1 : 0);
-  volume = (-volume << 1) + dot;
-  if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH) {
-    res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL8, volume);
-    res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL9,
-                        volume);  // ADC Right Volume=0db
-  }
-  if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL5, volume);
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL4, volume);
-  }
-  return res;
+  return es_read_reg(reg_add, p_data);
 }
 
 /**
@@ -132,29 +107,30 @@ error_t es8388_start(codec_mode_t mode) {
   uint8_t prev_data = 0, data = 0;
   es_read_reg(ES8388_DACCONTROL21, &prev_data);
   if (mode == CODEC_MODE_LINE_IN) {
-    res |= es_write_reg(
-        ES8388_ADDR, ES8388_DACCONTROL16,
-        0x09);  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2 by pass enable
-    res |=
-        es_write_reg(ES8388_ADDR, ES8388_DACCONTROL17,
-                     0x50);  // left DAC to left mixer enable  and  LIN signal
-                             // to left mixer enable 0db  : bupass enable
-    res |=
-        es_write_reg(ES8388_ADDR, ES8388_DACCONTROL20,
-                     0x50);  // right DAC to right mixer enable  and  LIN signal
-                             // to right mixer enable 0db : bupass enable
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL21, 0xC0);  // enable adc
+    const i2c_seq_t seq[] = {
+        // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2 by pass enable
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL16, 0x09, 0},
+        // left DAC to left mixer enable  and  LIN signal to left mixer enable
+        // 0db  : bupass enable
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL17, 0x50, 0},
+        // right DAC to right mixer enable  and  LIN signal to right mixer
+        // enable 0db : bupass enable
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL20, 0x50, 0},
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL21, 0xC0, 0},  // enable adc
+    };
+    res |= es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
   } else {
     res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL21, 0x80);  // enable dac
   }
   es_read_reg(ES8388_DACCONTROL21, &data);
   if (prev_data != data) {
-    res |= es_write_reg(ES8388_ADDR, ES8388_CHIPPOWER,
-                        0xF0);  // start state machine
-    // res |= es_write_reg(ES8388_ADDR, ES8388_CONTROL1, 0x16);
-    // res |= es_write_reg(ES8388_ADDR, ES8388_CONTROL2, 0x50);
-    res |= es_write_reg(ES8388_ADDR, ES8388_CHIPPOWER,
-                        0x00);  // start state machine
+    const i2c_seq_t seq[] = {
+        {I2C_SEQ_WRITE, ES8388_CHIPPOWER, 0xF0, 0},  // start state machine
+        // {I2C_SEQ_WRITE, ES8388_CONTROL1, 0x16, 0},
+        // {I2C_SEQ_WRITE, ES8388_CONTROL2, 0x50, 0},
+        {I2C_SEQ_WRITE, ES8388_CHIPPOWER, 0x00, 0},  // start state machine
+    };
+    res |= es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
   }
   if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH ||
       mode == CODEC_MODE_LINE_IN) {
@@ -188,13 +164,13 @@ error_t es8388_stop(codec_mode_t mode) {
   AD_LOGD(LOG_METHOD);
   error_t res = RESULT_OK;
   if (mode == CODEC_MODE_LINE_IN) {
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL21, 0x80);  // enable dac
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL16,
-                        0x00);  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL17,
-                        0x90);  // only left DAC to left mixer enable 0db
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL20,
-                        0x90);  // only right DAC to right mixer enable 0db
+    const i2c_seq_t seq[] = {
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL21, 0x80, 0},  // enable dac
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL16, 0x00, 0},  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL17, 0x90, 0},  // only left DAC to left mixer enable 0db
+        {I2C_SEQ_WRITE, ES8388_DACCONTROL20, 0x90, 0},  // only right DAC to right mixer enable 0db
+    };
+    res |= es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
     return res;
   }
   if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
@@ -234,11 +210,12 @@ error_t es8388_stop(codec_mode_t mode) {
 error_t es8388_i2s_config_clock(es_i2s_clock_t cfg) {
   AD_LOGD(LOG_METHOD);
   error_t res = RESULT_OK;
-  res |= es_write_reg(ES8388_ADDR, ES8388_MASTERMODE, cfg.sclk_div);
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL5,
-                      cfg.lclk_div);  // ADCFsMode,singel SPEED,RATIO=256
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL2,
-                      cfg.lclk_div);  // ADCFsMode,singel SPEED,RATIO=256
+  const i2c_seq_t seq[] = {
+      {I2C_SEQ_WRITE, ES8388_MASTERMODE, (uint8_t)cfg.sclk_div, 0},
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL5, (uint8_t)cfg.lclk_div, 0},  // ADCFsMode,singel SPEED,RATIO=256
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL2, (uint8_t)cfg.lclk_div, 0},  // ADCFsMode,singel SPEED,RATIO=256
+  };
+  res |= es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
   return res;
 }
 
@@ -250,6 +227,8 @@ error_t es8388_deinit(void) {
 #ifdef CONFIG_ESP_LYRAT_V4_3_BOARD
   headphone_detect_deinit();
 #endif
+  i2c_reg_map_release(es8388_regs);
+  es8388_regs = NULL;
 
   return res;
 }
@@ -273,45 +252,11 @@ error_t es8388_init(codec_config_t *cfg, i2c_bus_handle_t handle) {
   } else {
     AD_LOGI("Found ES8388");
   }
+  // the chip state is unknown
+  i2c_reg_map_release(es8388_regs);
+  es8388_regs = i2c_reg_map_get(i2c_handle, ES8388_ADDR);
+  i2c_reg_map_invalidate(es8388_regs);
 
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL3,
-                      0x04);  // 0x04 mute/0x00 unmute&ramp;DAC unmute and
-                              // disabled digital volume control soft ramp
-  /* Chip Control and Power Management */
-  res |= es_write_reg(ES8388_ADDR, ES8388_CONTROL2, 0x50);
-  res |= es_write_reg(ES8388_ADDR, ES8388_CHIPPOWER,
-                      0x00);  // normal all and power up all
-
-  // Disable the internal DLL to improve 8K sample rate
-  res |= es_write_reg(ES8388_ADDR, 0x35, 0xA0);
-  res |= es_write_reg(ES8388_ADDR, 0x37, 0xD0);
-  res |= es_write_reg(ES8388_ADDR, 0x39, 0xD0);
-
-  res |= es_write_reg(ES8388_ADDR, ES8388_MASTERMODE,
-                      cfg->i2s.mode);  // CODEC IN I2S SLAVE MODE
-
-  /* dac */
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACPOWER,
-                      0xC0);  // disable DAC and disable Lout/Rout/1/2
-  res |= es_write_reg(ES8388_ADDR, ES8388_CONTROL1,
-                      0x12);  // Enfr=0,Play&Record Mode,(0x17-both of mic&paly)
-  //    res |= es_write_reg(ES8388_ADDR, ES8388_CONTROL2, 0);
-  //    //LPVrefBuf=0,Pdn_ana=0
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL1,
-                      0x18);  // 1a 0x18:16bit iis , 0x00:24
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL2,
-                      0x02);  // DACFsMode,SINGLE SPEED; DACFsRatio,256
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL16,
-                      0x00);  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL17,
-                      0x90);  // only left DAC to left mixer enable 0db
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL20,
-                      0x90);  // only right DAC to right mixer enable 0db
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL21,
-                      0x80);  // set internal ADC and DAC use the same LRCK
-                              // clock, ADC LRCK as internal LRCK
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL23, 0x00);  // vroi=0
-  res |= es8388_set_adc_dac_volume(CODEC_MODE_DECODE, 0, 0);    // 0db
   dac_power = 0;
   AD_LOGI("output_device: %d", cfg->output_device);
   if (DAC_OUTPUT_LINE1 == cfg->output_device) {
@@ -322,10 +267,6 @@ error_t es8388_init(codec_config_t *cfg, i2c_bus_handle_t handle) {
     dac_power = ES8388_OUTPUT_LOUT1 | ES8388_OUTPUT_LOUT2 |
                 ES8388_OUTPUT_ROUT1 | ES8388_OUTPUT_ROUT2;
   }
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACPOWER,
-                      dac_power);  // 0x3c Enable DAC and Enable Lout/Rout/1/2
-  /* adc */
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCPOWER, 0xFF);
 
   // // AudioDriver: WORKAROUND_MIC_LINEIN_MIXED
   es_mic_gain_t mic_gain = (es_mic_gain_t)ES8388_DEFAULT_INPUT_GAIN;
@@ -337,10 +278,9 @@ error_t es8388_init(codec_config_t *cfg, i2c_bus_handle_t handle) {
   //         cfg->input_device= ADC_INPUT_LINE2;
   //     }
   // }
-  // res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL1, 0xbb); // MIC Left and
-  // Right channel PGA gain res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL1,
-  // ES8388_DEFAULT_INPUT_GAIN); // MIC Left and Right channel PGA gain
-  res |= es8388_set_mic_gain(mic_gain);
+  // MIC Left and Right channel PGA gain (see es8388_set_mic_gain)
+  int gain_n = (int)mic_gain / 3;
+  gain_n = (gain_n << 4) + gain_n;
   int tmp = 0;
   if (ADC_INPUT_LINE1 == cfg->input_device) {
     tmp = ESP8388_INPUT_LINPUT1_RINPUT1;
@@ -349,20 +289,53 @@ error_t es8388_init(codec_config_t *cfg, i2c_bus_handle_t handle) {
   } else {
     tmp = ESP8388_INPUT_DIFFERENCE;
   }
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL2,
-                      tmp);  // 0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input;
-                             // DSSEL,use one DS Reg11; DSR, LINPUT1-RINPUT1
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL3, 0x02);
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL4,
-                      0x0d);  // Left/Right data, Left/Right justified mode,
-                              // Bits length, I2S format
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL5,
-                      0x02);  // ADCFsMode,singel SPEED,RATIO=256
-  // ALC for Microphone
-  res |= es8388_set_adc_dac_volume(CODEC_MODE_ENCODE, 0, 0);  // 0db
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCPOWER,
-                      0x09);  // Power on ADC, Enable LIN&RIN, Power off
-                              // MICBIAS, set int1lp to low power mode
+
+  const i2c_seq_t init_seq[] = {
+      // 0x04 mute/0x00 unmute&ramp;DAC unmute and disabled digital volume
+      // control soft ramp
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL3, 0x04, 0},
+      /* Chip Control and Power Management */
+      {I2C_SEQ_WRITE, ES8388_CONTROL2, 0x50, 0},
+      {I2C_SEQ_WRITE, ES8388_CHIPPOWER, 0x00, 0},  // normal all and power up all
+      // Disable the internal DLL to improve 8K sample rate
+      {I2C_SEQ_WRITE, 0x35, 0xA0, 0},
+      {I2C_SEQ_WRITE, 0x37, 0xD0, 0},
+      {I2C_SEQ_WRITE, 0x39, 0xD0, 0},
+      {I2C_SEQ_WRITE, ES8388_MASTERMODE, (uint8_t)cfg->i2s.mode, 0},  // CODEC IN I2S SLAVE MODE
+      /* dac */
+      {I2C_SEQ_WRITE, ES8388_DACPOWER, 0xC0, 0},  // disable DAC and disable Lout/Rout/1/2
+      {I2C_SEQ_WRITE, ES8388_CONTROL1, 0x12, 0},  // Enfr=0,Play&Record Mode,(0x17-both of mic&paly)
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL1, 0x18, 0},   // 1a 0x18:16bit iis , 0x00:24
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL2, 0x02, 0},   // DACFsMode,SINGLE SPEED; DACFsRatio,256
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL16, 0x00, 0},  // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL17, 0x90, 0},  // only left DAC to left mixer enable 0db
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL20, 0x90, 0},  // only right DAC to right mixer enable 0db
+      // set internal ADC and DAC use the same LRCK clock, ADC LRCK as
+      // internal LRCK
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL21, 0x80, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL23, 0x00, 0},  // vroi=0
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL5, 0x00, 0},   // DAC volume 0db
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL4, 0x00, 0},
+      // 0x3c Enable DAC and Enable Lout/Rout/1/2
+      {I2C_SEQ_WRITE, ES8388_DACPOWER, (uint8_t)dac_power, 0},
+      /* adc */
+      {I2C_SEQ_WRITE, ES8388_ADCPOWER, 0xFF, 0},
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL1, (uint8_t)gain_n, 0},  // MIC PGA
+      // 0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input; DSSEL,use one DS Reg11;
+      // DSR, LINPUT1-RINPUT1
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL2, (uint8_t)tmp, 0},
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL3, 0x02, 0},
+      // Left/Right data, Left/Right justified mode, Bits length, I2S format
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL4, 0x0d, 0},
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL5, 0x02, 0},  // ADCFsMode,singel SPEED,RATIO=256
+      // ALC for Microphone
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL8, 0x00, 0},  // ADC volume 0db
+      {I2C_SEQ_WRITE, ES8388_ADCCONTROL9, 0x00, 0},
+      // Power on ADC, Enable LIN&RIN, Power off MICBIAS, set int1lp to low
+      // power mode
+      {I2C_SEQ_WRITE, ES8388_ADCPOWER, 0x09, 0},
+  };
+  res |= es_run_seq(init_seq, sizeof(init_seq) / sizeof(init_seq[0]));
   // es8388_pa_power(cfg->_DAC_OUTPUT!=ES8388_OUTPUT_LINE2);
   //  AD_LOGI("init,out:%02x, in:%02x", cfg->_DAC_OUTPUT, cfg->input_device);
   return res;
@@ -381,16 +354,11 @@ error_t es8388_init(codec_config_t *cfg, i2c_bus_handle_t handle) {
 error_t es8388_config_fmt(codec_mode_t mode, i2s_format_t fmt) {
   AD_LOGD(LOG_METHOD);
   error_t res = RESULT_OK;
-  uint8_t reg = 0;
   if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH) {
-    res = es_read_reg(ES8388_ADCCONTROL4, &reg);
-    reg = reg & 0xfc;
-    res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL4, reg | fmt);
+    res |= es_update_reg(ES8388_ADCCONTROL4, 0x03, fmt);
   }
   if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
-    res = es_read_reg(ES8388_DACCONTROL1, &reg);
-    reg = reg & 0xf9;
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL1, reg | (fmt << 1));
+    res |= es_update_reg(ES8388_DACCONTROL1, 0x06, fmt << 1);
   }
   return res;
 }
@@ -413,15 +381,18 @@ error_t es8388_set_voice_volume(int volume) {
   else if (volume > 100)
     volume = 100;
   volume /= 3;
-  // DAC LDACVOL RDACVOL default 0 = 0DB; Default value 192 = – -96 dB
-  res = es_write_reg(ES8388_ADDR, ES8388_DACCONTROL4, 0);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL5, 0);
-  // LOUT1 RLOUT1 volume: dataheet says only 6 bits
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL24, volume);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL25, volume);
-  // LOUT2 ROUT2 volume: datasheet says only 6 bits
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL26, volume);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL27, volume);
+  const i2c_seq_t seq[] = {
+      // DAC LDACVOL RDACVOL default 0 = 0DB; Default value 192 = – -96 dB
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL4, 0, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL5, 0, 0},
+      // LOUT1 RLOUT1 volume: dataheet says only 6 bits
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL24, (uint8_t)volume, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL25, (uint8_t)volume, 0},
+      // LOUT2 ROUT2 volume: datasheet says only 6 bits
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL26, (uint8_t)volume, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL27, (uint8_t)volume, 0},
+  };
+  res = es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
   return res;
 }
 
@@ -435,15 +406,18 @@ error_t es8388_set_voice_volume(int volume) {
   else if (volume > 100)
     volume = 100;
   volume = (volume * 63) / 100;
-  // LOUT1 RLOUT1 volume: dataheet says only 6 bits
-  res = es_write_reg(ES8388_ADDR, ES8388_DACCONTROL24, volume);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL25, volume);
-  // DAC LDACVOL RDACVOL default 0 = 0DB; Default value 192 = – -96 dB
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL26, 0);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL27, 0);
-  // 30-bit a coefficient for shelving filter
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL8, 192 >> 2);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL9, 192 >> 2);
+  const i2c_seq_t seq[] = {
+      // LOUT1 RLOUT1 volume: dataheet says only 6 bits
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL24, (uint8_t)volume, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL25, (uint8_t)volume, 0},
+      // DAC LDACVOL RDACVOL default 0 = 0DB; Default value 192 = – -96 dB
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL26, 0, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL27, 0, 0},
+      // 30-bit a coefficient for shelving filter
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL8, 192 >> 2, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL9, 192 >> 2, 0},
+  };
+  res = es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
   return res;
 }
 
@@ -457,12 +431,15 @@ error_t es8388_set_voice_volume(int volume) {
   else if (volume > 100)
     volume = 100;
   volume /= 3;
-  // ROUT1VOL LOUT1VOL 0 -> -45dB; 33 -> – 4.5dB
-  res = es_write_reg(ES8388_ADDR, ES8388_DACCONTROL24, volume);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL25, volume);
-  // DAC LDACVOL RDACVOL default 0 = 0DB; Default value 192 = – -96 dB
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL26, 0);
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL27, 0);
+  const i2c_seq_t seq[] = {
+      // ROUT1VOL LOUT1VOL 0 -> -45dB; 33 -> – 4.5dB
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL24, (uint8_t)volume, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL25, (uint8_t)volume, 0},
+      // DAC LDACVOL RDACVOL default 0 = 0DB; Default value 192 = – -96 dB
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL26, 0, 0},
+      {I2C_SEQ_WRITE, ES8388_DACCONTROL27, 0, 0},
+  };
+  res = es_run_seq(seq, sizeof(seq) / sizeof(seq[0]));
   return res;
 }
 #endif
@@ -501,18 +478,13 @@ error_t es8388_set_bits_per_sample(codec_mode_t mode,
                                    sample_bits_t bits_length) {
   AD_LOGD(LOG_METHOD);
   error_t res = RESULT_OK;
-  uint8_t reg = 0;
   int bits = (int)bits_length;
 
   if (mode == CODEC_MODE_ENCODE || mode == CODEC_MODE_BOTH) {
-    res = es_read_reg(ES8388_ADCCONTROL4, &reg);
-    reg = reg & 0xe3;
-    res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL4, reg | (bits << 2));
+    res |= es_update_reg(ES8388_ADCCONTROL4, 0x1c, bits << 2);
   }
   if (mode == CODEC_MODE_DECODE || mode == CODEC_MODE_BOTH) {
-    res = es_read_reg(ES8388_DACCONTROL1, &reg);
-    reg = reg & 0xc7;
-    res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL1, reg | (bits << 3));
+    res |= es_update_reg(ES8388_DACCONTROL1, 0x38, bits << 3);
   }
   return res;
 }
@@ -529,13 +501,8 @@ error_t es8388_set_bits_per_sample(codec_mode_t mode,
  */
 error_t es8388_set_voice_mute(bool enable) {
   AD_LOGD(LOG_METHOD);
-  error_t res = RESULT_OK;
-  uint8_t reg = 0;
-  res = es_read_reg(ES8388_DACCONTROL3, &reg);
-  reg = reg & 0xC3; // keep 11000011
-  int value = enable ? 0x3C : 0; // enable is 00111100 / disable is 00000000
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACCONTROL3, value | reg);
-  return res;
+  // keep 11000011: enable is 00111100 / disable is 00000000
+  return es_update_reg(ES8388_DACCONTROL3, 0x3C, enable ? 0x3C : 0);
 }
 
 error_t es8388_get_voice_mute(void) {
@@ -560,32 +527,28 @@ error_t es8388_config_output_device(output_device_t output_device) {
   AD_LOGD(LOG_METHOD);
   AD_LOGI("output_device: %d", output_device);
 
-  uint8_t reg = 0;
-  error_t res = es_read_reg(ES8388_DACPOWER, &reg);
-  reg = reg & 0xC3; // keep 11000011
-
   uint8_t value = 0;
   switch (output_device) {
     case DAC_OUTPUT_LINE1:
       value = ES8388_OUTPUT_LOUT1 | ES8388_OUTPUT_ROUT1;
-      AD_LOGI("DAC_OUTPUT_LINE2:  0x%x", reg | value);
+      AD_LOGI("DAC_OUTPUT_LINE1: 0x%x", value);
       break;
     case DAC_OUTPUT_LINE2:
       value = ES8388_OUTPUT_LOUT2 | ES8388_OUTPUT_ROUT2;
-      AD_LOGI("DAC_OUTPUT_LINE1: 0x%x",reg | value);
+      AD_LOGI("DAC_OUTPUT_LINE2: 0x%x", value);
       break;
     case DAC_OUTPUT_ALL:
       value = ES8388_OUTPUT_LOUT1 | ES8388_OUTPUT_LOUT2 |
                   ES8388_OUTPUT_ROUT1 | ES8388_OUTPUT_ROUT2;
-      AD_LOGI("DAC_OUTPUT_ALL: 0x%x",reg | value);
+      AD_LOGI("DAC_OUTPUT_ALL: 0x%x", value);
       break;
     case DAC_OUTPUT_NONE:
       value = 0;
-      AD_LOGI("DAC_OUTPUT_NONE: 0x%x",reg | value);
+      AD_LOGI("DAC_OUTPUT_NONE: 0x%x", value);
       break;
   }
-  res |= es_write_reg(ES8388_ADDR, ES8388_DACPOWER, reg | value);
-  return res;
+  // keep 11000011
+  return es_update_reg(ES8388_DACPOWER, 0x3C, value);
 }
 
 /**
@@ -597,12 +560,8 @@ error_t es8388_config_output_device(output_device_t output_device) {
  */
 error_t es8388_config_input_device(es8388_input_device_t input) {
   AD_LOGD(LOG_METHOD);
-  error_t res;
-  uint8_t reg = 0;
-  res = es_read_reg(ES8388_ADCCONTROL2, &reg);
-  reg = reg & 0x0f;
-  res |= es_write_reg(ES8388_ADDR, ES8388_ADCCONTROL2, reg | input);
-  return res;
+  // the MIC inputs also set bits of the lower nibble
+  return es_update_reg(ES8388_ADCCONTROL2, 0xf0 | input, input);
 }
 
 /**
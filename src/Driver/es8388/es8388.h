@@ -96,6 +96,8 @@ extern "C" {
 #define ES8388_DACCONTROL28     0x32
 #define ES8388_DACCONTROL29     0x33
 #define ES8388_DACCONTROL30     0x34
+/* undocumented DLL registers which are written by es8388_init() */
+#define ES8388_DLL_LAST         0x39
 
 typedef enum {
   ESP8388_INPUT_MIN = -1,
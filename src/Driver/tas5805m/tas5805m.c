@@ -22,13 +22,15 @@
  *
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include "tas5805m.h"
 #include "tas5805m_reg_cfg.h"
+#if TAS5805M_OPTIMIZED_REGISTERS
+#include "tas5805m_reg_cfg_opt.h"
+#endif
 #include "Utils/etc.h"
-// 0x5c>>1 = 0x2E
 
-#define TAS5805M_ADDR        0x2E    
 //#define TAS5805M_RST_GPIO      get_pa_enable_gpio()
 #define TAS5805M_VOLUME_MAX    100
 #define TAS5805M_VOLUME_MIN    0
@@ -42,6 +44,8 @@
 error_t tas5805m_ctrl(codec_mode_t mode, bool ctrl_state_active);
 error_t tas5805m_conig_iface(codec_mode_t mode, I2SDefinition *iface);
 static i2c_bus_handle_t     i2c_handler;
+/* image of the book 0 / page 0 registers, so that bit updates need no read */
+static i2c_reg_map_t        *tas5805m_regs;
 static int power_pin = -1;
 
 void tas5805m_set_power_pin(int pin) {
@@ -83,7 +87,7 @@ static error_t tas5805m_transmit_registers(const tas5805m_cfg_reg_t *conf_buf, i
                 // Used in legacy applications.  Ignored here.
                 break;
             case CFG_META_DELAY:
-                delay(conf_buf[i].value);
+                i2c_bus_delay(i2c_handler, conf_buf[i].value);
                 break;
             case CFG_META_BURST:
                 ret = i2c_bus_write_bytes(i2c_handler, TAS5805M_ADDR, (unsigned char *)(&conf_buf[i + 1].offset), 1, (unsigned char *)(&conf_buf[i + 1].value), conf_buf[i].value);
@@ -108,18 +112,31 @@ static error_t tas5805m_transmit_registers(const tas5805m_cfg_reg_t *conf_buf, i
     return ret;
 }
 
+void tas5805m_set_power(bool on)
+{
+    AD_LOGI( "Power %s CODEC with GPIO %d", on ? "ON" : "OFF", power_pin);
+    pinMode(power_pin, OUTPUT);
+    digitalWrite(power_pin, on ? 1 : 0);
+}
+
 error_t tas5805m_init(codec_config_t *codec_cfg,  void* i2c)
+{
+    tas5805m_set_power(false);
+    delay(TAS5805M_POWER_TIME_MS);
+    tas5805m_set_power(true);
+    delay(TAS5805M_POWER_TIME_MS);
+    return tas5805m_load_registers(i2c);
+}
+
+error_t tas5805m_load_registers(void* i2c)
 {
     i2c_handler = i2c;
     error_t ret = RESULT_OK;
-    AD_LOGI( "Power ON CODEC with GPIO %d", power_pin);
-    pinMode(power_pin, OUTPUT);
-    digitalWrite(power_pin, 0);
-    delay(20);
-    digitalWrite(power_pin, 1);
-    delay(20);
-
     ret |= tas5805m_transmit_registers(tas5805m_registers, sizeof(tas5805m_registers) / sizeof(tas5805m_registers[0]));
+    /* the configuration switches books and pages: forget all values */
+    i2c_reg_map_release(tas5805m_regs);
+    tas5805m_regs = i2c_reg_map_get(i2c_handler, TAS5805M_ADDR);
+    i2c_reg_map_invalidate(tas5805m_regs);
 
     TAS5805M_ASSERT(ret, "Fail to iniitialize tas5805m PA", RESULT_FAIL);
     return ret;
@@ -142,7 +159,7 @@ error_t tas5805m_set_volume(int vol)
 
     cmd[0] = MASTER_VOL_REG_ADDR;
     cmd[1] = tas5805m_volume[vol_idx];
-    ret = i2c_bus_write_bytes(i2c_handler, TAS5805M_ADDR, &cmd[0], 1, &cmd[1], 1);
+    ret = i2c_bus_write_reg_cached(i2c_handler, TAS5805M_ADDR, tas5805m_regs, cmd[0], cmd[1]);
     AD_LOGW("volume = 0x%x", cmd[1]);
     return ret;
 }
@@ -165,29 +182,18 @@ error_t tas5805m_get_volume(int *value)
 
 error_t tas5805m_set_mute(bool enable)
 {
-    error_t ret = RESULT_OK;
-    uint8_t cmd[2] = {TAS5805M_REG_03, 0x00};
-    ret |= i2c_bus_read_bytes(i2c_handler, TAS5805M_ADDR, &cmd[0], 1, &cmd[1], 1);
-
-    if (enable) {
-        cmd[1] |= 0x8;
-    } else {
-        cmd[1] &= (~0x08);
-    }
-    ret |= i2c_bus_write_bytes(i2c_handler, TAS5805M_ADDR, &cmd[0], 1, &cmd[1], 1);
-
+    error_t ret = i2c_bus_update_reg_cached(i2c_handler, TAS5805M_ADDR, tas5805m_regs, TAS5805M_REG_03, 0x08, enable ? 0x08 : 0x00);
     TAS5805M_ASSERT(ret, "Fail to set mute", RESULT_FAIL);
     return ret;
 }
 
 error_t tas5805m_get_mute(int *value)
 {
-    error_t ret = RESULT_OK;
-    uint8_t cmd[2] = {TAS5805M_REG_03, 0x00};
-    ret |= i2c_bus_read_bytes(i2c_handler, TAS5805M_ADDR, &cmd[0], 1, &cmd[1], 1);
+    uint8_t regv = 0;
+    error_t ret = i2c_bus_read_reg_cached(i2c_handler, TAS5805M_ADDR, tas5805m_regs, TAS5805M_REG_03, &regv);
 
     TAS5805M_ASSERT(ret, "Fail to get mute", RESULT_FAIL);
-    *value = (cmd[1] & 0x08) >> 4;
+    *value = (regv & 0x08) >> 3;
     AD_LOGI( "Get mute value: 0x%x", *value);
     return ret;
 }
@@ -225,7 +231,7 @@ error_t tas5805m_set_mute_fade(int value)
     }
     cmd[1] |= (cmd[1] << 4);
 
-    ret |= i2c_bus_write_bytes(i2c_handler, TAS5805M_ADDR, &cmd[0], 1, &cmd[1], 1);
+    ret |= i2c_bus_write_reg_cached(i2c_handler, TAS5805M_ADDR, tas5805m_regs, cmd[0], cmd[1]);
     TAS5805M_ASSERT(ret, "Fail to set mute fade", RESULT_FAIL);
     AD_LOGI( "Set mute fade, value:%d, 0x%x", value, cmd[1]);
     return ret;
@@ -236,12 +242,14 @@ error_t tas5805m_set_damp_mode(int value)
     unsigned char cmd[2] = {0};
     cmd[0] = TAS5805M_REG_02;
     cmd[1] = 0x10 | value;
-    return i2c_bus_write_bytes(i2c_handler, TAS5805M_ADDR, &cmd[0], 1, &cmd[1], 1);
+    return i2c_bus_write_reg_cached(i2c_handler, TAS5805M_ADDR, tas5805m_regs, cmd[0], cmd[1]);
 }
 
 error_t tas5805m_deinit(void)
 {
     // TODO
+    i2c_reg_map_release(tas5805m_regs);
+    tas5805m_regs = NULL;
     return RESULT_OK;
 }
 
@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+// 0x5c>>1 = 0x2E
+#define TAS5805M_ADDR        0x2E
 #define TAS5805M_REG_00      0x00
 #define TAS5805M_REG_02      0x02
 #define TAS5805M_REG_03      0x03
@@ -74,6 +76,25 @@ void tas5805m_set_power_pin(int pin);
  */
 error_t tas5805m_init(codec_config_t *codec_cfg, void* i2c);
 
+/* time in ms for each of the power pin states in tas5805m_init() */
+#define TAS5805M_POWER_TIME_MS 20
+
+/**
+ * @brief Sets the power pin: tas5805m_init() in steps is
+ * tas5805m_set_power(false), tas5805m_set_power(true) and
+ * tas5805m_load_registers(), with TAS5805M_POWER_TIME_MS in between
+ */
+void tas5805m_set_power(bool on);
+
+/**
+ * @brief Writes the register table
+ *
+ * @return
+ *     - RESULT_OK
+ *     - RESULT_FAIL
+ */
+error_t tas5805m_load_registers(void* i2c);
+
 /**
  * @brief Deinitialize TAS5805 codec chip
  *
@@ -46,6 +46,9 @@ static const uint8_t tas5805m_volume[] = {
     0x3d, 0x3b, 0x39, 0x37, 0x35
 };
 
+// Vendor register script: by default the driver uses the optimized version
+// from tas5805m_reg_cfg_opt.h which is generated by tools/reg_optimizer
+#if !TAS5805M_OPTIMIZED_REGISTERS
 static const tas5805m_cfg_reg_t tas5805m_registers[] = {
     //RESET
     { 0x00, 0x00 },
@@ -1739,6 +1742,7 @@ static const tas5805m_cfg_reg_t tas5805m_registers[] = {
     { 0x78, 0x80 },
 
 };
+#endif
 
 #ifdef __cplusplus
 }
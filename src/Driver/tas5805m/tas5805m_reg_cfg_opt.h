@@ -0,0 +1,395 @@
+// Generated from tas5805m_reg_cfg.h by tools/reg_optimizer: do not edit!
+// Regenerate with: cmake --build <build-dir> --target tas5805m_reg_cfg
+#pragma once
+
+#if CONFIG_ESP32_KORVO_DU1906_BOARD
+static const tas5805m_cfg_reg_t tas5805m_registers[] = {
+    { 0x00, 0x00 },
+    { 0x7f, 0x00 },
+    { 0x03, 0x02 },
+    { 0x01, 0x11 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x00 },
+    { 0x03, 0x02 },
+    { CFG_META_DELAY, 5 },
+    { 0x03, 0x00 },
+    { 0x46, 0x11 },
+    { 0x03, 0x02 },
+    { 0x78, 0x80 },
+    { 0x61, 0x0b },
+    { 0x60, 0x01 },
+    { 0x7d, 0x11 },
+    { 0x7e, 0xff },
+    { 0x00, 0x01 },
+    { 0x51, 0x05 },
+    { 0x00, 0x00 },
+    { 0x02, 0x10 },
+    { 0x53, 0x00 },
+    { 0x54, 0x13 },
+    { 0x66, 0x86 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x29 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x40, 0x26 }, { 0xe7, 0x00 }, { 0x40, 0x26 }, { 0xe7, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 8 }, { 0x24, 0x00 }, { 0x65, 0xac }, { 0x8c, 0x00 }, { 0x65, 0xac }, { 0x8c, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x30, 0x00 }, { 0xe2, 0xc4 }, { 0x6b, 0x00 },
+    { 0x00, 0x2c },
+    { CFG_META_BURST, 16 }, { 0x0c, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x1c, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x28, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x34, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x48, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x5c, 0x00 }, { 0x00, 0xae }, { 0xc3, 0x00 }, { 0x45, 0xa1 }, { 0xcb, 0x04 }, { 0x0c, 0x37 }, { 0x14, 0xc0 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x6c, 0x04 }, { 0xc1, 0xff }, { 0x93, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x74, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2d },
+    { CFG_META_BURST, 16 }, { 0x18, 0x7b }, { 0x3e, 0x00 }, { 0x6d, 0x00 }, { 0x00, 0xae }, { 0xc3, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 4 }, { 0x24, 0x20 }, { 0x29, 0x00 }, { 0x94, 0x00 },
+    { 0x00, 0x31 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x40 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x32 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x33 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x34 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x35 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0xaa },
+    { 0x00, 0x24 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x07 }, { 0xf0, 0xe4 }, { 0x16, 0xf0 }, { 0x1e, 0x37 }, { 0xd3, 0x07 }, { 0xf0, 0xe4 }, { 0x16, 0x0f }, { 0xe1, 0xab }, { 0xa4, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0xf8 }, { 0x1e, 0x1b }, { 0x4a, 0x07 }, { 0xf2, 0xc6 }, { 0x03, 0xf0 }, { 0x1a, 0x73 }, { 0xfa, 0x07 }, { 0xf2, 0xc6 }, { 0x03, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x0f }, { 0xe5, 0x76 }, { 0x28, 0xf8 }, { 0x1a, 0x5e }, { 0x1c, 0x08 }, { 0x28, 0x01 }, { 0xe1, 0xf0 }, { 0x35, 0x45 }, { 0x27, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x07 }, { 0xa3, 0x11 }, { 0xa4, 0x0f }, { 0xca, 0xba }, { 0xd9, 0xf8 }, { 0x34, 0xec }, { 0x7b, 0x07 }, { 0xfd, 0x56 }, { 0xbd, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0xf0 }, { 0x0d, 0x69 }, { 0xed, 0x07 }, { 0xf7, 0xfd }, { 0xbb, 0x0f }, { 0xf2, 0x96 }, { 0x13, 0xf8 }, { 0x0a, 0xab }, { 0x87, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x07 }, { 0xe1, 0xc2 }, { 0x69, 0xf0 }, { 0xac, 0x0d }, { 0x58, 0x07 }, { 0x94, 0x0c }, { 0x4d, 0x0f }, { 0x53, 0xf2 }, { 0xa8, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0xf8 }, { 0x8a, 0x31 }, { 0x49, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x25 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0xf1 }, { 0x79, 0xcb }, { 0xec, 0x06 }, { 0xa6, 0x49 }, { 0xa5, 0x0e }, { 0x86, 0x34 }, { 0x14, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0xf9 }, { 0x59, 0xb6 }, { 0x5b, 0x09 }, { 0x63, 0x61 }, { 0x75, 0xf8 }, { 0x28, 0x33 }, { 0x32, 0x02 }, { 0xcb, 0xa2 }, { 0x07, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x05 }, { 0xc8, 0x94 }, { 0x61, 0xfd }, { 0xe0, 0x34 }, { 0xf0, 0x08 }, { 0x00, 0x00 }, { 0x00, 0xf1 }, { 0x79, 0xcb }, { 0xec, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x06 }, { 0xa6, 0x49 }, { 0xa5, 0x0e }, { 0x86, 0x34 }, { 0x14, 0xf9 }, { 0x59, 0xb6 }, { 0x5b, 0x07 }, { 0xd8, 0xc2 }, { 0x5c, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0xf1 }, { 0x09, 0x84 }, { 0x20, 0x07 }, { 0xa4, 0xd9 }, { 0x7a, 0x0e }, { 0xf6, 0x7b }, { 0xe0, 0xf8 }, { 0x82, 0x64 }, { 0x2a, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x07 }, { 0xc6, 0x16 }, { 0x0b, 0xf3 }, { 0x04, 0x30 }, { 0xd8, 0x07 }, { 0x00, 0x0d }, { 0xc1, 0x0c }, { 0xfb, 0xcf }, { 0x28, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0xf9 }, { 0x39, 0xdc }, { 0x34, 0x07 }, { 0xfc, 0x8e }, { 0xc5, 0x00 },
+    { 0x00, 0x26 },
+    { CFG_META_BURST, 16 }, { 0x08, 0xf0 }, { 0x91, 0xb8 }, { 0xc2, 0x07 }, { 0xe1, 0xf7 }, { 0xf1, 0x0f }, { 0x6e, 0x47 }, { 0x3e, 0xf8 }, { 0x21, 0x79 }, { 0x4a, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x27 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x28 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x29 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 4 }, { 0x7c, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2f },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x1c, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x2c, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x58, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x2b },
+    { CFG_META_BURST, 16 }, { 0x34, 0x00 }, { 0x22, 0x1d }, { 0x95, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x00 }, { 0x06, 0xd3 }, { 0x72, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x44, 0x00 }, { 0x00, 0x4e }, { 0xa5, 0xff }, { 0x81, 0x47 }, { 0xae, 0xf9 }, { 0x06, 0x21 }, { 0xa9, 0xfc }, { 0xc2, 0xd8 }, { 0xc5, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x54, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x02, 0x4b }, { 0xce, 0x00 },
+    { 0x00, 0x2d },
+    { CFG_META_BURST, 16 }, { 0x58, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x00 }, { 0x44, 0x32 }, { 0x13, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0xff }, { 0x81, 0x47 }, { 0xae, 0xf9 }, { 0x06, 0x21 }, { 0xa9, 0xfc }, { 0xad, 0x96 }, { 0x20, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0xaa },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 16 }, { 0x40, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x50, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { 0x00, 0x2b },
+    { CFG_META_BURST, 16 }, { 0x20, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xf9 }, { 0xaa, 0x50 }, { 0x28, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x30, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x0c, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xf9 }, { 0xaa, 0x50 }, { 0x28, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x1c, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 16 }, { 0x34, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x44, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x2d },
+    { CFG_META_BURST, 16 }, { 0x30, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x00 }, { 0x06, 0xd3 }, { 0x72, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x40, 0x00 }, { 0x00, 0x00 }, { 0x00, 0xff }, { 0x81, 0x47 }, { 0xae, 0xf9 }, { 0x06, 0x21 }, { 0xa9, 0xfc }, { 0xc2, 0xd8 }, { 0xc5, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x50, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0xaa },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 16 }, { 0x5c, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x84 }, { 0xa7, 0x06 }, { 0xb8, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x6c, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x84 }, { 0xa7, 0x06 }, { 0xb8, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x7c, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { 0x00, 0x2b },
+    { CFG_META_BURST, 4 }, { 0x08, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x00 },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 16 }, { 0x54, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x64, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 4 }, { 0x10, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x0c, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x08, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 12 }, { 0x18, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x40 }, { 0x00, 0x00 }, { 0x00, 0x40 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x00 },
+    { 0x30, 0x00 },
+    { 0x4c, 0x30 },
+    { 0x03, 0x03 },
+    { 0x78, 0x80 },
+};
+#else
+static const tas5805m_cfg_reg_t tas5805m_registers[] = {
+    { 0x00, 0x00 },
+    { 0x7f, 0x00 },
+    { 0x03, 0x02 },
+    { 0x01, 0x11 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x00 },
+    { 0x03, 0x02 },
+    { CFG_META_DELAY, 5 },
+    { 0x03, 0x00 },
+    { 0x46, 0x11 },
+    { 0x03, 0x02 },
+    { 0x78, 0x80 },
+    { 0x61, 0x0b },
+    { 0x60, 0x01 },
+    { 0x7d, 0x11 },
+    { 0x7e, 0xff },
+    { 0x00, 0x01 },
+    { 0x51, 0x05 },
+    { 0x00, 0x00 },
+    { 0x02, 0x14 },
+    { 0x53, 0x00 },
+    { 0x54, 0x13 },
+    { 0x66, 0x86 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x29 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x40, 0x26 }, { 0xe7, 0x00 }, { 0x40, 0x26 }, { 0xe7, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 8 }, { 0x24, 0x00 }, { 0x65, 0xac }, { 0x8c, 0x00 }, { 0x65, 0xac }, { 0x8c, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x30, 0x00 }, { 0xe2, 0xc4 }, { 0x6b, 0x00 },
+    { 0x00, 0x2c },
+    { CFG_META_BURST, 16 }, { 0x0c, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x1c, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x28, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x34, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x48, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x5c, 0x00 }, { 0x00, 0xae }, { 0xc3, 0x00 }, { 0x45, 0xa1 }, { 0xcb, 0x04 }, { 0x0c, 0x37 }, { 0x14, 0xc0 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x6c, 0x04 }, { 0xc1, 0xff }, { 0x93, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x74, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2d },
+    { CFG_META_BURST, 16 }, { 0x18, 0x7b }, { 0x3e, 0x00 }, { 0x6d, 0x00 }, { 0x00, 0xae }, { 0xc3, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 4 }, { 0x24, 0x20 }, { 0x29, 0x00 }, { 0x94, 0x00 },
+    { 0x00, 0x31 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x40 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x32 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x33 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x34 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x35 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0xaa },
+    { 0x00, 0x24 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x07 }, { 0xf0, 0xe4 }, { 0x16, 0xf0 }, { 0x1e, 0x37 }, { 0xd3, 0x07 }, { 0xf0, 0xe4 }, { 0x16, 0x0f }, { 0xe1, 0xab }, { 0xa4, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0xf8 }, { 0x1e, 0x1b }, { 0x4a, 0x07 }, { 0xf2, 0xc6 }, { 0x03, 0xf0 }, { 0x1a, 0x73 }, { 0xfa, 0x07 }, { 0xf2, 0xc6 }, { 0x03, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x0f }, { 0xe5, 0x76 }, { 0x28, 0xf8 }, { 0x1a, 0x5e }, { 0x1c, 0x08 }, { 0x28, 0x01 }, { 0xe1, 0xf0 }, { 0x35, 0x45 }, { 0x27, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x07 }, { 0xa3, 0x11 }, { 0xa4, 0x0f }, { 0xca, 0xba }, { 0xd9, 0xf8 }, { 0x34, 0xec }, { 0x7b, 0x07 }, { 0xfd, 0x56 }, { 0xbd, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0xf0 }, { 0x0d, 0x69 }, { 0xed, 0x07 }, { 0xf7, 0xfd }, { 0xbb, 0x0f }, { 0xf2, 0x96 }, { 0x13, 0xf8 }, { 0x0a, 0xab }, { 0x87, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x07 }, { 0xe1, 0xc2 }, { 0x69, 0xf0 }, { 0xac, 0x0d }, { 0x58, 0x07 }, { 0x94, 0x0c }, { 0x4d, 0x0f }, { 0x53, 0xf2 }, { 0xa8, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0xf8 }, { 0x8a, 0x31 }, { 0x49, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x25 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0xf1 }, { 0x79, 0xcb }, { 0xec, 0x06 }, { 0xa6, 0x49 }, { 0xa5, 0x0e }, { 0x86, 0x34 }, { 0x14, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0xf9 }, { 0x59, 0xb6 }, { 0x5b, 0x09 }, { 0x63, 0x61 }, { 0x75, 0xf8 }, { 0x28, 0x33 }, { 0x32, 0x02 }, { 0xcb, 0xa2 }, { 0x07, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x05 }, { 0xc8, 0x94 }, { 0x61, 0xfd }, { 0xe0, 0x34 }, { 0xf0, 0x08 }, { 0x00, 0x00 }, { 0x00, 0xf1 }, { 0x79, 0xcb }, { 0xec, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x06 }, { 0xa6, 0x49 }, { 0xa5, 0x0e }, { 0x86, 0x34 }, { 0x14, 0xf9 }, { 0x59, 0xb6 }, { 0x5b, 0x07 }, { 0xd8, 0xc2 }, { 0x5c, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0xf1 }, { 0x09, 0x84 }, { 0x20, 0x07 }, { 0xa4, 0xd9 }, { 0x7a, 0x0e }, { 0xf6, 0x7b }, { 0xe0, 0xf8 }, { 0x82, 0x64 }, { 0x2a, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x07 }, { 0xc6, 0x16 }, { 0x0b, 0xf3 }, { 0x04, 0x30 }, { 0xd8, 0x07 }, { 0x00, 0x0d }, { 0xc1, 0x0c }, { 0xfb, 0xcf }, { 0x28, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0xf9 }, { 0x39, 0xdc }, { 0x34, 0x07 }, { 0xfc, 0x8e }, { 0xc5, 0x00 },
+    { 0x00, 0x26 },
+    { CFG_META_BURST, 16 }, { 0x08, 0xf0 }, { 0x91, 0xb8 }, { 0xc2, 0x07 }, { 0xe1, 0xf7 }, { 0xf1, 0x0f }, { 0x6e, 0x47 }, { 0x3e, 0xf8 }, { 0x21, 0x79 }, { 0x4a, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x27 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x28 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x18, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x28, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x38, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x58, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x29 },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 4 }, { 0x7c, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2f },
+    { CFG_META_BURST, 16 }, { 0x08, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x1c, 0x08 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x2c, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 16 }, { 0x48, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x58, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x2b },
+    { CFG_META_BURST, 16 }, { 0x34, 0x00 }, { 0x22, 0x1d }, { 0x95, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x00 }, { 0x06, 0xd3 }, { 0x72, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x44, 0x00 }, { 0x00, 0x4e }, { 0xa5, 0xff }, { 0x81, 0x47 }, { 0xae, 0xf9 }, { 0x06, 0x21 }, { 0xa9, 0xfc }, { 0xc2, 0xd8 }, { 0xc5, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x54, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x02, 0x4b }, { 0xce, 0x00 },
+    { 0x00, 0x2d },
+    { CFG_META_BURST, 16 }, { 0x58, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x00 }, { 0x44, 0x32 }, { 0x13, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x68, 0x00 }, { 0x00, 0x00 }, { 0x00, 0xff }, { 0x81, 0x47 }, { 0xae, 0xf9 }, { 0x06, 0x21 }, { 0xa9, 0xfc }, { 0xad, 0x96 }, { 0x20, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x78, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0xaa },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 16 }, { 0x40, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x50, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { 0x00, 0x2b },
+    { CFG_META_BURST, 16 }, { 0x20, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xf9 }, { 0xaa, 0x50 }, { 0x28, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x30, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x0c, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xf9 }, { 0xaa, 0x50 }, { 0x28, 0x06 }, { 0x55, 0xaf }, { 0xd8, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x1c, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 16 }, { 0x34, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x00 }, { 0x15, 0xa7 }, { 0x04, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x44, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x2d },
+    { CFG_META_BURST, 16 }, { 0x30, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x02 }, { 0xa3, 0x9a }, { 0xcc, 0x00 }, { 0x06, 0xd3 }, { 0x72, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x40, 0x00 }, { 0x00, 0x00 }, { 0x00, 0xff }, { 0x81, 0x47 }, { 0xae, 0xf9 }, { 0x06, 0x21 }, { 0xa9, 0xfc }, { 0xc2, 0xd8 }, { 0xc5, 0x00 },
+    { CFG_META_BURST, 8 }, { 0x50, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0xaa },
+    { 0x00, 0x2a },
+    { CFG_META_BURST, 16 }, { 0x5c, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x84 }, { 0xa7, 0x06 }, { 0xb8, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { CFG_META_BURST, 16 }, { 0x6c, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x84 }, { 0xa7, 0x06 }, { 0xb8, 0x7b }, { 0x58, 0xf9 }, { 0x48, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x7c, 0x7b }, { 0x43, 0x52 }, { 0x44, 0x00 },
+    { 0x00, 0x2b },
+    { CFG_META_BURST, 4 }, { 0x08, 0x89 }, { 0x22, 0xbf }, { 0x66, 0x00 },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 16 }, { 0x54, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0x58 }, { 0x3b, 0x2f }, { 0x3d, 0xae }, { 0x1a, 0x80 }, { 0x9b, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x64, 0xc2 }, { 0xde, 0x41 }, { 0xd5, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x8c },
+    { 0x00, 0x2e },
+    { CFG_META_BURST, 4 }, { 0x10, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x0c, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 4 }, { 0x08, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x00 },
+    { CFG_META_BURST, 12 }, { 0x18, 0x00 }, { 0x80, 0x00 }, { 0x00, 0x40 }, { 0x00, 0x00 }, { 0x00, 0x40 }, { 0x00, 0x00 }, { 0x00, 0x00 },
+    { 0x00, 0x00 },
+    { 0x7f, 0x00 },
+    { 0x30, 0x00 },
+    { 0x4c, 0x30 },
+    { 0x03, 0x03 },
+    { 0x78, 0x80 },
+};
+#endif
@@ -10,6 +10,8 @@
  * $ Copyright 2021-YEAR Cypress Semiconductor $
  *******************************************************************************/
 #include "mtb_wm8960.h"
+#include "Utils/I2C.h"
+#include "Utils/RegisterMap.h"
 
 #define WM8960_TIMEOUT_MS           (100u)
 #define REGISTER_MAP_SIZE           (56u)
@@ -33,13 +35,13 @@ typedef struct
 static void* i2c_ptr = nullptr;
 static uint8_t enabled_features;
 static bool pll_enabled = false;
-static uint32_t write_retry_count = 1;
+static uint32_t write_retry_count = 0;
 
 /* The WM8960 audio codec does not allow reading registers from the device so we
  * store a cached copy with default of the register map in the driver and is updated
  * on every write.
  */
-static uint16_t wm8960_register_map[REGISTER_MAP_SIZE];
+static audio_driver::RegisterMap<REGISTER_MAP_SIZE, 9> wm8960_register_map;
 
 //--------------------------------------------------------------------------------------------------
 // _mtb_wm8960_config_default
@@ -209,6 +211,99 @@ static bool _mtb_wm8960_config_default(uint8_t features)
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// _mtb_wm8960_pll
+//--------------------------------------------------------------------------------------------------
+/* Based on the PLL section on pg 63/64 the Sysclk divider after the PLL must be 2.
+ * See Figure 36.
+ *   f2 = 4 (Fixed divider in PLL) * 2 (SYSCLKDIV) * sysclk_hz
+ *   f1 = mclk_hz
+ *   R = f2 / f1
+ *   PLLN = int (R)
+ *   PLLK = int (2^24 (R - PLLN))
+ * As per description of R52 the PLLN value must be between 5 and 13. If the R value
+ * is less than 5 we use a prescale divider (PLLPRESCALE) that divides the mclk_hz
+ * frequency by 2 before its goes into the PLL. The datasheet also documents the peak
+ * stability is at PLLN = 8 (pg 64) so if the R value is close to 5 and if using the
+ * prescale divider gets us closer to 8 we enable the prescale divider:
+ * R*2 - 8 < 8 - R is the same as 3 * f2 < 16 * f1.
+ * All values are calculated with 64 bit integers, so that PLLK is exact.
+ */
+static constexpr bool _mtb_wm8960_pll_prescale(uint64_t f1, uint32_t sysclk_hz)
+{
+    return 3 * (8ull * sysclk_hz) < 16 * f1;
+}
+
+static constexpr uint64_t _mtb_wm8960_pll_f2(uint64_t f1, uint32_t sysclk_hz)
+{
+    return _mtb_wm8960_pll_prescale(f1, sysclk_hz) ? 16ull * sysclk_hz : 8ull * sysclk_hz;
+}
+
+static constexpr mtb_wm8960_pll_t _mtb_wm8960_pll(uint32_t mclk_hz, uint32_t sysclk_hz)
+{
+    return { mclk_hz, sysclk_hz,
+             (uint8_t)(_mtb_wm8960_pll_f2(mclk_hz, sysclk_hz) / mclk_hz),
+             (uint32_t)(((_mtb_wm8960_pll_f2(mclk_hz, sysclk_hz) % mclk_hz) << 24) / mclk_hz),
+             _mtb_wm8960_pll_prescale(mclk_hz, sysclk_hz) };
+}
+
+static constexpr bool _mtb_wm8960_pll_is_valid(uint64_t f1, uint32_t sysclk_hz)
+{
+    return f1 > 0 && _mtb_wm8960_pll_f2(f1, sysclk_hz) > 5 * f1
+        && _mtb_wm8960_pll_f2(f1, sysclk_hz) < 13 * f1;
+}
+
+/* Solutions for the common mclk frequencies */
+static constexpr mtb_wm8960_pll_t _mtb_wm8960_pll_table[] =
+{
+    _mtb_wm8960_pll(12000000, _WM8960_SYSCLK_FREQ_12288000_HZ),
+    _mtb_wm8960_pll(12000000, _WM8960_SYSCLK_FREQ_11289600_HZ),
+    _mtb_wm8960_pll(12288000, _WM8960_SYSCLK_FREQ_12288000_HZ),
+    _mtb_wm8960_pll(12288000, _WM8960_SYSCLK_FREQ_11289600_HZ),
+    _mtb_wm8960_pll(11289600, _WM8960_SYSCLK_FREQ_12288000_HZ),
+    _mtb_wm8960_pll(11289600, _WM8960_SYSCLK_FREQ_11289600_HZ),
+    _mtb_wm8960_pll(24000000, _WM8960_SYSCLK_FREQ_12288000_HZ),
+    _mtb_wm8960_pll(24000000, _WM8960_SYSCLK_FREQ_11289600_HZ),
+    _mtb_wm8960_pll(19200000, _WM8960_SYSCLK_FREQ_12288000_HZ),
+    _mtb_wm8960_pll(19200000, _WM8960_SYSCLK_FREQ_11289600_HZ),
+};
+
+static constexpr bool _mtb_wm8960_pll_table_is_valid(int idx)
+{
+    return idx < 0 || (_mtb_wm8960_pll_is_valid(_mtb_wm8960_pll_table[idx].mclk_hz,
+                                                _mtb_wm8960_pll_table[idx].sysclk_hz)
+                       && _mtb_wm8960_pll_table_is_valid(idx - 1));
+}
+
+static_assert(_mtb_wm8960_pll_table_is_valid(sizeof(_mtb_wm8960_pll_table) /
+                                              sizeof(_mtb_wm8960_pll_table[0]) - 1),
+              "invalid PLL table entry");
+
+//--------------------------------------------------------------------------------------------------
+// mtb_wm8960_calculate_pll
+//--------------------------------------------------------------------------------------------------
+bool mtb_wm8960_calculate_pll(uint32_t mclk_hz, uint32_t sysclk_hz, mtb_wm8960_pll_t *pll)
+{
+    for (const mtb_wm8960_pll_t &entry : _mtb_wm8960_pll_table)
+    {
+        if (entry.mclk_hz == mclk_hz && entry.sysclk_hz == sysclk_hz)
+        {
+            *pll = entry;
+            return true;
+        }
+    }
+
+    /* If the value of R is not within the permitted range then
+     * mclk_hz freq cannot be used to generate a valid sysclk.
+     */
+    if (!_mtb_wm8960_pll_is_valid(mclk_hz, sysclk_hz))
+    {
+        return false;
+    }
+    *pll = _mtb_wm8960_pll(mclk_hz, sysclk_hz);
+    return true;
+}
+
 //--------------------------------------------------------------------------------------------------
 // _mtb_wm8960_setup_pll
 //--------------------------------------------------------------------------------------------------
@@ -219,7 +314,7 @@ static bool _mtb_wm8960_setup_pll(uint32_t mclk_hz,
     bool result;
     uint8_t PLLN;
     uint32_t PLLK;
-    bool use_prescale = false;
+    bool use_prescale;
     uint32_t sys_clk_hz;
 
     /* Based on Table 40 on pg 61 in the WM8960 datasheet we infer
@@ -245,43 +340,14 @@ static bool _mtb_wm8960_setup_pll(uint32_t mclk_hz,
             break;
     }
 
-    /* Based on the PLL section on pg 63/64 the Sysclk divider
-     * after the PLL must be 2. See Figure 36.
-     *   f2 = 4 (Fixed divider in PLL) * 2 (SYSCLKDIV) * sysclk_hz
-     *   f1 = mclk_hz
-     *   R = f2 / f1
-     *   PLLN = int (R)
-     *   PLLK = int (2^24 (R - PLLN))
-     */
-    uint32_t f2 = (4 * 2 * sys_clk_hz);
-    uint32_t f1 = mclk_hz;
-    float R = (float)f2 / (float)f1;
-    /* As per description of R52 the PLLN value must be between
-     * 5 and 13. If the R value is less than 5 we use a prescale
-     * divder (PLLPRESCALE) that divides the mclk_hz frequency by
-     * 2 before its goes into the PLL.
-     *
-     * The datasheet also documents the peak stability is at
-     * PLLN = 8 (pg 64) so if the R value is close to 5 and if using
-     * the prescale divider gets us closer to 8 we enable the prescale
-     * divider.
-     */
-    if ((R <= 5) || ((R*2 - 8) < (8 - R)))
-    {
-        use_prescale = true;
-        R *= (float)2;
-    }
-
-    /* If the value of R is not within the permitted range then
-     * mclk_hz freq cannot be used to generate a valid sysclk.
-     */
-    if ((R <= 5) || (R >= 13))
+    mtb_wm8960_pll_t pll;
+    if (!mtb_wm8960_calculate_pll(mclk_hz, sys_clk_hz, &pll))
     {
         return false;
     }
-
-    PLLN = (uint8_t)R;
-    PLLK = (uint32_t)((float)0x1000000 * (R - (float)PLLN));
+    PLLN = pll.n;
+    PLLK = pll.k;
+    use_prescale = pll.prescale;
     uint16_t prescale_mask = (use_prescale)
                             ? WM8960_PLL_N_PLLPRESCALE_EN
                             : WM8960_PLL_N_PLLPRESCALE_DI;
@@ -615,10 +681,10 @@ bool mtb_wm8960_write_ex(mtb_wm8960_reg_t enum_reg, uint16_t value)
                 0x0000, 0x0037, 0x004d, 0x0080, 0x0008, 0x0031, 0x0026, 0x00e9, // R48~R55
             };
 
-            memcpy(&wm8960_register_map, &wm8960_default_register_map, REGISTER_MAP_SIZE);
+            wm8960_register_map.setDefaults(wm8960_default_register_map);
         } else {
             // Update register map 
-            wm8960_register_map[reg] = value;
+            wm8960_register_map.store(reg, value);
         }
     } 
     return result;
@@ -626,11 +692,7 @@ bool mtb_wm8960_write_ex(mtb_wm8960_reg_t enum_reg, uint16_t value)
 
 #ifdef ARDUINO
 bool i2c_write(uint8_t address, uint8_t data[2]) {
-    TwoWire* p_wire = (TwoWire*)i2c_ptr;
-    p_wire->beginTransmission(address);
-    p_wire->write(data, 2);
-    int result = p_wire->endTransmission(true);
-    return result == 0;
+    return i2c_bus_write_bytes(i2c_ptr, address, &data[0], 1, &data[1], 1) == RESULT_OK;
 }
 #endif
 
@@ -643,7 +705,7 @@ bool mtb_wm8960_write(mtb_wm8960_reg_t enum_reg, uint16_t value){
     uint32_t count=0;
     while(!result){
         result = mtb_wm8960_write_ex(enum_reg, value);
-        if (count>0 && count++ > write_retry_count){
+        if (!result && count++ >= write_retry_count){
             break;
         }
     }
@@ -661,7 +723,7 @@ bool mtb_wm8960_read(mtb_wm8960_reg_t reg, uint16_t* value)
         return false;
     }
 
-    *value = wm8960_register_map[reg];
+    *value = wm8960_register_map.get(reg);
 
     return true;
 }
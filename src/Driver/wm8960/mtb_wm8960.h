@@ -550,10 +550,23 @@ typedef enum
     WM8960_MODE_SLAVE  = WM8960_AUDIO_INTF0_MS_SLAVE    /**< Slave mode */
 } mtb_wm8960_mode_t;
 
+/**
+ * PLL settings which generate the sysclk from the mclk:
+ * 4 * 2 * sysclk = mclk (/ 2 with prescaler) * (n + k / 2^24)
+ */
+typedef struct
+{
+    uint32_t mclk_hz;    /**< PLL input frequency */
+    uint32_t sysclk_hz;  /**< 12.288 MHz or 11.2896 MHz */
+    uint8_t  n;          /**< PLLN: integer part of the ratio (6..12) */
+    uint32_t k;          /**< PLLK: 24 bit fraction of the ratio */
+    bool     prescale;   /**< the mclk is divided by 2 before the PLL */
+} mtb_wm8960_pll_t;
+
 
 /**
- * @brief Provide an alternative initialized Wire object. If this is not called we
- * automatically use the Wire object and initialize it with begin().
+ * @brief Provide the control bus (i2c_bus_handle_t) which is used to access
+ * the registers.
  * 
  * @ingroup wm8960
  * @param i2c_inst 
@@ -565,10 +578,11 @@ bool mtb_wm8960_set_wire(void* i2c_inst);
 
 /**
  * @brief Defines the number of times we retry to update a register value via I2C.
- * This might help if you have an instable I2C connection. By default we set it to 1
- * which will cause the initialization to fail when the register update fails.
+ * This might help if you have an instable I2C connection. Failed transactions are
+ * already retried by the control bus (see I2C_RETRY_COUNT), so by default we do
+ * not retry here.
  * @ingroup wm8960
- * @param count; 0: retry endlessly until success; any number > 0 = number of retries 
+ * @param count; 0: no retry; any number > 0 = number of retries 
  * 
 */
 void mtb_wm8960_set_write_retry_count(uint32_t count);
@@ -756,6 +770,21 @@ bool mtb_wm8960_configure_clocking(uint32_t mclk_hz, bool enable_pll,
                                         mtb_wm8960_word_length_t word_length,
                                         mtb_wm8960_mode_t mode);
 
+/**
+ * @brief This function determines the PLL settings which generate the sysclk from
+ * the mclk. The common mclk frequencies (12 MHz, 12.288 MHz, 11.2896 MHz, 24 MHz
+ * and 19.2 MHz) are taken from a precalculated table: other values are calculated
+ * with integer arithmetic, so the result is exact and needs no floating point.
+ *
+ * @param[in] mclk_hz       The master clock (MCLK) frequency
+ * @param[in] sysclk_hz     The sysclk frequency (12288000 or 11289600)
+ * @param[out] pll          The PLL settings
+ *
+ * @ingroup wm8960
+ * @return true if the mclk can be used to generate the sysclk
+ */
+bool mtb_wm8960_calculate_pll(uint32_t mclk_hz, uint32_t sysclk_hz, mtb_wm8960_pll_t *pll);
+
 
 /**
  * @brief This function dumps the actual register values
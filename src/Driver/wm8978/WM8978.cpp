@@ -1,13 +1,10 @@
 #include "WM8978.h"
 
-// WM8978 register value buffer zone (total 58 registers 0 to 57), occupies 116
-// bytes of memory Because the IIC WM8978 operation does not support read
-// operations, so save all the register values in the local Write WM8978
-// register, synchronized to the local register values, register read, register
-// directly back locally stored value. Note: WM8978 register value is 9, so use
-// uint16_t storage.
-
-static uint16_t REGVAL_TBL[58] = {
+// WM8978 register reset values (total 58 registers 0 to 57). Because the IIC
+// WM8978 operation does not support read operations, all register values are
+// kept in the local register map: a register read directly returns the locally
+// stored value. Note: WM8978 register value is 9 bits, so use uint16_t storage.
+static const uint16_t REGVAL_TBL[58] = {
     0X0000, 0X0000, 0X0000, 0X0000, 0X0050, 0X0000, 0X0140, 0X0000, 0X0000,
     0X0000, 0X0000, 0X00FF, 0X00FF, 0X0000, 0X0100, 0X00FF, 0X00FF, 0X0000,
     0X012C, 0X002C, 0X002C, 0X002C, 0X002C, 0X0000, 0X0032, 0X0000, 0X0000,
@@ -16,23 +13,52 @@ static uint16_t REGVAL_TBL[58] = {
     0X0010, 0X0010, 0X0100, 0X0100, 0X0002, 0X0001, 0X0001, 0X0039, 0X0039,
     0X0039, 0X0039, 0X0001, 0X0001};
 
-// WM8978 write register
+WM8978::WM8978() {
+  regs.setDefaults(REGVAL_TBL);
+  // R0 is the software reset
+  regs.setVolatile(0);
+}
+
+// WM8978 write register: unchanged values are not sent again
 // reg: register address
 // val: the value to be written to the register
 // Return value: 0, success;
 // Other, error code
 uint8_t WM8978::Write_Reg(uint8_t reg, uint16_t val) {
-  char buf[2];
-  buf[0] = (reg << 1) | ((val >> 8) & 0X01);
-  buf[1] = val & 0XFF;
-  p_wire->beginTransmission(
-      WM8978_ADDR);  // Send data to the slave with device number 4
-  p_wire->write((const uint8_t*)buf, 2);
-  p_wire->endTransmission();  // Stop sending
-  REGVAL_TBL[reg] = val;   // Save register value to local
+  if (reg >= regs.size()) return 1;
+  regs.set(reg, val);
+  if (!Flush_Regs()) return 1;
+  // after the software reset the registers have their default values
+  if (reg == 0) regs.reset();
   return 0;
 }
 
+// Writes all changed registers of the register map
+bool WM8978::Flush_Regs() {
+  return regs.flush([this](int reg, const uint16_t* values, int count) {
+    for (int j = 0; j < count; j++) {
+      uint16_t val = values[j];
+      uint8_t buf[2];
+      buf[0] = ((reg + j) << 1) | ((val >> 8) & 0X01);
+      buf[1] = val & 0XFF;
+      // the 9th value bit is part of the address byte
+      if (p_bus->write(WM8978_ADDR, &buf[0], 1, &buf[1], 1) != RESULT_OK)
+        return false;
+    }
+    return true;
+  });
+}
+
+// Writes all registers (except the reset R0) with the indicated values, e.g.
+// after a power down
+bool WM8978::restoreRegisters(const uint16_t* values, int count) {
+  if (count > regs.size()) count = regs.size();
+  for (int j = 1; j < count; j++) regs.store(j, values[j]);
+  regs.markAllDirty();
+  regs.store(0, regs.get(0));
+  return Flush_Regs();
+}
+
 // WM8978 init
 // Return value: 0, initialization is normal
 // Other, error code
@@ -66,7 +92,7 @@ uint8_t WM8978::Init(void) {
 // Reads the value  of the local register buffer zone
 // reg: Register Address
 // Return Value: Register value
-uint16_t WM8978::Read_Reg(uint8_t reg) { return REGVAL_TBL[reg]; }
+uint16_t WM8978::Read_Reg(uint8_t reg) { return regs.get(reg); }
 // WM8978 DAC/ADC configuration
 // adcen:adc enable(1)/disable(0)
 // dacen: dac enable(1)/disable(0)
@@ -313,9 +339,7 @@ void WM8978::setHPF(uint8_t enable) {
 }
 
 bool WM8978::begin() {
-  p_wire->beginTransmission(WM8978_ADDR);
-  const uint8_t error = p_wire->endTransmission();
-  if (error) {
+  if (p_bus->check(WM8978_ADDR) != RESULT_OK) {
     AD_LOGE("No WM8978 dac @ i2c address: 0x%X", WM8978_ADDR);
     return false;
   }
@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include "DriverCommon.h"
 #include "Utils/I2C.h"
+#include "Utils/ControlBus.h"
+#include "Utils/RegisterMap.h"
 #include "Wire.h"
 
 #define WM8978_ADDR 0X1A  // WM8978��������ַ,�̶�Ϊ0X1A
@@ -35,7 +37,7 @@
 
 class WM8978 {
  public:
-  WM8978() {}
+  WM8978();
   ~WM8978() {}
   bool begin(); /* use this function if you want to setup i2c before */
   // bool begin(const uint8_t sda, const uint8_t scl,
@@ -60,13 +62,26 @@ class WM8978 {
   void setALC(uint8_t enable, uint8_t maxgain, uint8_t mingain);
   void setHPF(uint8_t enable);
   void setWire(TwoWire& wire){
-    p_wire = &wire;
+    wire_bus.setWire(wire);
+    p_bus = &wire_bus;
   }
+  void setControlBus(ControlBus& bus){
+    p_bus = &bus;
+  }
+  /// Number of registers
+  int getRegisterCount() { return regs.size(); }
+  /// Provides the last written value of a register
+  uint16_t getRegister(uint8_t reg) { return Read_Reg(reg); }
+  /// Writes all registers with the indicated values (R0 is ignored)
+  bool restoreRegisters(const uint16_t* values, int count);
 
  private:
-  TwoWire* p_wire = &Wire;
+  ControlBusTwoWire wire_bus;
+  ControlBus* p_bus = &wire_bus;
+  RegisterMap<58, 9> regs;
   uint8_t Init(void);
   uint8_t Write_Reg(uint8_t reg, uint16_t val);
   uint16_t Read_Reg(uint8_t reg);
+  bool Flush_Regs();
 };
 #endif
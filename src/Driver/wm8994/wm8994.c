@@ -107,6 +107,7 @@
 static uint32_t outputEnabled = 0;
 static uint32_t inputEnabled = 0;
 static void* i2c_handle;
+static uint16_t power_mgnt_reg_1 = 0;
 /**
   * @}
   */ 
@@ -126,7 +127,7 @@ static uint8_t CODEC_IO_Write16(uint8_t Addr, uint16_t Reg, uint16_t Value)
   
 #ifdef VERIFY_WRITTENDATA
   /* Verify that the data has been correctly written */
-  result = (AUDIO_IO_Read(Addr, Reg) == Value)? 0:1;
+  result = (AUDIO_IO_Read16(Addr, Reg) == Value)? 0:1;
 #endif /* VERIFY_WRITTENDATA */
   
   return result;
@@ -142,38 +143,13 @@ static uint8_t CODEC_IO_Write16(uint8_t Addr, uint16_t Reg, uint16_t Value)
   */ 
 
 /**
-  * @brief Initializes the audio codec and the control interface.
-  * @param DeviceAddr: Device address on communication Bus.   
-  * @param OutputInputDevice: can be OUTPUT_DEVICE_SPEAKER, OUTPUT_DEVICE_HEADPHONE,
-  *  OUTPUT_DEVICE_BOTH, OUTPUT_DEVICE_AUTO, INPUT_DEVICE_DIGITAL_MICROPHONE_1,
-  *  INPUT_DEVICE_DIGITAL_MICROPHONE_2, INPUT_DEVICE_INPUT_LINE_1 or INPUT_DEVICE_INPUT_LINE_2.
-  * @param Volume: Initial volume level (from 0 (Mute) to 100 (Max))
-  * @param AudioFreq: Audio Frequency 
+  * @brief Configures the audio paths, the clocks and the analog outputs up to the
+  *        charge pump.
   * @retval 0 if correct communication, else wrong communication
   */
-uint32_t wm8994_Init(uint16_t DeviceAddr, uint16_t OutputInputDevice, uint8_t Volume, uint32_t AudioFreq, void* i2c)
+static uint32_t wm8994_InitPaths(uint16_t DeviceAddr, uint16_t output_device, uint16_t input_device, uint32_t AudioFreq)
 {
-i2c_handle = i2c;
   uint32_t counter = 0;
-  uint16_t output_device = OutputInputDevice & 0xFF;
-  uint16_t input_device = OutputInputDevice & 0xFF00;
-  uint16_t power_mgnt_reg_1 = 0;
-  
-  /* Initialize the Control interface of the Audio Codec */
-  AUDIO_IO_Init();
-  /* wm8994 Errata Work-Arounds */
-  counter += CODEC_IO_Write16(DeviceAddr, 0x102, 0x0003);
-  counter += CODEC_IO_Write16(DeviceAddr, 0x817, 0x0000);
-  counter += CODEC_IO_Write16(DeviceAddr, 0x102, 0x0000);
-  
-  /* Enable VMID soft start (fast), Start-up Bias Current Enabled */
-  counter += CODEC_IO_Write16(DeviceAddr, 0x39, 0x006C);
-  
-  /* Enable bias generator, Enable VMID */
-  counter += CODEC_IO_Write16(DeviceAddr, 0x01, 0x0003);
-  
-  /* Add Delay */
-  AUDIO_IO_Delay(50);
 
   /* Path Configurations for output */
   if (output_device > 0)
@@ -412,10 +388,120 @@ i2c_handle = i2c;
 
     /* Enable Charge Pump */
     counter += CODEC_IO_Write16(DeviceAddr, 0x4C, 0x9F25);
+  }
+
+  return counter;
+}
+
+/**
+  * @brief Configures the selected audio input.
+  * @retval 0 if correct communication, else wrong communication
+  */
+static uint32_t wm8994_InitInput(uint16_t DeviceAddr, uint16_t input_device, uint8_t Volume)
+{
+  uint32_t counter = 0;
+
+  if (input_device > 0) /* Audio input selected */
+  {
+    if ((input_device == INPUT_DEVICE_DIGITAL_MICROPHONE_1) || (input_device == INPUT_DEVICE_DIGITAL_MICROPHONE_2))
+    {
+      /* Enable Microphone bias 1 generator, Enable VMID */
+      power_mgnt_reg_1 |= 0x0013;
+      counter += CODEC_IO_Write16(DeviceAddr, 0x01, power_mgnt_reg_1);
+
+      /* ADC oversample enable */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x620, 0x0002);
+
+      /* AIF ADC2 HPF enable, HPF cut = voice mode 1 fc=127Hz at fs=8kHz */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x411, 0x3800);
+    }
+    else if ((input_device == INPUT_DEVICE_INPUT_LINE_1) || (input_device == INPUT_DEVICE_INPUT_LINE_2))
+    {
+      /* Enable normal bias generator, Enable VMID */
+      power_mgnt_reg_1 |= 0x0003;
+      counter += CODEC_IO_Write16(DeviceAddr, 0x01, power_mgnt_reg_1);
+
+      /* Disable mute on IN1L, IN1L Volume = +0dB */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x18, 0x000B);
+
+      /* Disable mute on IN1R, IN1R Volume = +0dB */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x1A, 0x000B);
+
+      /* Disable mute on IN1L_TO_MIXINL, Gain = +0dB */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x29, 0x0025);
+
+      /* Disable mute on IN1R_TO_MIXINL, Gain = +0dB */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x2A, 0x0025);
+
+      /* IN1LN_TO_IN1L, IN1LP_TO_VMID, IN1RN_TO_IN1R, IN1RP_TO_VMID */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x28, 0x0011);
+
+      /* AIF ADC1 HPF enable, HPF cut = hifi mode fc=4Hz at fs=48kHz */
+      counter += CODEC_IO_Write16(DeviceAddr, 0x410, 0x1800);
+    }
+    /* Volume Control */
+    wm8994_SetVolume(DeviceAddr, Volume);
+  }
+
+  return counter;
+}
+
+/**
+  * @brief Executes one step of the initialization: the caller needs to wait
+  *        WaitMs before calling the next step. The initialization is complete
+  *        when WaitMs is 0.
+  * @param DeviceAddr: Device address on communication Bus.   
+  * @param OutputInputDevice: see wm8994_Init()
+  * @param Volume: Initial volume level (from 0 (Mute) to 100 (Max))
+  * @param AudioFreq: Audio Frequency 
+  * @param Step: step number starting with 0
+  * @param WaitMs: returns the delay in ms before the next step
+  * @retval 0 if correct communication, else wrong communication
+  */
+uint32_t wm8994_InitStep(uint16_t DeviceAddr, uint16_t OutputInputDevice, uint8_t Volume, uint32_t AudioFreq, void* i2c, int Step, uint32_t *WaitMs)
+{
+  i2c_handle = i2c;
+  uint32_t counter = 0;
+  uint16_t output_device = OutputInputDevice & 0xFF;
+  uint16_t input_device = OutputInputDevice & 0xFF00;
+
+  *WaitMs = 0;
+  switch (Step)
+  {
+  case 0:
+    power_mgnt_reg_1 = 0;
+
+    /* Initialize the Control interface of the Audio Codec */
+    AUDIO_IO_Init();
+    /* wm8994 Errata Work-Arounds */
+    counter += CODEC_IO_Write16(DeviceAddr, 0x102, 0x0003);
+    counter += CODEC_IO_Write16(DeviceAddr, 0x817, 0x0000);
+    counter += CODEC_IO_Write16(DeviceAddr, 0x102, 0x0000);
+    
+    /* Enable VMID soft start (fast), Start-up Bias Current Enabled */
+    counter += CODEC_IO_Write16(DeviceAddr, 0x39, 0x006C);
+    
+    /* Enable bias generator, Enable VMID */
+    counter += CODEC_IO_Write16(DeviceAddr, 0x01, 0x0003);
 
     /* Add Delay */
-    AUDIO_IO_Delay(15);
+    *WaitMs = 50;
+    break;
+
+  case 1:
+    counter += wm8994_InitPaths(DeviceAddr, output_device, input_device, AudioFreq);
+    if (output_device > 0)
+    {
+      /* Add Delay */
+      *WaitMs = 15;
+    }
+    else
+    {
+      counter += wm8994_InitInput(DeviceAddr, input_device, Volume);
+    }
+    break;
 
+  case 2:
     /* Select DAC1 (Left) to Left Headphone Output PGA (HPOUT1LVOL) path */
     counter += CODEC_IO_Write16(DeviceAddr, 0x2D, 0x0001);
 
@@ -430,8 +516,10 @@ i2c_handle = i2c;
     counter += CODEC_IO_Write16(DeviceAddr, 0x54, 0x0033);
 
     /* Add Delay */
-    AUDIO_IO_Delay(250);
+    *WaitMs = 250;
+    break;
 
+  case 3:
     /* Enable HPOUT1 (Left) and HPOUT1 (Right) intermediate and output stages. Remove clamps */
     counter += CODEC_IO_Write16(DeviceAddr, 0x60, 0x00EE);
 
@@ -457,51 +545,43 @@ i2c_handle = i2c;
     
     /* Volume Control */
     wm8994_SetVolume(DeviceAddr, Volume);
+
+    counter += wm8994_InitInput(DeviceAddr, input_device, Volume);
+    break;
+
+  default:
+    break;
   }
+  /* Return communication control value */
+  return counter;
+}
 
-  if (input_device > 0) /* Audio input selected */
+/**
+  * @brief Initializes the audio codec and the control interface.
+  * @param DeviceAddr: Device address on communication Bus.   
+  * @param OutputInputDevice: can be OUTPUT_DEVICE_SPEAKER, OUTPUT_DEVICE_HEADPHONE,
+  *  OUTPUT_DEVICE_BOTH, OUTPUT_DEVICE_AUTO, INPUT_DEVICE_DIGITAL_MICROPHONE_1,
+  *  INPUT_DEVICE_DIGITAL_MICROPHONE_2, INPUT_DEVICE_INPUT_LINE_1 or INPUT_DEVICE_INPUT_LINE_2.
+  * @param Volume: Initial volume level (from 0 (Mute) to 100 (Max))
+  * @param AudioFreq: Audio Frequency 
+  * @retval 0 if correct communication, else wrong communication
+  */
+uint32_t wm8994_Init(uint16_t DeviceAddr, uint16_t OutputInputDevice, uint8_t Volume, uint32_t AudioFreq, void* i2c)
+{
+  uint32_t counter = 0;
+  uint32_t wait_ms = 0;
+  int step = 0;
+
+  do
   {
-    if ((input_device == INPUT_DEVICE_DIGITAL_MICROPHONE_1) || (input_device == INPUT_DEVICE_DIGITAL_MICROPHONE_2))
+    counter += wm8994_InitStep(DeviceAddr, OutputInputDevice, Volume, AudioFreq, i2c, step++, &wait_ms);
+    if (wait_ms > 0)
     {
-      /* Enable Microphone bias 1 generator, Enable VMID */
-      power_mgnt_reg_1 |= 0x0013;
-      counter += CODEC_IO_Write16(DeviceAddr, 0x01, power_mgnt_reg_1);
-
-      /* ADC oversample enable */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x620, 0x0002);
-
-      /* AIF ADC2 HPF enable, HPF cut = voice mode 1 fc=127Hz at fs=8kHz */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x411, 0x3800);
+      AUDIO_IO_Delay(wait_ms);
     }
-    else if ((input_device == INPUT_DEVICE_INPUT_LINE_1) || (input_device == INPUT_DEVICE_INPUT_LINE_2))
-    {
-      /* Enable normal bias generator, Enable VMID */
-      power_mgnt_reg_1 |= 0x0003;
-      counter += CODEC_IO_Write16(DeviceAddr, 0x01, power_mgnt_reg_1);
+  } while (wait_ms > 0);
 
-      /* Disable mute on IN1L, IN1L Volume = +0dB */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x18, 0x000B);
-
-      /* Disable mute on IN1R, IN1R Volume = +0dB */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x1A, 0x000B);
-
-      /* Disable mute on IN1L_TO_MIXINL, Gain = +0dB */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x29, 0x0025);
-
-      /* Disable mute on IN1R_TO_MIXINL, Gain = +0dB */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x2A, 0x0025);
-
-      /* IN1LN_TO_IN1L, IN1LP_TO_VMID, IN1RN_TO_IN1R, IN1RP_TO_VMID */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x28, 0x0011);
-
-      /* AIF ADC1 HPF enable, HPF cut = hifi mode fc=4Hz at fs=48kHz */
-      counter += CODEC_IO_Write16(DeviceAddr, 0x410, 0x1800);
-    }
-    /* Volume Control */
-    wm8994_SetVolume(DeviceAddr, Volume);
-  }
-  /* Return communication control value */
-  return counter;  
+  return counter;
 }
 
 /**
@@ -921,8 +1001,17 @@ uint32_t wm8994_Reset(uint16_t DeviceAddr)
 
 //void AUDIO_IO_Init(void) {}
 //void AUDIO_IO_DeInit(void) {}
+// register address and value are sent MSB first
 void AUDIO_IO_Write16(uint8_t addr, uint16_t reg, uint16_t value) {
-  i2c_bus_write_bytes(i2c_handle, addr, (uint8_t *)&reg, sizeof(uint16_t),(uint8_t*) &value, sizeof(value));
+  uint8_t reg_data[2] = {(uint8_t)(reg >> 8), (uint8_t)(reg & 0xFF)};
+  uint8_t value_data[2] = {(uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+  i2c_bus_write_bytes(i2c_handle, addr, reg_data, sizeof(reg_data), value_data, sizeof(value_data));
+}
+uint16_t AUDIO_IO_Read16(uint8_t addr, uint16_t reg) {
+  uint8_t reg_data[2] = {(uint8_t)(reg >> 8), (uint8_t)(reg & 0xFF)};
+  uint8_t value_data[2] = {0};
+  i2c_bus_read_bytes(i2c_handle, addr, reg_data, sizeof(reg_data), value_data, sizeof(value_data));
+  return (value_data[0] << 8) | value_data[1];
 }
 void AUDIO_IO_Delay(uint32_t Delay) {delay(Delay);}
 
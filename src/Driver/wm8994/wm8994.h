@@ -138,6 +138,7 @@ extern "C" {
 ------------------------------------------------------------------------------*/
 /* High Layer codec functions */
 uint32_t wm8994_Init(uint16_t DeviceAddr, uint16_t OutputInputDevice, uint8_t Volume, uint32_t AudioFreq, void* i2c);
+uint32_t wm8994_InitStep(uint16_t DeviceAddr, uint16_t OutputInputDevice, uint8_t Volume, uint32_t AudioFreq, void* i2c, int Step, uint32_t *WaitMs);
 void     wm8994_DeInit(void);
 uint32_t wm8994_ReadID(uint16_t DeviceAddr);
 uint32_t wm8994_Play(uint16_t DeviceAddr, uint16_t* pBuffer, uint16_t Size);
@@ -154,7 +155,7 @@ uint32_t wm8994_Reset(uint16_t DeviceAddr);
 void    AUDIO_IO_Init(void);
 void    AUDIO_IO_DeInit(void);
 void    AUDIO_IO_Write16(uint8_t Addr, uint16_t Reg, uint16_t Value);
-uint8_t AUDIO_IO_Read16(uint8_t Addr, uint16_t Reg);
+uint16_t AUDIO_IO_Read16(uint8_t Addr, uint16_t Reg);
 void    AUDIO_IO_Delay(uint32_t Delay);
 
 /* Audio driver structure */
@@ -164,6 +164,11 @@ struct PinsI2C {
 
   PinFunction function;
   uint32_t frequency = 100000;
+  /// opt-in: if > frequency, begin() tries faster clocks up to this value
+  uint32_t max_frequency = 0;
+  /// register which is read to verify a clock: -1 for write-only devices,
+  /// which keep the frequency
+  int probe_reg = I2C_CLOCK_PROBE_REG;
   int port = -1;
   GpioPin scl = -1;
   GpioPin sda = -1;
@@ -196,6 +201,7 @@ struct PinsI2C {
       }
       AD_LOGI("Setting i2c clock: %u", frequency);
       p_wire->setClock(frequency);
+      if (max_frequency > frequency) negotiateClock();
     } else {
       AD_LOGI("I2C, not activated, SDA, SCL, i2c clock not modified");
     }
@@ -206,6 +212,53 @@ struct PinsI2C {
     if (set_active) p_wire->end();
 #endif
   }
+
+ protected:
+  /// Steps through the faster standard clocks up to max_frequency and keeps
+  /// the fastest one at which the device (port = I2C address) is stable
+  void negotiateClock() {
+    if (port <= 0) {
+      AD_LOGW("I2C clock negotiation needs the device address in port");
+      return;
+    }
+    // writing the register address would change a write-only device
+    if (probe_reg < 0) {
+      AD_LOGI("No I2C clock negotiation for write-only device");
+      return;
+    }
+    // reference value from a register read at the safe clock: devices which
+    // do not support reads are verified with an ACK check only
+    int ref_value = readProbe();
+    const uint32_t rates[] = {400000, 1000000};
+    uint32_t good = frequency;
+    for (uint32_t rate : rates) {
+      if (rate <= good || rate > max_frequency) continue;
+      p_wire->setClock(rate);
+      if (!isStable(ref_value)) break;
+      good = rate;
+    }
+    p_wire->setClock(good);
+    AD_LOGI("Negotiated i2c clock: %u", good);
+    frequency = good;
+  }
+
+  bool isStable(int refValue) {
+    for (int j = 0; j < I2C_CLOCK_PROBE_COUNT; j++) {
+      p_wire->beginTransmission(port);
+      if (p_wire->endTransmission(true) != 0) return false;
+      if (refValue >= 0 && readProbe() != refValue) return false;
+    }
+    return true;
+  }
+
+  /// Reads the probe_reg: returns -1 if this is not supported
+  int readProbe() {
+    p_wire->beginTransmission(port);
+    p_wire->write((uint8_t)probe_reg);
+    if (p_wire->endTransmission(false) != 0) return -1;
+    if (p_wire->requestFrom(port, 1, true) != 1) return -1;
+    return p_wire->read();
+  }
 };
 
 /**
@@ -288,6 +341,24 @@ class DriverPins {
   /// Updates the I2C pin information using the function as key
   bool setI2C(PinsI2C pin) { return set<PinsI2C>(pin, i2c); }
 
+  /// Opt-in for the I2C clock negotiation in begin(): the fastest stable
+  /// clock up to maxFrequency is used
+  bool setI2CMaxFrequency(PinFunction function, uint32_t maxFrequency) {
+    PinsI2C *pins = getPtr<PinsI2C>(function, i2c);
+    if (pins == nullptr) return false;
+    pins->max_frequency = maxFrequency;
+    return true;
+  }
+
+  /// Defines the register which is read by the I2C clock negotiation: -1 if
+  /// the device can not be read
+  bool setI2CProbeRegister(PinFunction function, int reg) {
+    PinsI2C *pins = getPtr<PinsI2C>(function, i2c);
+    if (pins == nullptr) return false;
+    pins->probe_reg = reg;
+    return true;
+  }
+
   bool addPin(PinsFunction pin) {
     pins.push_back(pin);
     return true;
@@ -0,0 +1,208 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "DriverCommon.h"
+
+namespace audio_driver {
+
+/**
+ * @brief Clock requirements of a codec configuration: a mclk or bclk of 0
+ * means that the planner can select the value.
+ * @ingroup audio_driver
+ */
+struct ClockRequest {
+  uint32_t mclk = 0;
+  uint32_t bclk = 0;
+  uint32_t rate = 44100;
+  uint8_t bits = 16;
+  uint8_t channels = 2;
+  /// the chip may use its PLL
+  bool pll = false;
+};
+
+/**
+ * @brief Clock solution for a chip: the divider details are chip specific
+ * and are identified by index (e.g. the entry of a coefficient table) and
+ * the PLL values. If the requested rate is not supported, the plan describes
+ * the nearest supported rate and exact is false.
+ * @ingroup audio_driver
+ */
+struct ClockPlan {
+  bool valid = false;
+  bool exact = false;
+  uint32_t rate = 0;
+  uint32_t mclk = 0;
+  uint32_t bclk = 0;
+  /// bclk = mclk / bclk_div (0: bclk is not derived from mclk)
+  uint16_t bclk_div = 0;
+  /// chip specific index of the solution (-1: not used)
+  int16_t index = -1;
+  /// PLL: N.K with K as 24 bit fraction (0: PLL not used)
+  uint32_t pll_n = 0;
+  uint32_t pll_k = 0;
+  uint32_t pll_out = 0;
+};
+
+/// Chip specific calculation of a clock solution: returns false if the
+/// request can not be supported
+typedef bool (*clock_solver_t)(const ClockRequest &request, ClockPlan &plan);
+
+/**
+ * @brief Calculates the clock solution for a codec with the solver of the
+ * chip and caches the result, so that a change back to a known configuration
+ * does not need any search. If the requested rate can not be supported, the
+ * solution for the nearest supported standard rate is provided instead.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ClockPlanner {
+ public:
+  /// Provides the clock plan for the request: returns false if neither the
+  /// requested nor any alternative rate is supported by the chip
+  bool plan(clock_solver_t solver, const ClockRequest &request,
+            ClockPlan &result) {
+    if (solver == nullptr) return false;
+    for (int j = 0; j < count; j++) {
+      Entry &entry = cache[j];
+      if (entry.solver == solver && isEqual(entry.request, request)) {
+        entry.used = ++use_counter;
+        result = entry.plan;
+        return result.valid;
+      }
+    }
+    result = solve(solver, request);
+    store(solver, request, result);
+    return result.valid;
+  }
+
+  /// Forgets all cached solutions
+  void clear() { count = 0; }
+
+  /// The shared planner of all drivers
+  static ClockPlanner &instance() {
+    static ClockPlanner planner;
+    return planner;
+  }
+
+  /// Provides the standard rates which are supported by the solver for the
+  /// request (with any rate): returns the number of supported rates
+  static int getRates(clock_solver_t solver, const ClockRequest &request,
+                      uint32_t *rates, int max) {
+    int rate_count;
+    const uint32_t *standard = getStandardRates(rate_count);
+    int count = 0;
+    for (int j = 0; j < rate_count; j++) {
+      ClockRequest req = request;
+      req.rate = standard[j];
+      ClockPlan plan;
+      if (solver == nullptr || !solver(req, plan)) continue;
+      if (rates != nullptr && count < max) rates[count] = standard[j];
+      count++;
+    }
+    return count;
+  }
+
+  /// The sample rates which are tried as alternatives
+  static const uint32_t *getStandardRates(int &count) {
+    static const uint32_t rates[] = {8000,  11025, 12000, 16000,
+                                     22050, 24000, 32000, 44100,
+                                     48000, 64000, 88200, 96000};
+    count = sizeof(rates) / sizeof(rates[0]);
+    return rates;
+  }
+
+  /// Solution with the standard dividers which are used by most codecs:
+  /// mclk = ratio * rate and bclk = rate * bits * channels
+  static bool solveRatio(const ClockRequest &request, ClockPlan &plan,
+                         uint32_t ratio = 256) {
+    uint32_t mclk = request.mclk != 0 ? request.mclk : request.rate * ratio;
+    uint32_t bclk = request.bclk != 0
+                        ? request.bclk
+                        : request.rate * request.bits * request.channels;
+    if (mclk == 0 || bclk == 0 || bclk > mclk) return false;
+    plan.rate = request.rate;
+    plan.mclk = mclk;
+    plan.bclk = bclk;
+    plan.bclk_div = mclk % bclk == 0 ? mclk / bclk : 0;
+    return true;
+  }
+
+ protected:
+  struct Entry {
+    clock_solver_t solver;
+    ClockRequest request;
+    ClockPlan plan;
+    uint32_t used;
+  };
+  Entry cache[CLOCK_PLAN_CACHE_SIZE];
+  int count = 0;
+  uint32_t use_counter = 0;
+
+  static bool isEqual(const ClockRequest &a, const ClockRequest &b) {
+    return a.mclk == b.mclk && a.bclk == b.bclk && a.rate == b.rate &&
+           a.bits == b.bits && a.channels == b.channels && a.pll == b.pll;
+  }
+
+  ClockPlan solve(clock_solver_t solver, const ClockRequest &request) {
+    ClockPlan plan;
+    if (solver(request, plan)) {
+      plan.valid = true;
+      plan.exact = true;
+      return plan;
+    }
+    // try the standard rates ordered by their distance to the requested rate
+    int rate_count;
+    const uint32_t *rates = getStandardRates(rate_count);
+    bool tried[16] = {false};
+    for (int n = 0; n < rate_count; n++) {
+      int best = -1;
+      for (int j = 0; j < rate_count; j++) {
+        if (tried[j]) continue;
+        if (best < 0 || distance(rates[j], request.rate) <
+                            distance(rates[best], request.rate))
+          best = j;
+      }
+      tried[best] = true;
+      if (rates[best] == request.rate) continue;
+      ClockRequest alt = request;
+      alt.rate = rates[best];
+      // a bclk which was derived from the rate changes with the rate
+      if (request.bclk != 0 && request.rate != 0)
+        alt.bclk = (uint64_t)request.bclk * alt.rate / request.rate;
+      ClockPlan alt_plan;
+      if (solver(alt, alt_plan)) {
+        AD_LOGW("Rate %u not supported: nearest alternative is %u",
+                (unsigned)request.rate, (unsigned)alt.rate);
+        alt_plan.valid = true;
+        alt_plan.exact = false;
+        return alt_plan;
+      }
+    }
+    AD_LOGE("No clock solution for rate %u", (unsigned)request.rate);
+    return ClockPlan();
+  }
+
+  static uint32_t distance(uint32_t a, uint32_t b) {
+    return a > b ? a - b : b - a;
+  }
+
+  /// Stores the plan: if the cache is full the least recently used entry is
+  /// replaced
+  void store(clock_solver_t solver, const ClockRequest &request,
+             const ClockPlan &plan) {
+    int pos = count;
+    if (count < CLOCK_PLAN_CACHE_SIZE) {
+      count++;
+    } else {
+      pos = 0;
+      for (int j = 1; j < count; j++) {
+        if (cache[j].used < cache[pos].used) pos = j;
+      }
+    }
+    cache[pos] = {solver, request, plan, ++use_counter};
+  }
+};
+
+}  // namespace audio_driver
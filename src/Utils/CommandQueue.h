@@ -0,0 +1,213 @@
+#pragma once
+#include "DriverCommon.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#  include "freertos/FreeRTOS.h"
+#  include "freertos/queue.h"
+#  include "freertos/task.h"
+#  include <atomic>
+#  define COMMAND_QUEUE_FREERTOS
+#  define COMMAND_QUEUE_ATOMIC
+#elif !defined(ARDUINO)
+#  include <atomic>
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#  define COMMAND_QUEUE_STD_THREAD
+#  define COMMAND_QUEUE_ATOMIC
+#endif
+
+namespace audio_driver {
+
+/**
+ * @brief Bounded FIFO of commands which are executed by a background task:
+ * On the ESP32 we use a FreeRTOS task, on the desktop a std::thread. On all
+ * other platforms there is no task and you need to call process() e.g. in
+ * the loop(). push() never blocks: it fails if the queue is full. end()
+ * lets the task finish the command which is in progress before it returns.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <class T, int N = ASYNC_QUEUE_SIZE>
+class CommandQueue {
+ public:
+  typedef void (*handler_t)(T &cmd, void *ref);
+
+  ~CommandQueue() { end(); }
+
+  /// Defines the handler which executes the commands and starts the task
+  bool begin(handler_t handler, void *ref = nullptr) {
+    if (is_active) return true;
+    p_handler = handler;
+    p_ref = ref;
+#if defined(COMMAND_QUEUE_FREERTOS)
+    queue = xQueueCreate(N, sizeof(Item));
+    if (queue == nullptr) {
+      AD_LOGE("xQueueCreate");
+      return false;
+    }
+    if (xTaskCreate(task, "audio-driver", ASYNC_TASK_STACK_SIZE, this,
+                    ASYNC_TASK_PRIORITY, &task_handle) != pdPASS) {
+      AD_LOGE("xTaskCreate");
+      vQueueDelete(queue);
+      queue = nullptr;
+      task_handle = nullptr;
+      return false;
+    }
+#elif defined(COMMAND_QUEUE_STD_THREAD)
+    is_stopping = false;
+    worker = std::thread(task, this);
+#endif
+    is_active = true;
+    return true;
+  }
+
+  /// Stops the task: commands which have not been executed are dropped. The
+  /// command which is in progress is completed first, so the task never
+  /// stops while it holds the bus. Must not be called from the handler.
+  void end() {
+    if (!is_active) return;
+    is_active = false;
+#if defined(COMMAND_QUEUE_FREERTOS)
+    // the stop request overtakes the pending commands, which are dropped
+    xQueueReset(queue);
+    Item stop;
+    stop.is_stop = true;
+    p_joiner = xTaskGetCurrentTaskHandle();
+    xQueueSendToFront(queue, &stop, portMAX_DELAY);
+    // wait until the task has left its loop
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    vQueueDelete(queue);
+    task_handle = nullptr;
+    queue = nullptr;
+#else
+#  if defined(COMMAND_QUEUE_STD_THREAD)
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      is_stopping = true;
+    }
+    cond.notify_all();
+    if (worker.joinable()) worker.join();
+#  endif
+    count = 0;
+#endif
+  }
+
+  /// Adds a command to the end of the queue: returns false if it is full
+  bool push(const T &cmd) {
+    if (!is_active) return false;
+#if defined(COMMAND_QUEUE_FREERTOS)
+    Item item;
+    item.is_stop = false;
+    item.cmd = cmd;
+    return xQueueSend(queue, &item, 0) == pdTRUE;
+#else
+#  if defined(COMMAND_QUEUE_STD_THREAD)
+    std::lock_guard<std::mutex> lock(mtx);
+#  endif
+    if (count >= N) return false;
+    data[(start + count) % N] = cmd;
+    count++;
+#  if defined(COMMAND_QUEUE_STD_THREAD)
+    cond.notify_one();
+#  endif
+    return true;
+#endif
+  }
+
+  /// Executes all queued commands: only needed if there is no task
+  void process() {
+    T cmd;
+    while (pop(cmd)) {
+      p_handler(cmd, p_ref);
+    }
+  }
+
+  /// Returns true if a background task executes the commands
+  bool isTaskActive() {
+#if defined(COMMAND_QUEUE_FREERTOS) || defined(COMMAND_QUEUE_STD_THREAD)
+    return is_active;
+#else
+    return false;
+#endif
+  }
+
+ protected:
+  handler_t p_handler = nullptr;
+  void *p_ref = nullptr;
+  volatile bool is_active = false;
+#if defined(COMMAND_QUEUE_FREERTOS)
+  /// queue entry: is_stop is the request to leave the task loop
+  struct Item {
+    bool is_stop;
+    T cmd;
+  };
+  QueueHandle_t queue = nullptr;
+  TaskHandle_t task_handle = nullptr;
+  /// task which waits in end() for the task loop to finish
+  TaskHandle_t p_joiner = nullptr;
+#else
+  T data[N];
+  int start = 0;
+  int count = 0;
+#  if defined(COMMAND_QUEUE_STD_THREAD)
+  std::thread worker;
+  std::mutex mtx;
+  std::condition_variable cond;
+  bool is_stopping = false;
+#  endif
+#endif
+
+  bool pop(T &cmd) {
+#if defined(COMMAND_QUEUE_FREERTOS)
+    Item item;
+    if (xQueueReceive(queue, &item, 0) != pdTRUE || item.is_stop) return false;
+    cmd = item.cmd;
+    return true;
+#else
+#  if defined(COMMAND_QUEUE_STD_THREAD)
+    std::lock_guard<std::mutex> lock(mtx);
+#  endif
+    if (count == 0) return false;
+    cmd = data[start];
+    start = (start + 1) % N;
+    count--;
+    return true;
+#endif
+  }
+
+#if defined(COMMAND_QUEUE_FREERTOS)
+  static void task(void *ref) {
+    CommandQueue *self = (CommandQueue *)ref;
+    Item item;
+    while (true) {
+      if (xQueueReceive(self->queue, &item, portMAX_DELAY) != pdTRUE) continue;
+      if (item.is_stop) break;
+      self->p_handler(item.cmd, self->p_ref);
+    }
+    // self must not be accessed after the notification
+    xTaskNotifyGive(self->p_joiner);
+    vTaskDelete(nullptr);
+  }
+#elif defined(COMMAND_QUEUE_STD_THREAD)
+  static void task(CommandQueue *self) {
+    T cmd;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(self->mtx);
+        self->cond.wait(
+            lock, [self] { return self->count > 0 || self->is_stopping; });
+        if (self->is_stopping) break;
+      }
+      while (self->pop(cmd)) {
+        self->p_handler(cmd, self->p_ref);
+        std::lock_guard<std::mutex> lock(self->mtx);
+        if (self->is_stopping) return;
+      }
+    }
+  }
+#endif
+};
+
+}  // namespace audio_driver
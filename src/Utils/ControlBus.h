@@ -0,0 +1,808 @@
+#pragma once
+#include <string.h>
+
+#include "DriverCommon.h"
+#include "SPI.h"
+#include "Utils/I2C.h"
+#include "Utils/RegisterMap.h"
+#include "Utils/Vector.h"
+#include "Utils/etc.h"
+#include "Wire.h"
+
+#if !defined(ARDUINO)
+#  include <chrono>
+#  include <thread>
+#endif
+
+#if defined(__linux__) && !defined(ARDUINO)
+#  include <fcntl.h>
+#  include <linux/i2c-dev.h>
+#  include <linux/i2c.h>
+#  include <sys/ioctl.h>
+#  include <unistd.h>
+#endif
+
+namespace audio_driver {
+
+/**
+ * @brief Abstract transport which is used by all drivers to access the
+ * registers of the codec chips. The C drivers get a pointer to the
+ * ControlBus as i2c_bus_handle_t and use it via the i2c_bus_xxx() functions.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBus {
+ public:
+  virtual ~ControlBus() = default;
+
+  /// Writes the register address followed by the data in one transaction;
+  /// stop = false requests a repeated START for the next transaction
+  virtual error_t write(int addr, const uint8_t *reg, int reglen,
+                        const uint8_t *data, int datalen, bool stop = true) = 0;
+
+  /// Writes the register address and reads datalen bytes in one transaction
+  virtual error_t read(int addr, const uint8_t *reg, int reglen,
+                       uint8_t *data, int datalen) = 0;
+
+  /// Checks if the device is responding
+  virtual error_t check(int addr) = 0;
+
+  /// Writes a sequence of register values: runs of consecutive registers are
+  /// sent as one burst
+  virtual error_t writeSeq(int addr, const i2c_reg_value_t *seq, int count,
+                           bool autoIncrement) {
+    int result = RESULT_OK;
+    uint8_t values[I2C_MAX_BURST_LEN];
+    int pos = 0;
+    while (pos < count) {
+      // determine the run of consecutive registers starting at pos
+      int len = 1;
+      if (autoIncrement) {
+        while (pos + len < count && len < I2C_MAX_BURST_LEN &&
+               seq[pos + len].reg == (uint8_t)(seq[pos].reg + len)) {
+          len++;
+        }
+      }
+      for (int j = 0; j < len; j++) {
+        values[j] = seq[pos + j].value;
+      }
+      // each run ends with a STOP: e.g. the ESP32 Wire only keeps a pending
+      // repeated START for a following requestFrom() and drops the data
+      // when the next write starts
+      if (write(addr, &seq[pos].reg, 1, values, len, true) != RESULT_OK) {
+        AD_LOGE("writeSeq: reg=0x%X len=%d", seq[pos].reg, len);
+        result = RESULT_FAIL;
+      }
+      pos += len;
+    }
+    return result;
+  }
+
+  /// Waits for the indicated number of milliseconds
+  virtual void delayMs(uint32_t ms) { delay(ms); }
+
+  /// Forgets cached register values of a device (or of all devices with -1),
+  /// e.g. after a reset
+  virtual void invalidate(int addr = -1) {}
+
+  /// Tries to free a stuck bus: returns false if this is not supported
+  virtual bool recover() { return false; }
+
+  /// Defines the retry policy for failed transactions: max number of retries
+  /// and the hard deadline in us for all attempts
+  void setRetry(int count, uint32_t deadlineUs) {
+    retry_count = count;
+    retry_deadline_us = deadlineUs;
+  }
+
+  /// Current time in microseconds
+  static uint32_t timeUs() {
+#ifdef ARDUINO
+    return micros();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+ protected:
+  int retry_count = I2C_RETRY_COUNT;
+  uint32_t retry_deadline_us = I2C_RETRY_DEADLINE_US;
+
+  /// Executes op until it succeeds, the retries are used up or the deadline
+  /// would be exceeded: after the first failure recover() is called (which
+  /// only acts on a stuck bus) and the wait between the attempts is doubled.
+  /// An attempt is only started if it can end before the deadline, based on
+  /// the longest duration of the previous attempts.
+  template <class F>
+  error_t retry(F op) {
+    uint32_t start = timeUs();
+    uint32_t backoff = I2C_RETRY_BACKOFF_US;
+    error_t rc = op();
+    uint32_t op_us = timeUs() - start;
+    for (int j = 0; j < retry_count && rc != RESULT_OK; j++) {
+      if (j == 0) recover();
+      if (timeUs() - start + backoff + op_us > retry_deadline_us) break;
+      delayUs(backoff);
+      backoff *= 2;
+      uint32_t op_start = timeUs();
+      rc = op();
+      uint32_t duration = timeUs() - op_start;
+      if (duration > op_us) op_us = duration;
+    }
+    return rc;
+  }
+
+  static void delayUs(uint32_t us) {
+#ifdef ARDUINO
+    delayMicroseconds(us);
+#else
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+#endif
+  }
+};
+
+/**
+ * @brief ControlBus for I2C using the Arduino TwoWire API
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusTwoWire : public ControlBus {
+ public:
+  ControlBusTwoWire() = default;
+  ControlBusTwoWire(TwoWire &wire) { setWire(wire); }
+
+  void setWire(TwoWire &wire) { p_wire = &wire; }
+  TwoWire *wire() { return p_wire; }
+
+  /// Defines the pins which are used by recover(): the Wire is restarted
+  /// with the indicated clock
+  void setRecoveryPins(int scl, int sda, uint32_t frequency) {
+    scl_pin = scl;
+    sda_pin = sda;
+    this->frequency = frequency;
+  }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    return retry([&]() {
+      return writeOnce(addr, reg, reglen, data, datalen, stop);
+    });
+  }
+
+  error_t read(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+               int datalen) override {
+    return retry([&]() { return readOnce(addr, reg, reglen, data, datalen); });
+  }
+
+  /// Frees a SDA line which is held low by a device: SCL is toggled (max 9
+  /// times) until SDA is released, then a STOP is generated and the Wire is
+  /// restarted. Nothing is done if SDA is high (e.g. after a NACK).
+  bool recover() override {
+    if (scl_pin < 0 || sda_pin < 0) return false;
+    if (digitalRead(sda_pin) != LOW) return false;
+    AD_LOGW("I2C bus recovery");
+    pinMode(sda_pin, INPUT_PULLUP);
+    pinMode(scl_pin, OUTPUT);
+    digitalWrite(scl_pin, HIGH);
+    for (int j = 0; j < 9 && digitalRead(sda_pin) == LOW; j++) {
+      digitalWrite(scl_pin, LOW);
+      delayUs(5);
+      digitalWrite(scl_pin, HIGH);
+      delayUs(5);
+    }
+    // STOP: SDA goes high while SCL is high
+    pinMode(sda_pin, OUTPUT);
+    digitalWrite(scl_pin, LOW);
+    digitalWrite(sda_pin, LOW);
+    delayUs(5);
+    digitalWrite(scl_pin, HIGH);
+    delayUs(5);
+    digitalWrite(sda_pin, HIGH);
+    delayUs(5);
+    // give the pins back to the Wire
+#if defined(ESP32)
+    p_wire->end();
+    p_wire->begin(sda_pin, scl_pin);
+#elif defined(ARDUINO_ARCH_RP2040) || defined(ARDUINO_ARCH_STM32)
+    p_wire->end();
+    p_wire->setSCL(scl_pin);
+    p_wire->setSDA(sda_pin);
+    p_wire->begin();
+#else
+    p_wire->begin();
+#endif
+    if (frequency > 0) p_wire->setClock(frequency);
+    return true;
+  }
+
+  error_t check(int addr) override {
+    assert(p_wire != nullptr);
+    p_wire->beginTransmission(addr);
+    int rc = p_wire->endTransmission(I2C_END);
+    if (rc != 0) {
+      AD_LOGE("->p_wire->endTransmission: %d", rc);
+      return RESULT_FAIL;
+    }
+    return RESULT_OK;
+  }
+
+ protected:
+  TwoWire *p_wire = &Wire;
+  int scl_pin = -1;
+  int sda_pin = -1;
+  uint32_t frequency = 0;
+
+  error_t writeOnce(int addr, const uint8_t *reg, int reglen,
+                    const uint8_t *data, int datalen, bool stop) {
+    assert(p_wire != nullptr);
+    p_wire->beginTransmission(addr);
+    p_wire->write(reg, reglen);
+    p_wire->write(data, datalen);
+    int rc = p_wire->endTransmission(stop);
+    if (rc != 0) {
+      AD_LOGE("->p_wire->endTransmission: %d", rc);
+      return RESULT_FAIL;
+    }
+    return RESULT_OK;
+  }
+
+  error_t readOnce(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+                   int datalen) {
+    assert(p_wire != nullptr);
+    int result = RESULT_OK;
+    p_wire->beginTransmission(addr);
+    p_wire->write(reg, reglen);
+    int rc = p_wire->endTransmission(!I2C_REPEATED_START);
+    if (rc != 0) {
+      AD_LOGE("->p_wire->endTransmission: %d", rc);
+    }
+
+    int result_len = p_wire->requestFrom((addr), datalen, I2C_END);
+    if (result_len > 0) {
+      result_len = p_wire->readBytes(data, datalen);
+    }
+    if (result_len != datalen) {
+      AD_LOGE("->p_wire->requestFrom %d->%d", datalen, result_len);
+      result = RESULT_FAIL;
+    }
+    return result;
+  }
+};
+
+/**
+ * @brief ControlBus for SPI register access: a frame consists of the chip
+ * address byte (addr << 1 | R/W) followed by the register and the data as
+ * used e.g. by the AD1938. The chip select pin is active low.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusSPI : public ControlBus {
+ public:
+  ControlBusSPI() = default;
+  ControlBusSPI(SPIClass &spi, int csPin, uint32_t clockHz = 1000000,
+                uint8_t mode = SPI_MODE3) {
+    setSPI(spi, csPin, clockHz, mode);
+  }
+
+  void setSPI(SPIClass &spi, int csPin, uint32_t clockHz = 1000000,
+              uint8_t mode = SPI_MODE3) {
+    p_spi = &spi;
+    cs_pin = csPin;
+    settings = SPISettings(clockHz, MSBFIRST, mode);
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH);
+  }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    if (p_spi == nullptr) return RESULT_FAIL;
+    uint8_t frame[1 + 4 + I2C_MAX_BURST_LEN];
+    if (reglen > 4 || datalen > I2C_MAX_BURST_LEN) return RESULT_FAIL;
+    int len = 0;
+    frame[len++] = addr << 1;
+    memcpy(frame + len, reg, reglen);
+    len += reglen;
+    memcpy(frame + len, data, datalen);
+    len += datalen;
+    p_spi->beginTransaction(settings);
+    digitalWrite(cs_pin, LOW);
+    p_spi->transfer(frame, len);
+    digitalWrite(cs_pin, HIGH);
+    p_spi->endTransaction();
+    return RESULT_OK;
+  }
+
+  error_t read(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+               int datalen) override {
+    if (p_spi == nullptr) return RESULT_FAIL;
+    p_spi->beginTransaction(settings);
+    digitalWrite(cs_pin, LOW);
+    p_spi->transfer((addr << 1) | 1);
+    for (int j = 0; j < reglen; j++) p_spi->transfer(reg[j]);
+    for (int j = 0; j < datalen; j++) data[j] = p_spi->transfer(0x00);
+    digitalWrite(cs_pin, HIGH);
+    p_spi->endTransaction();
+    return RESULT_OK;
+  }
+
+  /// Each register is written with its own frame (the device latches the
+  /// data with the rising edge of CS), but the bus is claimed only once
+  error_t writeSeq(int addr, const i2c_reg_value_t *seq, int count,
+                   bool autoIncrement) override {
+    if (p_spi == nullptr) return RESULT_FAIL;
+    uint8_t frame[3];
+    p_spi->beginTransaction(settings);
+    for (int j = 0; j < count; j++) {
+      frame[0] = addr << 1;
+      frame[1] = seq[j].reg;
+      frame[2] = seq[j].value;
+      digitalWrite(cs_pin, LOW);
+      p_spi->transfer(frame, 3);
+      digitalWrite(cs_pin, HIGH);
+    }
+    p_spi->endTransaction();
+    return RESULT_OK;
+  }
+
+  /// SPI has no acknowledge: we just check that the bus is defined
+  error_t check(int addr) override {
+    return p_spi != nullptr ? RESULT_OK : RESULT_FAIL;
+  }
+
+ protected:
+  SPIClass *p_spi = nullptr;
+  int cs_pin = -1;
+  SPISettings settings;
+};
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+/**
+ * @brief ControlBus for Linux using the i2c-dev interface (e.g. /dev/i2c-1)
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusI2CDev : public ControlBus {
+ public:
+  ControlBusI2CDev(const char *device = "/dev/i2c-1") { this->device = device; }
+  ~ControlBusI2CDev() { end(); }
+
+  bool begin() {
+    if (fd < 0) fd = open(device, O_RDWR);
+    if (fd < 0) AD_LOGE("Could not open %s", device);
+    return fd >= 0;
+  }
+
+  void end() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+  }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    uint8_t buffer[4 + I2C_MAX_BURST_LEN];
+    if (reglen > 4 || datalen > I2C_MAX_BURST_LEN) return RESULT_FAIL;
+    memcpy(buffer, reg, reglen);
+    memcpy(buffer + reglen, data, datalen);
+    struct i2c_msg msg = {(uint16_t)addr, 0, (uint16_t)(reglen + datalen),
+                          buffer};
+    return retry([&]() { return transfer(&msg, 1); });
+  }
+
+  error_t read(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+               int datalen) override {
+    // register address and data are combined with a repeated START
+    struct i2c_msg msgs[2] = {
+        {(uint16_t)addr, 0, (uint16_t)reglen, (uint8_t *)reg},
+        {(uint16_t)addr, I2C_M_RD, (uint16_t)datalen, data}};
+    return retry([&]() { return transfer(msgs, 2); });
+  }
+
+  error_t check(int addr) override {
+    struct i2c_msg msg = {(uint16_t)addr, 0, 0, nullptr};
+    return transfer(&msg, 1);
+  }
+
+  void delayMs(uint32_t ms) override { usleep(ms * 1000); }
+
+ protected:
+  const char *device;
+  int fd = -1;
+
+  error_t transfer(struct i2c_msg *msgs, int count) {
+    if (fd < 0 && !begin()) return RESULT_FAIL;
+    struct i2c_rdwr_ioctl_data data = {msgs, (uint32_t)count};
+    if (ioctl(fd, I2C_RDWR, &data) < 0) {
+      AD_LOGE("ioctl I2C_RDWR failed");
+      return RESULT_FAIL;
+    }
+    return RESULT_OK;
+  }
+};
+
+#endif
+
+/**
+ * @brief In memory ControlBus which simulates devices with 8 bit register
+ * addresses and auto-increment. It records the number of transactions and
+ * does not block on delays, so that it can be used for testing.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusMock : public ControlBus {
+ public:
+  /// Adds a simulated device which answers on the indicated address
+  void addDevice(int addr) {
+    Device dev;
+    dev.addr = addr;
+    memset(dev.regs, 0, sizeof(dev.regs));
+    devices.push_back(dev);
+  }
+
+  /// Provides access to the register image of a device
+  uint8_t *registers(int addr) {
+    Device *p_dev = getDevice(addr);
+    return p_dev == nullptr ? nullptr : p_dev->regs;
+  }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    write_count++;
+    Device *p_dev = getDevice(addr);
+    if (p_dev == nullptr) return RESULT_FAIL;
+    for (int j = 0; j < datalen; j++) {
+      uint8_t reg_j = reg[reglen - 1] + j;
+      p_dev->regs[reg_j] = data[j];
+      if (p_log != nullptr && log_count < log_max) {
+        p_log[log_count++] = {reg_j, data[j]};
+      }
+    }
+    return RESULT_OK;
+  }
+
+  error_t read(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+               int datalen) override {
+    read_count++;
+    Device *p_dev = getDevice(addr);
+    if (p_dev == nullptr) return RESULT_FAIL;
+    for (int j = 0; j < datalen; j++) {
+      data[j] = p_dev->regs[(uint8_t)(reg[reglen - 1] + j)];
+    }
+    return RESULT_OK;
+  }
+
+  error_t check(int addr) override {
+    return getDevice(addr) != nullptr ? RESULT_OK : RESULT_FAIL;
+  }
+
+  void delayMs(uint32_t ms) override { delay_ms += ms; }
+
+  /// Number of write transactions
+  uint32_t writeCount() { return write_count; }
+  /// Number of read transactions
+  uint32_t readCount() { return read_count; }
+  /// Sum of all requested delays in ms
+  uint32_t delayTotalMs() { return delay_ms; }
+  /// Resets the statistics
+  void resetCounters() {
+    write_count = 0;
+    read_count = 0;
+    delay_ms = 0;
+    log_count = 0;
+  }
+
+  /// Records the written registers and values in the sequence of the writes
+  /// into log (e.g. to check the order of a power down): writes beyond max
+  /// entries are not recorded
+  void setWriteLog(i2c_reg_value_t *log, int max) {
+    p_log = log;
+    log_max = max;
+    log_count = 0;
+  }
+  /// Number of recorded writes in the write log
+  int writeLogCount() { return log_count; }
+
+ protected:
+  struct Device {
+    int addr;
+    uint8_t regs[256];
+  };
+  audio_driver_local::Vector<Device> devices{0};
+  uint32_t write_count = 0;
+  uint32_t read_count = 0;
+  uint32_t delay_ms = 0;
+  i2c_reg_value_t *p_log = nullptr;
+  int log_max = 0;
+  int log_count = 0;
+
+  Device *getDevice(int addr) {
+    for (auto &dev : devices) {
+      if (dev.addr == addr) return &dev;
+    }
+    return nullptr;
+  }
+};
+
+/**
+ * @brief ControlBus which forwards the requests to another ControlBus but
+ * drops the writes which would not change the last value written to the
+ * (device, register). Only 8 bit register values are tracked: writes with
+ * longer register addresses or 16 bit values are always sent and clear the
+ * affected entries. The values of each device are kept in a RegisterMap.
+ * Call invalidate() after a reset of the device.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusShadow : public ControlBus {
+ public:
+  ControlBusShadow() = default;
+  ControlBusShadow(ControlBus &target) { setTarget(target); }
+
+  void setTarget(ControlBus &target) { p_target = &target; }
+
+  /// Deactivates the filter for a device (e.g. with 9 bit register values)
+  void setFilterActive(int addr, bool active) {
+    getDevice(addr)->is_active = active;
+  }
+
+  /// Activates or deactivates the filter for all devices: the written values
+  /// are tracked in any case
+  void setFilterActive(bool active) { is_filter = active; }
+
+  /// Provides the last written value: returns false if it is not known or
+  /// the register is volatile
+  bool getValue(int addr, uint8_t reg, uint8_t &value) {
+    Device *p_dev = getDevice(addr);
+    if (!p_dev->regs.isValid(reg)) return false;
+    value = p_dev->regs.get(reg);
+    return true;
+  }
+
+  /// Defines the value of a register (e.g. read from the chip)
+  void setValue(int addr, uint8_t reg, uint8_t value) {
+    update(getDevice(addr), reg, value);
+  }
+
+  /// Always sends the writes to the indicated register (e.g. self clearing
+  /// bits or status registers)
+  void setVolatile(int addr, uint8_t reg) {
+    getDevice(addr)->regs.setVolatile(reg);
+  }
+
+  /// Defines a page or book select register: the image of the device only
+  /// describes the selected page, so it is forgotten when the selection
+  /// changes
+  void setPageRegister(int addr, uint8_t reg) {
+    Device *p_dev = getDevice(addr);
+    setBit(p_dev->page_bits, reg, true);
+  }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    Device *p_dev = getDevice(addr);
+    if (reglen == 1 && datalen == 1 && isUnchanged(p_dev, reg[0], data[0])) {
+      suppressed_count++;
+      return RESULT_OK;
+    }
+    error_t rc = p_target->write(addr, reg, reglen, data, datalen, stop);
+    if (reglen == 1 && datalen == 1 && rc == RESULT_OK) {
+      update(p_dev, reg[0], data[0]);
+    } else {
+      // we can not track this: forget the affected registers
+      for (int j = 0; j < datalen; j++) {
+        forget(p_dev, reg[reglen - 1] + j);
+      }
+    }
+    return rc;
+  }
+
+  error_t writeSeq(int addr, const i2c_reg_value_t *seq, int count,
+                   bool autoIncrement) override {
+    Device *p_dev = getDevice(addr);
+    // remove the unchanged entries and send the rest in bursts
+    i2c_reg_value_t changed[I2C_MAX_BURST_LEN];
+    int result = RESULT_OK;
+    int len = 0;
+    for (int j = 0; j < count; j++) {
+      if (isUnchanged(p_dev, seq[j].reg, seq[j].value)) {
+        suppressed_count++;
+        continue;
+      }
+      changed[len++] = seq[j];
+      // the following entries need to be compared with the new page
+      if (len == I2C_MAX_BURST_LEN || j == count - 1 ||
+          getBit(p_dev->page_bits, seq[j].reg)) {
+        if (flush(addr, p_dev, changed, len, autoIncrement) != RESULT_OK)
+          result = RESULT_FAIL;
+        len = 0;
+      }
+    }
+    if (len > 0 && flush(addr, p_dev, changed, len, autoIncrement) != RESULT_OK)
+      result = RESULT_FAIL;
+    return result;
+  }
+
+  error_t read(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+               int datalen) override {
+    return p_target->read(addr, reg, reglen, data, datalen);
+  }
+
+  error_t check(int addr) override { return p_target->check(addr); }
+
+  void delayMs(uint32_t ms) override { p_target->delayMs(ms); }
+
+  void invalidate(int addr = -1) override {
+    for (auto &dev : devices) {
+      if (addr == -1 || dev.addr == addr) dev.regs.invalidate();
+    }
+    if (p_target != nullptr) p_target->invalidate(addr);
+  }
+
+  /// Number of writes which were not sent because nothing would change
+  uint32_t suppressedWrites() { return suppressed_count; }
+
+  void resetSuppressedWrites() { suppressed_count = 0; }
+
+ protected:
+  struct Device {
+    int addr;
+    bool is_active;
+    RegisterMap<256> regs;
+    uint8_t page_bits[32];
+  };
+  ControlBus *p_target = nullptr;
+  audio_driver_local::Vector<Device> devices{0};
+  uint32_t suppressed_count = 0;
+  bool is_filter = true;
+
+  Device *getDevice(int addr) {
+    for (auto &dev : devices) {
+      if (dev.addr == addr) return &dev;
+    }
+    Device dev;
+    dev.addr = addr;
+    dev.is_active = true;
+    memset(dev.page_bits, 0, sizeof(dev.page_bits));
+    devices.push_back(dev);
+    return &devices[devices.size() - 1];
+  }
+
+  bool isUnchanged(Device *p_dev, uint8_t reg, uint8_t value) {
+    return is_filter && p_dev->is_active && p_dev->regs.isValid(reg) &&
+           p_dev->regs.get(reg) == value;
+  }
+
+  void update(Device *p_dev, uint8_t reg, uint8_t value) {
+    if (getBit(p_dev->page_bits, reg) &&
+        (!p_dev->regs.isValid(reg) || p_dev->regs.get(reg) != value)) {
+      // another page has been selected
+      p_dev->regs.invalidate();
+    }
+    p_dev->regs.store(reg, value);
+  }
+
+  /// The value on the chip is not known any more
+  void forget(Device *p_dev, uint8_t reg) {
+    if (getBit(p_dev->page_bits, reg)) {
+      // we do not know which page is selected
+      p_dev->regs.invalidate();
+    }
+    p_dev->regs.forget(reg);
+  }
+
+  error_t flush(int addr, Device *p_dev, const i2c_reg_value_t *seq, int len,
+                bool autoIncrement) {
+    error_t rc = p_target->writeSeq(addr, seq, len, autoIncrement);
+    for (int j = 0; j < len; j++) {
+      if (rc == RESULT_OK) {
+        update(p_dev, seq[j].reg, seq[j].value);
+      } else {
+        forget(p_dev, seq[j].reg);
+      }
+    }
+    return rc;
+  }
+
+  static bool getBit(const uint8_t *bits, uint8_t idx) {
+    return bits[idx >> 3] & (1 << (idx & 7));
+  }
+
+  static void setBit(uint8_t *bits, uint8_t idx, bool value) {
+    if (value)
+      bits[idx >> 3] |= (1 << (idx & 7));
+    else
+      bits[idx >> 3] &= ~(1 << (idx & 7));
+  }
+};
+
+/**
+ * @brief ControlBusMock for a single device which records the sequence of
+ * the last write to each register: used to determine the register values
+ * which a configuration sequence would produce without touching the chip.
+ * Requests to other addresses fail.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusRecorder : public ControlBusMock {
+ public:
+  ControlBusRecorder(int addr) {
+    device_addr = addr;
+    addDevice(addr);
+    memset(order, 0, sizeof(order));
+  }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    error_t rc = ControlBusMock::write(addr, reg, reglen, data, datalen, stop);
+    if (rc == RESULT_OK) {
+      for (int j = 0; j < datalen; j++) {
+        order[(uint8_t)(reg[reglen - 1] + j)] = ++write_seq;
+      }
+    }
+    return rc;
+  }
+
+  /// Position of the last write to the register in the recorded sequence
+  /// (0: not written)
+  uint16_t writeOrder(uint8_t reg) { return order[reg]; }
+
+  /// Provides the register image of the device
+  uint8_t *registers() { return ControlBusMock::registers(device_addr); }
+
+ protected:
+  int device_addr;
+  uint16_t order[256];
+  uint16_t write_seq = 0;
+};
+
+/**
+ * @brief ControlBus which forwards all requests to a target that can be
+ * replaced at any time: so the drivers can keep their bus handle while the
+ * transport is switched (e.g. to a ControlBusRecorder)
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ControlBusProxy : public ControlBus {
+ public:
+  void setTarget(ControlBus &target) { p_target = &target; }
+
+  error_t write(int addr, const uint8_t *reg, int reglen, const uint8_t *data,
+                int datalen, bool stop = true) override {
+    return p_target->write(addr, reg, reglen, data, datalen, stop);
+  }
+
+  error_t read(int addr, const uint8_t *reg, int reglen, uint8_t *data,
+               int datalen) override {
+    return p_target->read(addr, reg, reglen, data, datalen);
+  }
+
+  error_t check(int addr) override { return p_target->check(addr); }
+
+  error_t writeSeq(int addr, const i2c_reg_value_t *seq, int count,
+                   bool autoIncrement) override {
+    return p_target->writeSeq(addr, seq, count, autoIncrement);
+  }
+
+  void delayMs(uint32_t ms) override { p_target->delayMs(ms); }
+
+  void invalidate(int addr = -1) override {
+    if (p_target != nullptr) p_target->invalidate(addr);
+  }
+
+  bool recover() override { return p_target->recover(); }
+
+ protected:
+  ControlBus *p_target = nullptr;
+};
+
+}  // namespace audio_driver
@@ -1,7 +1,18 @@
-#include <Wire.h>
 #include <assert.h>
 #include <stdio.h>
 #include "Utils/I2C.h"
+#include "Utils/ControlBus.h"
+#include "Utils/RegisterMap.h"
+
+/// Register map of a device which is used by the C drivers
+struct i2c_reg_map {
+  i2c_bus_handle_t bus;
+  int addr;
+  audio_driver::RegisterMap<I2C_REG_CACHE_SIZE, 16> regs;
+};
+
+static i2c_reg_map i2c_reg_maps[I2C_REG_MAP_COUNT];
+static int i2c_reg_map_count = 0;
 
 // this method is used !
 error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
@@ -9,33 +20,17 @@ error_t i2c_bus_write_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
   AD_LOGD(
       "i2c_bus_write_bytes: addr=0x%X reglen=%d datalen=%d - reg=0x%0X value=0x%0X",
       addr, reglen, datalen, reg[0], data[0]);
-  TwoWire *p_wire = (TwoWire *)bus;
-  assert(p_wire!=nullptr);
-  int result = RESULT_OK;
-  p_wire->beginTransmission(addr);
-  p_wire->write(reg, reglen);
-  p_wire->write(data, datalen);
-  int rc = p_wire->endTransmission(I2C_END);
-  if (rc != 0) {
-    AD_LOGE("->p_wire->endTransmission: %d", rc);
-    result = RESULT_FAIL;
-  }
-  return result;
+  ControlBus *p_bus = (ControlBus *)bus;
+  assert(p_bus != nullptr);
+  return p_bus->write(addr, reg, reglen, data, datalen, I2C_END);
 }
 
 // this method is used !
 error_t i2c_bus_check(i2c_bus_handle_t bus, int addr) {
   AD_LOGD("i2c_bus_check: addr=0x%X",addr);
-  TwoWire *p_wire = (TwoWire *)bus;
-  assert(p_wire!=nullptr);
-  int result = RESULT_OK;
-  p_wire->beginTransmission(addr); 
-  int rc = p_wire->endTransmission(I2C_END);
-  if (rc != 0) {
-    AD_LOGE("->p_wire->endTransmission: %d", rc);
-    result = RESULT_FAIL;
-  }
-  return result;
+  ControlBus *p_bus = (ControlBus *)bus;
+  assert(p_bus != nullptr);
+  return p_bus->check(addr);
 }
 
 
@@ -44,26 +39,282 @@ error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg,
                              int reglen, uint8_t *outdata, int datalen) {
   AD_LOGD("i2c_bus_read_bytes: addr=%d reglen=%d datalen=%d - reg=%d", addr,
            reglen, datalen, reg[0]);
-  TwoWire *p_wire = (TwoWire *)bus;
-  assert(reglen == 1);
-  assert(p_wire!=nullptr);
+  ControlBus *p_bus = (ControlBus *)bus;
+  assert(reglen > 0);
+  assert(p_bus != nullptr);
+  memset(outdata, 0, datalen);
+  return p_bus->read(addr, reg, reglen, outdata, datalen);
+}
+
+// this method is used !
+error_t i2c_bus_write_seq(i2c_bus_handle_t bus, int addr,
+                          const i2c_reg_value_t *seq, int count,
+                          bool autoIncrement) {
+  AD_LOGD("i2c_bus_write_seq: addr=0x%X count=%d", addr, count);
+  ControlBus *p_bus = (ControlBus *)bus;
+  assert(p_bus != nullptr);
+  return p_bus->writeSeq(addr, seq, count, autoIncrement);
+}
 
-  memset(outdata,0,datalen);
+// this method is used !
+void i2c_bus_delay(i2c_bus_handle_t bus, uint32_t ms) {
+  ControlBus *p_bus = (ControlBus *)bus;
+  if (p_bus != nullptr) {
+    p_bus->delayMs(ms);
+  } else {
+    delay(ms);
+  }
+}
+
+// this method is used !
+error_t i2c_bus_read_regs(i2c_bus_handle_t bus, int addr, uint8_t reg,
+                          uint8_t *outdata, int count, bool autoIncrement) {
   int result = RESULT_OK;
+  int pos = 0;
+  while (pos < count) {
+    // split into chunks which fit into the Wire buffer
+    int len = autoIncrement ? count - pos : 1;
+    if (len > I2C_MAX_READ_LEN) len = I2C_MAX_READ_LEN;
+    uint8_t reg_addr = reg + pos;
+    if (i2c_bus_read_bytes(bus, addr, &reg_addr, 1, outdata + pos, len) !=
+        RESULT_OK) {
+      result = RESULT_FAIL;
+    }
+    pos += len;
+  }
+  return result;
+}
+
+error_t i2c_bus_update_reg(i2c_bus_handle_t bus, int addr, uint8_t reg,
+                           uint8_t mask, uint8_t value) {
+  return i2c_bus_update_reg_cached(bus, addr, nullptr, reg, mask, value);
+}
+
+static bool i2c_reg_map_is_valid(i2c_reg_map_t *map, uint8_t reg) {
+  return map != nullptr && map->regs.isValid(reg);
+}
+
+bool i2c_reg_map_lookup(i2c_reg_map_t *map, uint8_t reg, uint16_t *value) {
+  if (!i2c_reg_map_is_valid(map, reg)) return false;
+  *value = map->regs.get(reg);
+  return true;
+}
+
+void i2c_reg_map_store(i2c_reg_map_t *map, uint8_t reg, uint16_t value) {
+  if (map != nullptr) map->regs.store(reg, value);
+}
+
+void i2c_reg_map_forget(i2c_reg_map_t *map, uint8_t reg) {
+  if (map != nullptr) map->regs.forget(reg);
+}
 
-  p_wire->beginTransmission(addr);
-  p_wire->write(reg, reglen);
-  int rc = p_wire->endTransmission();
-  if (rc != 0) {
-    AD_LOGE("->p_wire->endTransmission: %d", rc);
+i2c_reg_map_t *i2c_reg_map_get(i2c_bus_handle_t bus, int addr) {
+  i2c_reg_map_t *free_map = nullptr;
+  for (int j = 0; j < i2c_reg_map_count; j++) {
+    i2c_reg_map_t &map = i2c_reg_maps[j];
+    if (map.bus == bus && map.addr == addr) return &map;
+    // reuse the first released entry
+    if (map.bus == nullptr && free_map == nullptr) free_map = &map;
   }
+  if (free_map == nullptr) {
+    if (i2c_reg_map_count >= I2C_REG_MAP_COUNT) {
+      AD_LOGW("i2c_reg_map_get: no register map for 0x%X", addr);
+      return nullptr;
+    }
+    free_map = &i2c_reg_maps[i2c_reg_map_count++];
+  }
+  free_map->bus = bus;
+  free_map->addr = addr;
+  free_map->regs.invalidate();
+  return free_map;
+}
+
+void i2c_reg_map_release(i2c_reg_map_t *map) {
+  if (map == nullptr) return;
+  map->bus = nullptr;
+  map->addr = -1;
+  // the volatile definitions belong to the old device
+  for (int reg = 0; reg < I2C_REG_CACHE_SIZE; reg++)
+    map->regs.setVolatile(reg, false);
+  map->regs.invalidate();
+}
+
+void i2c_reg_map_invalidate(i2c_reg_map_t *map) {
+  if (map != nullptr) map->regs.invalidate();
+}
+
+void i2c_reg_map_set_volatile(i2c_reg_map_t *map, uint8_t reg) {
+  if (map != nullptr) map->regs.setVolatile(reg);
+}
 
-  uint8_t result_len = p_wire->requestFrom((addr), datalen, I2C_END);
-  if (result_len > 0) {
-    result_len = p_wire->readBytes(outdata, datalen);
+void i2c_reg_map_invalidate_bus(i2c_bus_handle_t bus) {
+  for (int j = 0; j < i2c_reg_map_count; j++) {
+    if (i2c_reg_maps[j].bus == bus) i2c_reg_maps[j].regs.invalidate();
+  }
+}
+
+error_t i2c_bus_read_reg_cached(i2c_bus_handle_t bus, int addr,
+                                i2c_reg_map_t *map, uint8_t reg,
+                                uint8_t *value) {
+  if (i2c_reg_map_is_valid(map, reg)) {
+    *value = (uint8_t)map->regs.get(reg);
+    return RESULT_OK;
+  }
+  error_t rc = i2c_bus_read_regs(bus, addr, reg, value, 1, false);
+  if (rc == RESULT_OK) i2c_reg_map_store(map, reg, *value);
+  return rc;
+}
+
+error_t i2c_bus_write_reg_cached(i2c_bus_handle_t bus, int addr,
+                                 i2c_reg_map_t *map, uint8_t reg,
+                                 uint8_t value) {
+  error_t rc = i2c_bus_write_bytes(bus, addr, &reg, 1, &value, 1);
+  // after a failed write we do not know the value on the chip
+  if (rc == RESULT_OK) {
+    i2c_reg_map_store(map, reg, value);
   } else {
-    AD_LOGE("->p_wire->requestFrom %d->%d", datalen, result_len);
-    result = RESULT_FAIL;
+    i2c_reg_map_forget(map, reg);
   }
-  return result;
+  return rc;
+}
+
+error_t i2c_bus_update_reg_cached(i2c_bus_handle_t bus, int addr,
+                                  i2c_reg_map_t *map, uint8_t reg,
+                                  uint8_t mask, uint8_t value) {
+  uint8_t reg_value = 0;
+  if (i2c_bus_read_reg_cached(bus, addr, map, reg, &reg_value) != RESULT_OK)
+    return RESULT_FAIL;
+  // reg_value is either known from the map or has just been read
+  uint8_t new_value = (reg_value & ~mask) | (value & mask);
+  if (new_value == reg_value) return RESULT_OK;
+  return i2c_bus_write_reg_cached(bus, addr, map, reg, new_value);
+}
+
+error_t i2c_bus_write_seq_cached(i2c_bus_handle_t bus, int addr,
+                                 i2c_reg_map_t *map,
+                                 const i2c_reg_value_t *seq, int count,
+                                 bool autoIncrement) {
+  error_t rc = i2c_bus_write_seq(bus, addr, seq, count, autoIncrement);
+  for (int j = 0; j < count; j++) {
+    // we do not know which entries failed
+    if (rc == RESULT_OK) {
+      i2c_reg_map_store(map, seq[j].reg, seq[j].value);
+    } else {
+      i2c_reg_map_forget(map, seq[j].reg);
+    }
+  }
+  return rc;
+}
+
+static error_t i2c_seq_flush(i2c_bus_handle_t bus, int addr,
+                             i2c_reg_map_t *map, i2c_reg_value_t *batch,
+                             int &len, bool autoIncrement) {
+  if (len == 0) return RESULT_OK;
+  error_t rc =
+      i2c_bus_write_seq_cached(bus, addr, map, batch, len, autoIncrement);
+  len = 0;
+  return rc;
+}
+
+error_t i2c_bus_run_seq(i2c_bus_handle_t bus, int addr, i2c_reg_map_t *map,
+                        const i2c_seq_t *seq, int count, bool autoIncrement) {
+  AD_LOGD("i2c_bus_run_seq: addr=0x%X count=%d", addr, count);
+  i2c_reg_value_t batch[I2C_SEQ_BATCH_SIZE];
+  int len = 0;
+  int burst = 0;  // open writes of an I2C_SEQ_BURST
+  int last_reg = -1;  // last register which was read from the bus
+  uint8_t last_value = 0;
+  bool ok = true;
+  for (int j = 0; j < count && seq[j].op != I2C_SEQ_END; j++) {
+    const i2c_seq_t &entry = seq[j];
+    // writes are collected: everything else needs the pending writes first
+    if (entry.op != I2C_SEQ_WRITE && entry.op != I2C_SEQ_UPDATE) {
+      ok = i2c_seq_flush(bus, addr, map, batch, len, autoIncrement) ==
+               RESULT_OK && ok;
+    }
+    switch (entry.op) {
+      case I2C_SEQ_WRITE:
+        if (len == I2C_SEQ_BATCH_SIZE) {
+          ok = i2c_seq_flush(bus, addr, map, batch, len,
+                             autoIncrement || burst > 0) == RESULT_OK && ok;
+        }
+        batch[len].reg = entry.reg;
+        batch[len].value = entry.value;
+        len++;
+        if (last_reg == entry.reg) last_value = entry.value;
+        if (burst > 0 && --burst == 0) {
+          ok = i2c_seq_flush(bus, addr, map, batch, len, true) ==
+                   RESULT_OK && ok;
+        }
+        break;
+
+      case I2C_SEQ_UPDATE: {
+        // the last collected write or the map provide the current value
+        int pos = len - 1;
+        while (pos >= 0 && batch[pos].reg != entry.reg) pos--;
+        uint8_t value = 0;
+        if (pos >= 0) {
+          value = batch[pos].value;
+        } else if (last_reg == entry.reg) {
+          value = last_value;
+        } else if (i2c_reg_map_is_valid(map, entry.reg)) {
+          value = (uint8_t)map->regs.get(entry.reg);
+        } else {
+          ok = i2c_seq_flush(bus, addr, map, batch, len, autoIncrement) ==
+                   RESULT_OK && ok;
+          uint8_t reg = entry.reg;
+          if (i2c_bus_read_bytes(bus, addr, &reg, 1, &value, 1) != RESULT_OK) {
+            ok = false;
+            break;
+          }
+          i2c_reg_map_store(map, entry.reg, value);
+          last_reg = entry.reg;
+          last_value = value;
+        }
+        uint8_t new_value = (value & ~entry.mask) | (entry.value & entry.mask);
+        if (new_value == value) break;
+        if (len == I2C_SEQ_BATCH_SIZE) {
+          ok = i2c_seq_flush(bus, addr, map, batch, len, autoIncrement) ==
+                   RESULT_OK && ok;
+        }
+        batch[len].reg = entry.reg;
+        batch[len].value = new_value;
+        len++;
+        if (last_reg == entry.reg) last_value = new_value;
+      } break;
+
+      case I2C_SEQ_DELAY:
+        i2c_bus_delay(bus, entry.value | (entry.mask << 8));
+        break;
+
+      case I2C_SEQ_POLL: {
+        uint8_t reg = entry.reg;
+        uint8_t value = 0;
+        int ms = 0;
+        while (true) {
+          if (i2c_bus_read_bytes(bus, addr, &reg, 1, &value, 1) == RESULT_OK &&
+              (value & entry.mask) == (entry.value & entry.mask))
+            break;
+          if (ms++ >= I2C_SEQ_POLL_TIMEOUT_MS) {
+            AD_LOGE("i2c_bus_run_seq: timeout for reg 0x%X", reg);
+            ok = false;
+            break;
+          }
+          i2c_bus_delay(bus, 1);
+        }
+      } break;
+
+      case I2C_SEQ_BURST:
+        burst = entry.value;
+        break;
+
+      default:
+        AD_LOGE("i2c_bus_run_seq: invalid op %d", entry.op);
+        ok = false;
+        break;
+    }
+  }
+  ok = i2c_seq_flush(bus, addr, map, batch, len, autoIncrement || burst > 0) ==
+           RESULT_OK && ok;
+  return ok ? RESULT_OK : RESULT_FAIL;
 }
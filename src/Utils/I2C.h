@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 #include "DriverCommon.h"
 
 
@@ -38,7 +39,10 @@ error_t i2c_bus_check(i2c_bus_handle_t bus, int addr);
 
 
 /**
- * @brief Read bytes to I2C bus
+ * @brief Read bytes from I2C bus: the register address (reglen bytes, MSB
+ * first) is written followed by a repeated START and the read of datalen
+ * bytes in one transaction. So a block of consecutive registers can be read
+ * with one call if the device supports auto-increment.
  *
  * @param bus        I2C bus handle
  * @param addr       The address of the device
@@ -48,11 +52,276 @@ error_t i2c_bus_check(i2c_bus_handle_t bus, int addr);
  * @param datalen        The length of outdata
  *
  * @return
- *     - NULL Fail
- *     - Others Success
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL less than datalen bytes were received
  */
 error_t i2c_bus_read_bytes(i2c_bus_handle_t bus, int addr, uint8_t *reg, int reglen, uint8_t *outdata, int datalen);
 
+/**
+ * @brief Reads count consecutive 8 bit registers starting at reg: with
+ * autoIncrement this is done with i2c_bus_read_bytes() in chunks of
+ * I2C_MAX_READ_LEN bytes, otherwise each register is read individually.
+ *
+ * @param bus           I2C bus handle
+ * @param addr          The address of the device
+ * @param reg           The first register
+ * @param outdata       The outdata pointer (count bytes)
+ * @param count         The number of registers
+ * @param autoIncrement true if the device supports register auto-increment
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL Error
+ */
+error_t i2c_bus_read_regs(i2c_bus_handle_t bus, int addr, uint8_t reg, uint8_t *outdata, int count, bool autoIncrement);
+
+/**
+ * @brief Read-modify-write of the bits in mask of an 8 bit register: the
+ * register is read with i2c_bus_read_regs() and only written if the value
+ * changes. Nothing is written if the read fails.
+ *
+ * @param bus        I2C bus handle
+ * @param addr       The address of the device
+ * @param reg        The register
+ * @param mask       The bits to be updated
+ * @param value      The new value of the bits
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL Error
+ */
+error_t i2c_bus_update_reg(i2c_bus_handle_t bus, int addr, uint8_t reg, uint8_t mask, uint8_t value);
+
+/**
+ * @brief Register/value pair used by i2c_bus_write_seq()
+ */
+typedef struct {
+  uint8_t reg;   /*!< 8 bit register address */
+  uint8_t value; /*!< value to be written */
+} i2c_reg_value_t;
+
+/**
+ * @brief Writes a sequence of register values with a minimum number of bus
+ * transactions: runs of consecutive register addresses are sent as one
+ * auto-increment transfer (if supported by the device) and each run ends
+ * with a STOP. The write order is preserved.
+ *
+ * @param bus           I2C bus handle
+ * @param addr          The address of the device
+ * @param seq           The register/value pairs
+ * @param count         The number of entries in seq
+ * @param autoIncrement true if the device supports register auto-increment
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL at least one transaction failed
+ */
+error_t i2c_bus_write_seq(i2c_bus_handle_t bus, int addr, const i2c_reg_value_t *seq, int count, bool autoIncrement);
+
+/**
+ * @brief Write-through image of the registers 0 to I2C_REG_CACHE_SIZE-1 of a
+ * device for the C drivers: it is a RegisterMap with up to 16 bit values, so
+ * values which have been read or written are remembered and read-modify-write
+ * updates do not need to read the register from the bus. Registers which can
+ * change on the chip must be marked as volatile. The map is write-through: the
+ * dirty marking and flush() of the RegisterMap are not used here. The drivers
+ * which have not been ported (e.g. ES8156, ES7243, CS43L22, WM8994, AD1938)
+ * access the bus directly.
+ */
+typedef struct i2c_reg_map i2c_reg_map_t;
+
+/**
+ * @brief Provides the register map of a device: the maps are taken from a
+ * fixed pool of I2C_REG_MAP_COUNT entries. The same bus and address give the
+ * same map and released maps are reused.
+ *
+ * @param bus        I2C bus handle
+ * @param addr       The address of the device
+ *
+ * @return The register map or NULL if the pool is used up: the cached
+ * functions access the bus directly in this case
+ */
+i2c_reg_map_t *i2c_reg_map_get(i2c_bus_handle_t bus, int addr);
+
+/**
+ * @brief Returns the register map to the pool: e.g. in the deinit of the
+ * driver or before the driver requests a map for a new bus
+ *
+ * @param map        The register map (NULL is ignored)
+ */
+void i2c_reg_map_release(i2c_reg_map_t *map);
+
+/**
+ * @brief Forgets all cached values (e.g. after a reset of the chip): the
+ * volatile register definitions are kept
+ *
+ * @param map        The register map
+ */
+void i2c_reg_map_invalidate(i2c_reg_map_t *map);
+
+/**
+ * @brief Defines a register which can change on the chip: it is never served
+ * from the map
+ *
+ * @param map        The register map
+ * @param reg        The register
+ */
+void i2c_reg_map_set_volatile(i2c_reg_map_t *map, uint8_t reg);
+
+/**
+ * @brief Forgets the cached values of all devices on the bus: e.g. if the
+ * registers have been written without the driver
+ *
+ * @param bus        I2C bus handle
+ */
+void i2c_reg_map_invalidate_bus(i2c_bus_handle_t bus);
+
+/**
+ * @brief Provides the cached value of a register (for drivers with their own
+ * register format)
+ *
+ * @param map        The register map
+ * @param reg        The register
+ * @param value      The cached value
+ *
+ * @return true if the value is known and the register is not volatile
+ */
+bool i2c_reg_map_lookup(i2c_reg_map_t *map, uint8_t reg, uint16_t *value);
+
+/**
+ * @brief Records a value which has been read from or written to the chip
+ *
+ * @param map        The register map
+ * @param reg        The register
+ * @param value      The value
+ */
+void i2c_reg_map_store(i2c_reg_map_t *map, uint8_t reg, uint16_t value);
+
+/**
+ * @brief Forgets the value of a register: e.g. after a failed write
+ *
+ * @param map        The register map
+ * @param reg        The register
+ */
+void i2c_reg_map_forget(i2c_reg_map_t *map, uint8_t reg);
+
+/**
+ * @brief Reads an 8 bit register: a known value is taken from the map,
+ * otherwise it is read from the bus and stored in the map
+ *
+ * @param bus        I2C bus handle
+ * @param addr       The address of the device
+ * @param map        The register map
+ * @param reg        The register
+ * @param value      The value read
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL Error
+ */
+error_t i2c_bus_read_reg_cached(i2c_bus_handle_t bus, int addr, i2c_reg_map_t *map, uint8_t reg, uint8_t *value);
+
+/**
+ * @brief Writes an 8 bit register and records the value in the map
+ *
+ * @param bus        I2C bus handle
+ * @param addr       The address of the device
+ * @param map        The register map
+ * @param reg        The register
+ * @param value      The value to be written
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL Error
+ */
+error_t i2c_bus_write_reg_cached(i2c_bus_handle_t bus, int addr, i2c_reg_map_t *map, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Read-modify-write of the bits in mask: the current value is taken
+ * from the map and the register is only written if the value changes
+ *
+ * @param bus        I2C bus handle
+ * @param addr       The address of the device
+ * @param map        The register map
+ * @param reg        The register
+ * @param mask       The bits to be updated
+ * @param value      The new value of the bits
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL Error
+ */
+error_t i2c_bus_update_reg_cached(i2c_bus_handle_t bus, int addr, i2c_reg_map_t *map, uint8_t reg, uint8_t mask, uint8_t value);
+
+/**
+ * @brief i2c_bus_write_seq() which records the written values in the map
+ *
+ * @param bus           I2C bus handle
+ * @param addr          The address of the device
+ * @param map           The register map
+ * @param seq           The register/value pairs
+ * @param count         The number of entries in seq
+ * @param autoIncrement true if the device supports register auto-increment
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL at least one transaction failed
+ */
+error_t i2c_bus_write_seq_cached(i2c_bus_handle_t bus, int addr, i2c_reg_map_t *map, const i2c_reg_value_t *seq, int count, bool autoIncrement);
+
+/**
+ * @brief Operations of a register sequence which is executed by
+ * i2c_bus_run_seq()
+ */
+typedef enum {
+  I2C_SEQ_END = 0, /*!< end of the sequence (optional) */
+  I2C_SEQ_WRITE,   /*!< writes value to reg */
+  I2C_SEQ_UPDATE,  /*!< read-modify-write of the bits in mask with value */
+  I2C_SEQ_DELAY,   /*!< waits for value + 256 * mask milliseconds */
+  I2C_SEQ_POLL,    /*!< waits until (reg & mask) == value */
+  I2C_SEQ_BURST,   /*!< the next value writes are sent with auto-increment */
+} i2c_seq_op_t;
+
+/**
+ * @brief Entry of a register sequence: the drivers define their init, start,
+ * stop and power sequences as const tables of these entries
+ */
+typedef struct {
+  uint8_t op;    /*!< i2c_seq_op_t */
+  uint8_t reg;   /*!< 8 bit register address */
+  uint8_t value; /*!< value (I2C_SEQ_BURST: number of writes) */
+  uint8_t mask;  /*!< bits which are updated or polled */
+} i2c_seq_t;
+
+/**
+ * @brief Executes a register sequence: consecutive writes are collected and
+ * sent with i2c_bus_write_seq(), so that runs of consecutive registers need
+ * only one transfer. Updates are calculated from the collected writes or the
+ * register map, so they only read the register from the bus if its value is
+ * not known. Updates which do not change the value are dropped.
+ *
+ * @param bus           I2C bus handle
+ * @param addr          The address of the device
+ * @param map           The register map (can be NULL)
+ * @param seq           The sequence
+ * @param count         The number of entries in seq
+ * @param autoIncrement true if the device supports register auto-increment
+ *
+ * @return
+ *     - RESULT_OK Success
+ *     - RESULT_FAIL at least one operation failed or a poll timed out
+ */
+error_t i2c_bus_run_seq(i2c_bus_handle_t bus, int addr, i2c_reg_map_t *map, const i2c_seq_t *seq, int count, bool autoIncrement);
+
+/**
+ * @brief Waits for the indicated number of milliseconds using the delay
+ * implementation of the bus (e.g. a simulated bus does not block)
+ *
+ * @param bus        I2C bus handle
+ * @param ms         The delay in milliseconds
+ */
+void i2c_bus_delay(i2c_bus_handle_t bus, uint32_t ms);
+
 
 #ifdef __cplusplus
 }
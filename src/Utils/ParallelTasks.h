@@ -0,0 +1,108 @@
+#pragma once
+#include "DriverCommon.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#  include "freertos/FreeRTOS.h"
+#  include "freertos/semphr.h"
+#  include "freertos/task.h"
+#  define PARALLEL_TASKS_FREERTOS
+#elif !defined(ARDUINO)
+#  include <thread>
+#  define PARALLEL_TASKS_STD_THREAD
+#endif
+
+namespace audio_driver {
+
+/**
+ * @brief Executes some functions concurrently and waits until all of them
+ * have completed: On the ESP32 we use FreeRTOS tasks, on the desktop
+ * std::threads. On all other platforms the functions are executed one after
+ * the other. The first function is always executed by the calling task.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+class ParallelTasks {
+ public:
+  typedef bool (*task_function_t)(void *ref);
+
+  /// Adds a function: returns false if there is no space left
+  bool add(task_function_t func, void *ref) {
+    if (count >= PARALLEL_MAX_TASKS) return false;
+    entries[count].func = func;
+    entries[count].ref = ref;
+    entries[count].result = false;
+    count++;
+    return true;
+  }
+
+  /// Runs all functions and waits for their completion: returns true if all
+  /// of them have succeeded
+  bool run() {
+#if defined(PARALLEL_TASKS_FREERTOS)
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(count, 0);
+    int started = 0;
+    for (int j = 1; j < count; j++) {
+      entries[j].done = done;
+      if (xTaskCreate(task, "audio-init", PARALLEL_TASK_STACK_SIZE,
+                      &entries[j], ASYNC_TASK_PRIORITY, nullptr) == pdPASS) {
+        started++;
+      } else {
+        // no resources: execute it in the calling task
+        execute(entries[j]);
+      }
+    }
+    if (count > 0) execute(entries[0]);
+    for (int j = 0; j < started; j++) {
+      xSemaphoreTake(done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(done);
+#elif defined(PARALLEL_TASKS_STD_THREAD)
+    std::thread threads[PARALLEL_MAX_TASKS];
+    for (int j = 1; j < count; j++) {
+      threads[j] = std::thread(execute, std::ref(entries[j]));
+    }
+    if (count > 0) execute(entries[0]);
+    for (int j = 1; j < count; j++) {
+      threads[j].join();
+    }
+#else
+    for (int j = 0; j < count; j++) {
+      execute(entries[j]);
+    }
+#endif
+    bool result = true;
+    for (int j = 0; j < count; j++) {
+      result = result && entries[j].result;
+    }
+    return result;
+  }
+
+  /// Removes all functions
+  void clear() { count = 0; }
+
+ protected:
+  struct Entry {
+    task_function_t func;
+    void *ref;
+    bool result;
+#if defined(PARALLEL_TASKS_FREERTOS)
+    SemaphoreHandle_t done;
+#endif
+  };
+  Entry entries[PARALLEL_MAX_TASKS];
+  int count = 0;
+
+  static void execute(Entry &entry) { entry.result = entry.func(entry.ref); }
+
+#if defined(PARALLEL_TASKS_FREERTOS)
+  static void task(void *ref) {
+    Entry *p_entry = (Entry *)ref;
+    execute(*p_entry);
+    xSemaphoreGive(p_entry->done);
+    vTaskDelete(nullptr);
+  }
+#endif
+};
+
+}  // namespace audio_driver
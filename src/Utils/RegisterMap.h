@@ -0,0 +1,169 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+namespace audio_driver {
+
+/// Value type of a RegisterMap: 8 bit registers are stored in a uint8_t
+template <bool IsWide>
+struct RegisterMapValue {
+  typedef uint8_t type;
+};
+template <>
+struct RegisterMapValue<true> {
+  typedef uint16_t type;
+};
+
+/**
+ * @brief Local image of the Count registers of a codec with values of Width
+ * bits. For each register we track if the value is known (valid), if it
+ * still needs to be written to the chip (dirty) and if it can change on the
+ * chip (volatile): volatile registers are never served from the cache and
+ * are always written. flush() writes the dirty registers in ascending order
+ * and combines consecutive registers into one call of the writer.
+ * @ingroup audio_driver
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+template <int Count, int Width = 8>
+class RegisterMap {
+ public:
+  typedef typename RegisterMapValue<(Width > 8)>::type value_t;
+
+  /// Defines the reset values: the map is set to these values
+  void setDefaults(const value_t *defaults) {
+    p_defaults = defaults;
+    reset();
+  }
+
+  /// The chip has been reset: we restore the reset values if we know them
+  void reset() {
+    memset(dirty, 0, sizeof(dirty));
+    if (p_defaults != nullptr) {
+      for (int j = 0; j < Count; j++) values[j] = p_defaults[j] & mask();
+      memset(valid, 0xFF, sizeof(valid));
+    } else {
+      memset(valid, 0, sizeof(valid));
+    }
+  }
+
+  /// Forgets all values: e.g. if the chip state is unknown
+  void invalidate() {
+    memset(valid, 0, sizeof(valid));
+    memset(dirty, 0, sizeof(dirty));
+  }
+
+  /// Forgets the value of a single register: e.g. after a failed write
+  void forget(int reg) {
+    if (!isRange(reg)) return;
+    setBit(valid, reg, false);
+    setBit(dirty, reg, false);
+  }
+
+  /// Marks all valid registers as dirty, so that they are written again
+  void markAllDirty() {
+    for (int j = 0; j < Count; j++) {
+      if (getBit(valid, j)) setBit(dirty, j, true);
+    }
+  }
+
+  /// Defines a register which can change on the chip
+  void setVolatile(int reg, bool isVolatile = true) {
+    if (isRange(reg)) setBit(volatile_bits, reg, isVolatile);
+  }
+
+  bool isVolatile(int reg) { return isRange(reg) && getBit(volatile_bits, reg); }
+  /// Returns true if the value can be taken from the map
+  bool isValid(int reg) {
+    return isRange(reg) && getBit(valid, reg) && !getBit(volatile_bits, reg);
+  }
+  bool isDirty(int reg) { return isRange(reg) && getBit(dirty, reg); }
+
+  /// Provides the cached value
+  value_t get(int reg) { return isRange(reg) ? values[reg] : 0; }
+
+  /// Updates the value: the register becomes dirty if the value changes (or
+  /// if it is unknown or volatile). Returns true if it needs to be written.
+  bool set(int reg, value_t value) {
+    if (!isRange(reg)) return false;
+    value &= mask();
+    if (isValid(reg) && values[reg] == value && !isDirty(reg)) return false;
+    values[reg] = value;
+    setBit(valid, reg, true);
+    setBit(dirty, reg, true);
+    return true;
+  }
+
+  /// Read-modify-write of the bits in mask on the cached value
+  bool update(int reg, value_t bitMask, value_t value) {
+    return set(reg, (get(reg) & ~bitMask) | (value & bitMask));
+  }
+
+  /// Records a value which has been read from or written to the chip
+  void store(int reg, value_t value) {
+    if (!isRange(reg)) return;
+    values[reg] = value & mask();
+    setBit(valid, reg, true);
+    setBit(dirty, reg, false);
+  }
+
+  /// Number of registers which need to be written
+  int dirtyCount() {
+    int result = 0;
+    for (int j = 0; j < Count; j++) {
+      if (getBit(dirty, j)) result++;
+    }
+    return result;
+  }
+
+  /// Writes all dirty registers: writer(reg, values, count) is called for
+  /// each run of max maxBurst consecutive dirty registers and returns true if
+  /// the values were written
+  template <class F>
+  bool flush(F writer, int maxBurst = Count) {
+    bool result = true;
+    int reg = 0;
+    while (reg < Count) {
+      if (!getBit(dirty, reg)) {
+        reg++;
+        continue;
+      }
+      int len = 1;
+      while (reg + len < Count && len < maxBurst && getBit(dirty, reg + len))
+        len++;
+      if (writer(reg, &values[reg], len)) {
+        for (int j = 0; j < len; j++) setBit(dirty, reg + j, false);
+      } else {
+        result = false;
+      }
+      reg += len;
+    }
+    return result;
+  }
+
+  /// Number of registers
+  int size() { return Count; }
+
+ protected:
+  value_t values[Count] = {0};
+  uint8_t valid[(Count + 7) / 8] = {0};
+  uint8_t dirty[(Count + 7) / 8] = {0};
+  uint8_t volatile_bits[(Count + 7) / 8] = {0};
+  const value_t *p_defaults = nullptr;
+
+  static constexpr value_t mask() {
+    return (value_t)((1ul << Width) - 1);
+  }
+  static bool isRange(int reg) { return reg >= 0 && reg < Count; }
+  static bool getBit(const uint8_t *bits, int idx) {
+    return bits[idx >> 3] & (1 << (idx & 7));
+  }
+  static void setBit(uint8_t *bits, int idx, bool value) {
+    if (value)
+      bits[idx >> 3] |= (1 << (idx & 7));
+    else
+      bits[idx >> 3] &= ~(1 << (idx & 7));
+  }
+};
+
+}  // namespace audio_driver
@@ -0,0 +1,18 @@
+# Generates the optimized TAS5805M register table from the results of the
+# reg_optimizer builds for the supported board variants
+execute_process(COMMAND ${OPTIMIZER_DEFAULT} ${MAX_BURST}
+                OUTPUT_VARIABLE TABLE_DEFAULT RESULT_VARIABLE RC1)
+execute_process(COMMAND ${OPTIMIZER_KORVO} ${MAX_BURST}
+                OUTPUT_VARIABLE TABLE_KORVO RESULT_VARIABLE RC2)
+if (NOT RC1 EQUAL 0 OR NOT RC2 EQUAL 0)
+  message(FATAL_ERROR "reg_optimizer failed")
+endif()
+file(WRITE ${OUTPUT}
+"// Generated from tas5805m_reg_cfg.h by tools/reg_optimizer: do not edit!
+// Regenerate with: cmake --build <build-dir> --target tas5805m_reg_cfg
+#pragma once
+
+#if CONFIG_ESP32_KORVO_DU1906_BOARD
+${TABLE_KORVO}#else
+${TABLE_DEFAULT}#endif
+")
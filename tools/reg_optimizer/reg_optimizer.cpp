@@ -0,0 +1,181 @@
+/**
+ * @brief Host tool which optimizes a register script in the format of
+ * tas5805m_reg_cfg.h and prints the optimized table:
+ * - page and book selections which do not change the page or book are removed
+ * - coefficient writes which are overwritten before the next delay are removed
+ * - writes to consecutive registers are merged into CFG_META_BURST records
+ *
+ * The script is included with REG_SCRIPT_HEADER and REG_SCRIPT_TABLE, so the
+ * preprocessor conditions of the vendor dump are evaluated with the defines
+ * of the tool build. Usage: reg_optimizer [max burst length]
+ *
+ * @author Phil Schatzmann
+ * @copyright GPLv3
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include REG_SCRIPT_HEADER
+
+#define STR(x) #x
+#define XSTR(x) STR(x)
+
+static const int page_reg = 0x00;
+static const int book_reg = 0x7F;
+static const int reset_reg = 0x01;
+
+struct Op {
+  bool is_delay;
+  uint8_t reg;
+  uint8_t value;
+  int book;  // -1: unknown
+  int page;  // -1: unknown
+  bool removed;
+};
+
+static bool isSelect(const Op &op) {
+  return op.reg == page_reg || (op.page == 0 && op.reg == book_reg);
+}
+
+/// Control registers (book 0, page 0) can have side effects: we keep all
+/// writes to them
+static bool isControl(const Op &op) { return op.book <= 0 && op.page <= 0; }
+
+/// Expands the script into single writes and delays
+static std::vector<Op> expand(const tas5805m_cfg_reg_t *script, int count) {
+  std::vector<Op> result;
+  int j = 0;
+  while (j < count) {
+    uint8_t offset = script[j].offset;
+    if (offset == CFG_META_SWITCH) {
+      j++;
+    } else if (offset == CFG_META_DELAY) {
+      result.push_back({true, 0, script[j].value, -1, -1, false});
+      j++;
+    } else if (offset == CFG_META_BURST) {
+      const uint8_t *bytes = &script[j + 1].offset;
+      int len = script[j].value;
+      for (int k = 0; k < len; k++) {
+        result.push_back({false, (uint8_t)(bytes[0] + k), bytes[k + 1], -1, -1,
+                          false});
+      }
+      j += len / 2 + 2;
+    } else {
+      result.push_back({false, offset, script[j].value, -1, -1, false});
+      j++;
+    }
+  }
+  return result;
+}
+
+/// Determines the book and page of each write and removes the selections
+/// which do not change anything
+static void trackPages(std::vector<Op> &ops) {
+  int book = -1, page = -1;
+  for (auto &op : ops) {
+    if (op.is_delay) continue;
+    op.book = book;
+    op.page = page;
+    if (op.reg == page_reg) {
+      if (page == op.value) op.removed = true;
+      page = op.value;
+    } else if (page == 0 && op.reg == book_reg) {
+      if (book == op.value) op.removed = true;
+      book = op.value;
+    } else if (book == 0 && page == 0 && op.reg == reset_reg) {
+      // a reset can change the selection
+      book = page = -1;
+    }
+  }
+}
+
+/// Removes the coefficient writes which are overwritten before the next delay
+static void removeOverwritten(std::vector<Op> &ops) {
+  for (size_t j = 0; j < ops.size(); j++) {
+    Op &op = ops[j];
+    if (op.is_delay || op.removed || isSelect(op) || isControl(op)) continue;
+    if (op.book < 0 || op.page < 0) continue;
+    for (size_t k = j + 1; k < ops.size(); k++) {
+      Op &next = ops[k];
+      if (next.is_delay) break;
+      if (!next.removed && next.book == op.book && next.page == op.page &&
+          next.reg == op.reg) {
+        op.removed = true;
+        break;
+      }
+    }
+  }
+}
+
+/// Prints the remaining writes: consecutive registers become bursts
+static int print(const std::vector<Op> &ops, int maxBurst) {
+  int entries = 0;
+  size_t j = 0;
+  while (j < ops.size()) {
+    const Op &op = ops[j];
+    if (op.removed) {
+      j++;
+      continue;
+    }
+    if (op.is_delay) {
+      printf("    { CFG_META_DELAY, %d },\n", op.value);
+      entries++;
+      j++;
+      continue;
+    }
+    // collect the run of consecutive registers
+    std::vector<const Op *> run{&op};
+    size_t k = j + 1;
+    while (k < ops.size() && (int)run.size() < maxBurst && !isSelect(op) &&
+           !isControl(op)) {
+      const Op &next = ops[k];
+      if (next.removed) {
+        k++;
+        continue;
+      }
+      if (next.is_delay || isSelect(next) || next.book != op.book ||
+          next.page != op.page || next.reg != run.back()->reg + 1)
+        break;
+      run.push_back(&next);
+      k++;
+    }
+    if (run.size() == 1) {
+      printf("    { 0x%02x, 0x%02x },\n", op.reg, op.value);
+      entries++;
+    } else {
+      // register address followed by the data bytes, padded to full entries
+      std::vector<uint8_t> bytes{op.reg};
+      for (auto p_op : run) bytes.push_back(p_op->value);
+      if (bytes.size() % 2) bytes.push_back(0);
+      printf("    { CFG_META_BURST, %d },", (int)run.size());
+      for (size_t b = 0; b < bytes.size(); b += 2) {
+        printf(" { 0x%02x, 0x%02x },", bytes[b], bytes[b + 1]);
+      }
+      printf("\n");
+      entries += 1 + bytes.size() / 2;
+    }
+    j = k;
+  }
+  return entries;
+}
+
+int main(int argc, char **argv) {
+  int max_burst = argc > 1 ? atoi(argv[1]) : 16;
+  int count = sizeof(REG_SCRIPT_TABLE) / sizeof(REG_SCRIPT_TABLE[0]);
+  std::vector<Op> ops = expand(REG_SCRIPT_TABLE, count);
+  trackPages(ops);
+  removeOverwritten(ops);
+  int writes = 0;
+  for (auto &op : ops) {
+    if (!op.is_delay && !op.removed) writes++;
+  }
+  printf("static const tas5805m_cfg_reg_t %s[] = {\n", XSTR(REG_SCRIPT_TABLE));
+  int entries = print(ops, max_burst);
+  printf("};\n");
+  fprintf(stderr, "%s: %d entries -> %d entries, %d register writes\n",
+          XSTR(REG_SCRIPT_TABLE), count, entries, writes);
+  return 0;
+}